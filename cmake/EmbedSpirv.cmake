@@ -0,0 +1,26 @@
+# Turns a SPIR-V binary into a header with a constexpr uint32_t array.
+# Usage: cmake -DINPUT=<file.spv> -DOUTPUT=<file.hpp> -DSYMBOL=<name> -P EmbedSpirv.cmake
+
+file(READ ${INPUT} SPIRV_HEX HEX)
+string(LENGTH "${SPIRV_HEX}" SPIRV_HEX_LENGTH)
+math(EXPR SPIRV_WORD_REMAINDER "${SPIRV_HEX_LENGTH} % 8")
+
+if (SPIRV_HEX_LENGTH EQUAL 0 OR NOT SPIRV_WORD_REMAINDER EQUAL 0)
+    message(FATAL_ERROR "${INPUT} is not a valid SPIR-V module")
+endif()
+
+# SPIR-V is a stream of little-endian 32-bit words, byte-swap every group of four bytes into one literal
+string(REGEX REPLACE "(..)(..)(..)(..)" "0x\\4\\3\\2\\1," SPIRV_WORDS "${SPIRV_HEX}")
+string(REGEX REPLACE "(0x........,0x........,0x........,0x........,0x........,0x........,0x........,0x........,)" "\\1\n        " SPIRV_WORDS "${SPIRV_WORDS}")
+
+file(WRITE ${OUTPUT}
+"// Generated from ${INPUT}, do not edit.
+#pragma once
+#include <cstdint>
+
+namespace Shaders {
+    inline constexpr uint32_t ${SYMBOL}[] = {
+        ${SPIRV_WORDS}
+    };
+}
+")
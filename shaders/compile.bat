@@ -1,3 +0,0 @@
-C:/VulkanSDK/1.4.313.2/Bin/glslc.exe vertexShader.vert -o vert.spv
-C:/VulkanSDK/1.4.313.2/Bin/glslc.exe fragmentShader.frag -o frag.spv
-pause
\ No newline at end of file
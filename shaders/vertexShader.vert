@@ -1,20 +1,48 @@
 #version 450
 
+struct Instance {
+    vec2 offset;
+    float scale;
+    float rotation;
+    vec4 color;
+};
+
+// Storage buffer array of the bindless table, see BindlessTable::STORAGE_BUFFER_CAPACITY. Both declarations alias
+// the same binding, the handles in the push constants pick the element
+#define BINDLESS_STORAGE_BUFFERS 64
+
+layout(std430, set = 0, binding = 0) readonly buffer Instances {
+    Instance instances[];
+} instanceBuffers[BINDLESS_STORAGE_BUFFERS];
+
+// Culling output, or an identity list when GPU culling is off
+layout(std430, set = 0, binding = 0) readonly buffer DrawnInstances {
+    uint drawnInstances[];
+} drawnInstanceBuffers[BINDLESS_STORAGE_BUFFERS];
+
+layout(push_constant) uniform DrawConstants {
+    vec2 position;
+    float zoom;
+    float padding;
+    uint instanceBuffer;
+    uint drawnInstanceBuffer;
+} draw;
+
+layout(location = 0) in vec2 inPosition;
+layout(location = 1) in vec3 inColor;
+
 layout(location = 0) out vec3 vColor;
 
 void main() {
-    vec2 pos[3] = vec2[](
-        vec2( 0.0, -0.5),
-        vec2( 0.5,  0.5),
-        vec2(-0.5,  0.5)
-    );
-
-    vec3 col[3] = vec3[](
-        vec3(1, 0, 0),
-        vec3(0, 1, 0),
-        vec3(0, 0, 1)
-    );
-
-    gl_Position = vec4(pos[gl_VertexIndex], 0.0, 1.0);
-    vColor = col[gl_VertexIndex];
+    uint drawnInstance = drawnInstanceBuffers[draw.drawnInstanceBuffer].drawnInstances[gl_InstanceIndex];
+    Instance instance = instanceBuffers[draw.instanceBuffer].instances[drawnInstance];
+
+    float s = sin(instance.rotation);
+    float c = cos(instance.rotation);
+    vec2 position = mat2(c, s, -s, c) * inPosition * instance.scale + instance.offset;
+
+    // Depth follows the instance index, so overlaps resolve the same whatever order the culling pass emitted them in
+    float depth = 1.0 - float(drawnInstance + 1) / float(instanceBuffers[draw.instanceBuffer].instances.length() + 1);
+    gl_Position = vec4((position - draw.position) * draw.zoom, depth, 1.0);
+    vColor = inColor * instance.color.rgb;
 }
@@ -0,0 +1,307 @@
+#include "allocator.hpp"
+namespace Graphics {
+
+    static VkDeviceSize alignUp(VkDeviceSize value, VkDeviceSize alignment) {
+        return (value + alignment - 1) & ~(alignment - 1);
+    }
+
+    Allocator::Allocator(VkPhysicalDevice physicalDevice, VkDevice device, VkDeviceSize preferredBlockSize) : vk_logicalDevice(device), preferredBlockSize(preferredBlockSize) {
+        vkGetPhysicalDeviceMemoryProperties(physicalDevice, &vk_memoryProperties);
+
+        VkPhysicalDeviceProperties properties;
+        vkGetPhysicalDeviceProperties(physicalDevice, &properties);
+        bufferImageGranularity = properties.limits.bufferImageGranularity;
+        nonCoherentAtomSize = std::max<VkDeviceSize>(properties.limits.nonCoherentAtomSize, 1);
+    }
+
+//------------------------------CREATE BUFFER------------------------------
+    BufferAllocation Allocator::createBuffer(const VkBufferCreateInfo& bufferInfo, VkMemoryPropertyFlags properties, AllocationStrategy strategy) {
+        BufferAllocation buffer;
+        if (vkCreateBuffer(vk_logicalDevice, &bufferInfo, nullptr, &buffer.buffer) != VK_SUCCESS) throw std::runtime_error("failed to create buffer!");
+
+        VkMemoryRequirements requirements;
+        vkGetBufferMemoryRequirements(vk_logicalDevice, buffer.buffer, &requirements);
+
+        try {
+            buffer.allocation = allocate(requirements, properties, ResourceKind::Linear, strategy);
+        } catch (...) {
+            vkDestroyBuffer(vk_logicalDevice, buffer.buffer, nullptr);
+            throw;
+        }
+
+        vkBindBufferMemory(vk_logicalDevice, buffer.buffer, buffer.allocation.memory, buffer.allocation.offset);
+        return buffer;
+    }
+
+//------------------------------CREATE IMAGE------------------------------
+    ImageAllocation Allocator::createImage(const VkImageCreateInfo& imageInfo, VkMemoryPropertyFlags properties, AllocationStrategy strategy) {
+        ImageAllocation image;
+        if (vkCreateImage(vk_logicalDevice, &imageInfo, nullptr, &image.image) != VK_SUCCESS) throw std::runtime_error("failed to create image!");
+
+        VkMemoryRequirements requirements;
+        vkGetImageMemoryRequirements(vk_logicalDevice, image.image, &requirements);
+
+        ResourceKind kind = imageInfo.tiling == VK_IMAGE_TILING_OPTIMAL ? ResourceKind::Optimal : ResourceKind::Linear;
+        try {
+            image.allocation = allocate(requirements, properties, kind, strategy);
+        } catch (...) {
+            vkDestroyImage(vk_logicalDevice, image.image, nullptr);
+            throw;
+        }
+
+        vkBindImageMemory(vk_logicalDevice, image.image, image.allocation.memory, image.allocation.offset);
+        return image;
+    }
+
+//------------------------------DESTROY RESOURCES------------------------------
+    void Allocator::destroyBuffer(BufferAllocation& buffer) {
+        if (buffer.buffer == VK_NULL_HANDLE) return;
+        vkDestroyBuffer(vk_logicalDevice, buffer.buffer, nullptr);
+        free(buffer.allocation);
+        buffer = {};
+    }
+
+    void Allocator::destroyImage(ImageAllocation& image) {
+        if (image.image == VK_NULL_HANDLE) return;
+        vkDestroyImage(vk_logicalDevice, image.image, nullptr);
+        free(image.allocation);
+        image = {};
+    }
+
+    Allocation Allocator::allocateImageMemory(const VkMemoryRequirements& requirements, VkMemoryPropertyFlags properties, AllocationStrategy strategy) {
+        return allocate(requirements, properties, ResourceKind::Optimal, strategy);
+    }
+
+    void Allocator::freeMemory(Allocation& allocation) {
+        if (allocation.memory == VK_NULL_HANDLE) return;
+        free(allocation);
+        allocation = {};
+    }
+
+    bool Allocator::supportsMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties) const {
+        for (uint32_t i = 0; i < vk_memoryProperties.memoryTypeCount; i++) {
+            if ((typeFilter & (1 << i)) && (vk_memoryProperties.memoryTypes[i].propertyFlags & properties) == properties) return true;
+        }
+        return false;
+    }
+
+//------------------------------ALLOCATE------------------------------
+    Allocation Allocator::allocate(const VkMemoryRequirements& requirements, VkMemoryPropertyFlags properties, ResourceKind kind, AllocationStrategy strategy) {
+        std::lock_guard<std::mutex> lock(mutex);
+
+        Allocation allocation;
+        allocation.memoryTypeIndex = findMemoryType(requirements.memoryTypeBits, properties);
+        const VkMemoryPropertyFlags typeFlags = vk_memoryProperties.memoryTypes[allocation.memoryTypeIndex].propertyFlags;
+
+        // Non-coherent mappings are flushed in nonCoherentAtomSize units, keep neighbours out of each other's atoms
+        VkDeviceSize alignment = std::max<VkDeviceSize>(requirements.alignment, 1);
+        VkDeviceSize size = requirements.size;
+        if ((typeFlags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT) && !(typeFlags & VK_MEMORY_PROPERTY_HOST_COHERENT_BIT)) {
+            alignment = std::max(alignment, nonCoherentAtomSize);
+            size = alignUp(size, nonCoherentAtomSize);
+        }
+
+        // With a granularity of 1 buffers and optimal images can never alias a page, so they may share blocks
+        if (bufferImageGranularity <= 1) kind = ResourceKind::Linear;
+
+        uint32_t poolIndex = findPool(allocation.memoryTypeIndex, strategy, kind);
+        if (strategy == AllocationStrategy::Dedicated || size > pools[poolIndex].blockSize / 2) {
+            allocation.strategy = AllocationStrategy::Dedicated;
+            allocation.memory = allocateDeviceMemory(allocation.memoryTypeIndex, size, &allocation.mapped);
+            allocation.size = size;
+
+            stats.allocationCount++;
+            stats.usedBytes += size;
+            return allocation;
+        }
+
+        Pool& pool = pools[poolIndex];
+        allocation.strategy = strategy;
+        allocation.poolIndex = poolIndex;
+        allocation.order = orderFor(std::max(size, alignment));
+        allocation.size = strategy == AllocationStrategy::General ? VkDeviceSize(1) << allocation.order : size;
+
+        bool found = false;
+        for (uint32_t i = 0; i < pool.blocks.size() && !found; i++) {
+            Block& block = *pool.blocks[i];
+            found = strategy == AllocationStrategy::General ? allocateBuddy(block, allocation.order, allocation.offset) : allocateLinear(block, size, alignment, allocation.offset);
+            if (found) allocation.blockIndex = i;
+        }
+
+        if (!found) {
+            Block& block = createBlock(pool);
+            allocation.blockIndex = static_cast<uint32_t>(pool.blocks.size() - 1);
+            found = strategy == AllocationStrategy::General ? allocateBuddy(block, allocation.order, allocation.offset) : allocateLinear(block, size, alignment, allocation.offset);
+            if (!found) throw std::runtime_error("failed to sub-allocate from a fresh memory block!");
+        }
+
+        Block& block = *pool.blocks[allocation.blockIndex];
+        block.liveAllocations++;
+        allocation.memory = block.memory;
+        allocation.mapped = block.mapped ? static_cast<char*>(block.mapped) + allocation.offset : nullptr;
+
+        stats.allocationCount++;
+        stats.usedBytes += allocation.size;
+        return allocation;
+    }
+
+//------------------------------FREE------------------------------
+    void Allocator::free(const Allocation& allocation) {
+        std::lock_guard<std::mutex> lock(mutex);
+
+        stats.allocationCount--;
+        stats.usedBytes -= allocation.size;
+
+        if (allocation.strategy == AllocationStrategy::Dedicated) {
+            vkFreeMemory(vk_logicalDevice, allocation.memory, nullptr);
+            stats.deviceMemoryCount--;
+            stats.reservedBytes -= allocation.size;
+            return;
+        }
+
+        Block& block = *pools[allocation.poolIndex].blocks[allocation.blockIndex];
+        block.liveAllocations--;
+
+        if (allocation.strategy == AllocationStrategy::General) freeBuddy(block, allocation.offset, allocation.order);
+        else if (!block.liveAllocations) block.linearOffset = 0;
+    }
+
+//------------------------------FLUSH------------------------------
+    void Allocator::flush(const Allocation& allocation) {
+        const VkMemoryPropertyFlags typeFlags = vk_memoryProperties.memoryTypes[allocation.memoryTypeIndex].propertyFlags;
+        if (!(typeFlags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT) || (typeFlags & VK_MEMORY_PROPERTY_HOST_COHERENT_BIT)) return;
+
+        VkMappedMemoryRange range{};
+        range.sType = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE;
+        range.memory = allocation.memory;
+        range.offset = allocation.offset;
+        range.size = allocation.size;
+        vkFlushMappedMemoryRanges(vk_logicalDevice, 1, &range);
+    }
+
+//------------------------------STATS------------------------------
+    AllocatorStats Allocator::getStats() {
+        std::lock_guard<std::mutex> lock(mutex);
+        return stats;
+    }
+
+//------------------------------POOLS AND BLOCKS------------------------------
+    uint32_t Allocator::findPool(uint32_t memoryTypeIndex, AllocationStrategy strategy, ResourceKind kind) {
+        if (strategy == AllocationStrategy::Dedicated) strategy = AllocationStrategy::General;
+
+        for (uint32_t i = 0; i < pools.size(); i++) {
+            if (pools[i].memoryTypeIndex == memoryTypeIndex && pools[i].strategy == strategy && pools[i].kind == kind) return i;
+        }
+
+        // Small heaps (BAR, integrated carve-outs) get smaller blocks so a few pools can't exhaust them
+        VkDeviceSize heapSize = vk_memoryProperties.memoryHeaps[vk_memoryProperties.memoryTypes[memoryTypeIndex].heapIndex].size;
+        VkDeviceSize targetSize = std::max<VkDeviceSize>(1024 * 1024, std::min(preferredBlockSize, heapSize / 8));
+        VkDeviceSize blockSize = VkDeviceSize(1) << MIN_ORDER;
+        while (blockSize * 2 <= targetSize) blockSize *= 2;
+
+        pools.push_back({memoryTypeIndex, strategy, kind, blockSize, {}});
+        return static_cast<uint32_t>(pools.size() - 1);
+    }
+
+    Allocator::Block& Allocator::createBlock(Pool& pool) {
+        auto block = std::make_unique<Block>();
+        block->size = pool.blockSize;
+        block->memory = allocateDeviceMemory(pool.memoryTypeIndex, pool.blockSize, &block->mapped);
+
+        if (pool.strategy == AllocationStrategy::General) {
+            uint32_t maxOrder = orderFor(pool.blockSize);
+            block->freeLists.resize(maxOrder + 1);
+            block->freeLists[maxOrder].insert(0);
+        }
+
+        pool.blocks.push_back(std::move(block));
+        return *pool.blocks.back();
+    }
+
+    VkDeviceMemory Allocator::allocateDeviceMemory(uint32_t memoryTypeIndex, VkDeviceSize size, void** mapped) {
+        VkMemoryAllocateInfo allocInfo{};
+        allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+        allocInfo.allocationSize = size;
+        allocInfo.memoryTypeIndex = memoryTypeIndex;
+
+        VkDeviceMemory memory;
+        if (vkAllocateMemory(vk_logicalDevice, &allocInfo, nullptr, &memory) != VK_SUCCESS) throw std::runtime_error("failed to allocate device memory!");
+
+        // Host-visible memory stays mapped for its whole lifetime, callers write through Allocation::mapped
+        *mapped = nullptr;
+        if (vk_memoryProperties.memoryTypes[memoryTypeIndex].propertyFlags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT) {
+            if (vkMapMemory(vk_logicalDevice, memory, 0, VK_WHOLE_SIZE, 0, mapped) != VK_SUCCESS) {
+                vkFreeMemory(vk_logicalDevice, memory, nullptr);
+                throw std::runtime_error("failed to map device memory!");
+            }
+        }
+
+        stats.deviceMemoryCount++;
+        stats.reservedBytes += size;
+        return memory;
+    }
+
+//------------------------------BUDDY------------------------------
+    bool Allocator::allocateBuddy(Block& block, uint32_t order, VkDeviceSize& offset) {
+        uint32_t available = order;
+        while (available < block.freeLists.size() && block.freeLists[available].empty()) available++;
+        if (available >= block.freeLists.size()) return false;
+
+        offset = *block.freeLists[available].begin();
+        block.freeLists[available].erase(block.freeLists[available].begin());
+
+        // Split down to the requested size, the upper halves become free buddies
+        while (available > order) {
+            available--;
+            block.freeLists[available].insert(offset + (VkDeviceSize(1) << available));
+        }
+        return true;
+    }
+
+    void Allocator::freeBuddy(Block& block, VkDeviceSize offset, uint32_t order) {
+        const uint32_t maxOrder = static_cast<uint32_t>(block.freeLists.size() - 1);
+
+        while (order < maxOrder) {
+            VkDeviceSize buddy = offset ^ (VkDeviceSize(1) << order);
+            auto it = block.freeLists[order].find(buddy);
+            if (it == block.freeLists[order].end()) break;
+
+            block.freeLists[order].erase(it);
+            offset = std::min(offset, buddy);
+            order++;
+        }
+        block.freeLists[order].insert(offset);
+    }
+
+//------------------------------LINEAR------------------------------
+    bool Allocator::allocateLinear(Block& block, VkDeviceSize size, VkDeviceSize alignment, VkDeviceSize& offset) {
+        VkDeviceSize alignedOffset = alignUp(block.linearOffset, alignment);
+        if (alignedOffset + size > block.size) return false;
+
+        offset = alignedOffset;
+        block.linearOffset = alignedOffset + size;
+        return true;
+    }
+
+    uint32_t Allocator::orderFor(VkDeviceSize size) {
+        uint32_t order = MIN_ORDER;
+        while ((VkDeviceSize(1) << order) < size) order++;
+        return order;
+    }
+
+//------------------------------FIND MEMORY TYPE------------------------------
+    uint32_t Allocator::findMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties) {
+        for (uint32_t i = 0; i < vk_memoryProperties.memoryTypeCount; i++) {
+            if ((typeFilter & (1 << i)) && (vk_memoryProperties.memoryTypes[i].propertyFlags & properties) == properties) return i;
+        }
+
+        throw std::runtime_error("failed to find suitable memory type!");
+    }
+
+//------------------------------DESTROY------------------------------
+    Allocator::~Allocator() {
+        for (auto& pool : pools) {
+            for (auto& block : pool.blocks) vkFreeMemory(vk_logicalDevice, block->memory, nullptr);
+        }
+    }
+}
@@ -0,0 +1,117 @@
+#pragma once
+
+#include "../includes/graphics.hpp"
+#include <stdexcept>
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <vector>
+
+namespace Graphics {
+
+    // General: power-of-two buddy sub-allocation, for long-lived resources that are freed in any order
+    // Linear: bump allocation, the block rewinds once every allocation in it is freed (staging, per-frame data)
+    // Dedicated is picked automatically for requests that don't fit in a block
+    enum class AllocationStrategy {
+        General,
+        Linear,
+        Dedicated
+    };
+
+    struct Allocation {
+        VkDeviceMemory memory = VK_NULL_HANDLE;
+        VkDeviceSize offset = 0;
+        VkDeviceSize size = 0;
+        void* mapped = nullptr;
+        AllocationStrategy strategy = AllocationStrategy::General;
+        uint32_t memoryTypeIndex = 0;
+        uint32_t poolIndex = 0;
+        uint32_t blockIndex = 0;
+        uint32_t order = 0;
+    };
+
+    struct BufferAllocation {
+        VkBuffer buffer = VK_NULL_HANDLE;
+        Allocation allocation;
+    };
+
+    struct ImageAllocation {
+        VkImage image = VK_NULL_HANDLE;
+        Allocation allocation;
+    };
+
+    struct AllocatorStats {
+        uint32_t deviceMemoryCount = 0;
+        uint32_t allocationCount = 0;
+        VkDeviceSize reservedBytes = 0;
+        VkDeviceSize usedBytes = 0;
+    };
+
+    class Allocator {
+
+        public:
+            Allocator(VkPhysicalDevice physicalDevice, VkDevice device, VkDeviceSize preferredBlockSize = 64ull * 1024 * 1024);
+            ~Allocator();
+            Allocator(const Allocator&) = delete;
+            Allocator& operator=(const Allocator&) = delete;
+
+            BufferAllocation createBuffer(const VkBufferCreateInfo& bufferInfo, VkMemoryPropertyFlags properties, AllocationStrategy strategy = AllocationStrategy::General);
+            ImageAllocation createImage(const VkImageCreateInfo& imageInfo, VkMemoryPropertyFlags properties, AllocationStrategy strategy = AllocationStrategy::General);
+            void destroyBuffer(BufferAllocation& buffer);
+            void destroyImage(ImageAllocation& image);
+            // Memory for images the caller creates and binds itself, e.g. several transient images aliasing one range
+            Allocation allocateImageMemory(const VkMemoryRequirements& requirements, VkMemoryPropertyFlags properties, AllocationStrategy strategy = AllocationStrategy::General);
+            void freeMemory(Allocation& allocation);
+            bool supportsMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties) const;
+            void flush(const Allocation& allocation);
+            AllocatorStats getStats();
+
+        private:
+            // Buffers and optimal-tiling images only share blocks when bufferImageGranularity can't make them alias
+            enum class ResourceKind {
+                Linear,
+                Optimal
+            };
+
+            struct Block {
+                VkDeviceMemory memory = VK_NULL_HANDLE;
+                VkDeviceSize size = 0;
+                void* mapped = nullptr;
+                uint32_t liveAllocations = 0;
+                VkDeviceSize linearOffset = 0;
+                std::vector<std::set<VkDeviceSize>> freeLists;
+            };
+
+            struct Pool {
+                uint32_t memoryTypeIndex;
+                AllocationStrategy strategy;
+                ResourceKind kind;
+                VkDeviceSize blockSize;
+                std::vector<std::unique_ptr<Block>> blocks;
+            };
+
+            static constexpr uint32_t MIN_ORDER = 8;
+
+            VkDevice vk_logicalDevice;
+            VkPhysicalDeviceMemoryProperties vk_memoryProperties;
+            VkDeviceSize bufferImageGranularity;
+            VkDeviceSize nonCoherentAtomSize;
+            VkDeviceSize preferredBlockSize;
+            std::vector<Pool> pools;
+            std::mutex mutex;
+            AllocatorStats stats;
+
+            Allocation allocate(const VkMemoryRequirements& requirements, VkMemoryPropertyFlags properties, ResourceKind kind, AllocationStrategy strategy);
+            void free(const Allocation& allocation);
+            uint32_t findMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties);
+            uint32_t findPool(uint32_t memoryTypeIndex, AllocationStrategy strategy, ResourceKind kind);
+            Block& createBlock(Pool& pool);
+            VkDeviceMemory allocateDeviceMemory(uint32_t memoryTypeIndex, VkDeviceSize size, void** mapped);
+            bool allocateBuddy(Block& block, uint32_t order, VkDeviceSize& offset);
+            void freeBuddy(Block& block, VkDeviceSize offset, uint32_t order);
+            bool allocateLinear(Block& block, VkDeviceSize size, VkDeviceSize alignment, VkDeviceSize& offset);
+            static uint32_t orderFor(VkDeviceSize size);
+    };
+}
@@ -0,0 +1,209 @@
+#include "assetPack.hpp"
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace Graphics {
+
+    static uint64_t alignUp(uint64_t value, uint64_t alignment) {
+        return (value + alignment - 1) & ~(alignment - 1);
+    }
+
+//------------------------------WRITE PACK------------------------------
+    void writeAssetPack(const std::filesystem::path& path, const std::vector<AssetPackSource>& sources) {
+        std::string strings;
+        std::vector<AssetPackEntry> entries(sources.size());
+        for (size_t i = 0; i < sources.size(); i++) {
+            if (std::find_if(sources.begin(), sources.begin() + i, [&](const AssetPackSource& other) { return other.name == sources[i].name; }) != sources.begin() + i) {
+                throw std::runtime_error("duplicate asset name " + sources[i].name + "!");
+            }
+            entries[i].nameOffset = static_cast<uint32_t>(strings.size());
+            entries[i].nameLength = static_cast<uint32_t>(sources[i].name.size());
+            entries[i].type = sources[i].type;
+            entries[i].reserved = 0;
+            strings += sources[i].name;
+        }
+
+        AssetPackHeader header{};
+        std::memcpy(header.magic, ASSET_PACK_MAGIC, sizeof(header.magic));
+        header.version = ASSET_PACK_VERSION;
+        header.entryCount = static_cast<uint32_t>(entries.size());
+        header.stringTableOffset = sizeof(AssetPackHeader) + entries.size() * sizeof(AssetPackEntry);
+        header.stringTableSize = strings.size();
+
+        uint64_t offset = header.stringTableOffset + header.stringTableSize;
+        for (size_t i = 0; i < sources.size(); i++) {
+            offset = alignUp(offset, ASSET_PACK_ALIGNMENT);
+            entries[i].offset = offset;
+            entries[i].size = std::filesystem::file_size(sources[i].path);
+            offset += entries[i].size;
+        }
+
+        // Same as the pipeline cache: write next to the target and rename, a failed pack never replaces a good one
+        std::filesystem::path tempPath = path;
+        tempPath += ".tmp";
+        {
+            std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+            if (!file.is_open()) throw std::runtime_error("failed to open " + tempPath.string() + "!");
+
+            file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+            file.write(reinterpret_cast<const char*>(entries.data()), entries.size() * sizeof(AssetPackEntry));
+            file.write(strings.data(), strings.size());
+
+            std::vector<char> chunk(1 << 20);
+            for (size_t i = 0; i < sources.size(); i++) {
+                const uint64_t padding = entries[i].offset - static_cast<uint64_t>(file.tellp());
+                std::fill_n(chunk.begin(), padding, '\0');
+                file.write(chunk.data(), padding);
+
+                std::ifstream input(sources[i].path, std::ios::binary);
+                if (!input.is_open()) throw std::runtime_error("failed to open " + sources[i].path.string() + "!");
+                uint64_t remaining = entries[i].size;
+                while (remaining > 0) {
+                    const std::streamsize count = static_cast<std::streamsize>(std::min<uint64_t>(remaining, chunk.size()));
+                    if (!input.read(chunk.data(), count)) throw std::runtime_error("failed to read " + sources[i].path.string() + "!");
+                    file.write(chunk.data(), count);
+                    remaining -= count;
+                }
+            }
+            if (!file) throw std::runtime_error("failed to write " + tempPath.string() + "!");
+        }
+        std::filesystem::rename(tempPath, path);
+    }
+
+//------------------------------OPEN PACK------------------------------
+    AssetPack::AssetPack(const std::filesystem::path& path) {
+        map(path);
+        try {
+            validate();
+        } catch (...) {
+            unmap();
+            throw;
+        }
+    }
+
+    void AssetPack::validate() {
+        if (fileSize < sizeof(AssetPackHeader)) throw std::runtime_error("asset pack is truncated!");
+
+        AssetPackHeader header;
+        std::memcpy(&header, mapped, sizeof(header));
+        if (std::memcmp(header.magic, ASSET_PACK_MAGIC, sizeof(header.magic)) != 0) throw std::runtime_error("file is not an asset pack!");
+        if (header.version != ASSET_PACK_VERSION) throw std::runtime_error("unsupported asset pack version!");
+
+        const uint64_t indexEnd = sizeof(AssetPackHeader) + static_cast<uint64_t>(header.entryCount) * sizeof(AssetPackEntry);
+        if (indexEnd > fileSize || header.stringTableOffset < indexEnd || header.stringTableOffset > fileSize || header.stringTableSize > fileSize - header.stringTableOffset) {
+            throw std::runtime_error("asset pack index is out of bounds!");
+        }
+
+        // The header is 32 bytes and the mapping page aligned, so the entries can be used in place
+        entries = {reinterpret_cast<const AssetPackEntry*>(mapped + sizeof(AssetPackHeader)), header.entryCount};
+        const char* strings = reinterpret_cast<const char*>(mapped + header.stringTableOffset);
+
+        index.reserve(entries.size());
+        for (uint32_t i = 0; i < entries.size(); i++) {
+            const AssetPackEntry& entry = entries[i];
+            if (entry.offset > fileSize || entry.size > fileSize - entry.offset || entry.offset % ASSET_PACK_ALIGNMENT != 0) {
+                throw std::runtime_error("asset pack blob is out of bounds!");
+            }
+            if (static_cast<uint64_t>(entry.nameOffset) + entry.nameLength > header.stringTableSize) {
+                throw std::runtime_error("asset pack name is out of bounds!");
+            }
+            index.emplace(std::string_view(strings + entry.nameOffset, entry.nameLength), i);
+        }
+    }
+
+//------------------------------LOOKUP------------------------------
+    const AssetPackEntry* AssetPack::find(std::string_view name) const {
+        auto it = index.find(name);
+        return it == index.end() ? nullptr : &entries[it->second];
+    }
+
+    std::span<const std::byte> AssetPack::getData(const AssetPackEntry& entry) const {
+        return {mapped + entry.offset, static_cast<size_t>(entry.size)};
+    }
+
+    std::string_view AssetPack::getName(const AssetPackEntry& entry) const {
+        AssetPackHeader header;
+        std::memcpy(&header, mapped, sizeof(header));
+        return {reinterpret_cast<const char*>(mapped + header.stringTableOffset + entry.nameOffset), entry.nameLength};
+    }
+
+//------------------------------MAPPING------------------------------
+#ifdef _WIN32
+    void AssetPack::map(const std::filesystem::path& path) {
+        fileHandle = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_RANDOM_ACCESS, nullptr);
+        if (fileHandle == INVALID_HANDLE_VALUE) throw std::runtime_error("failed to open asset pack " + path.string() + "!");
+
+        LARGE_INTEGER size;
+        GetFileSizeEx(fileHandle, &size);
+        fileSize = static_cast<uint64_t>(size.QuadPart);
+
+        mappingHandle = fileSize ? CreateFileMappingW(fileHandle, nullptr, PAGE_READONLY, 0, 0, nullptr) : nullptr;
+        mapped = mappingHandle ? static_cast<const std::byte*>(MapViewOfFile(mappingHandle, FILE_MAP_READ, 0, 0, 0)) : nullptr;
+        if (!mapped) {
+            unmap();
+            throw std::runtime_error("failed to map asset pack " + path.string() + "!");
+        }
+    }
+
+    void AssetPack::unmap() {
+        if (mapped) UnmapViewOfFile(mapped);
+        if (mappingHandle) CloseHandle(mappingHandle);
+        if (fileHandle && fileHandle != INVALID_HANDLE_VALUE) CloseHandle(fileHandle);
+        mapped = nullptr;
+        mappingHandle = nullptr;
+        fileHandle = nullptr;
+    }
+
+    void AssetPack::prefetch(const AssetPackEntry& entry) const {
+        WIN32_MEMORY_RANGE_ENTRY range{const_cast<std::byte*>(mapped + entry.offset), static_cast<SIZE_T>(entry.size)};
+        PrefetchVirtualMemory(GetCurrentProcess(), 1, &range, 0);
+    }
+#else
+    void AssetPack::map(const std::filesystem::path& path) {
+        const int descriptor = open(path.c_str(), O_RDONLY);
+        if (descriptor < 0) throw std::runtime_error("failed to open asset pack " + path.string() + "!");
+
+        struct stat status;
+        if (fstat(descriptor, &status) != 0 || status.st_size == 0) {
+            close(descriptor);
+            throw std::runtime_error("failed to map asset pack " + path.string() + "!");
+        }
+        fileSize = static_cast<uint64_t>(status.st_size);
+
+        // The mapping keeps its own reference to the file, the descriptor is not needed past this point
+        void* address = mmap(nullptr, fileSize, PROT_READ, MAP_PRIVATE, descriptor, 0);
+        close(descriptor);
+        if (address == MAP_FAILED) throw std::runtime_error("failed to map asset pack " + path.string() + "!");
+        mapped = static_cast<const std::byte*>(address);
+    }
+
+    void AssetPack::unmap() {
+        if (mapped) munmap(const_cast<std::byte*>(mapped), fileSize);
+        mapped = nullptr;
+    }
+
+    void AssetPack::prefetch(const AssetPackEntry& entry) const {
+        // madvise wants a page aligned start, blobs are only aligned to ASSET_PACK_ALIGNMENT
+        const uint64_t pageSize = static_cast<uint64_t>(sysconf(_SC_PAGESIZE));
+        const uint64_t start = entry.offset & ~(pageSize - 1);
+        madvise(const_cast<std::byte*>(mapped + start), entry.offset + entry.size - start, MADV_WILLNEED);
+    }
+#endif
+
+//------------------------------DESTROY------------------------------
+    AssetPack::~AssetPack() {
+        unmap();
+    }
+}
\ No newline at end of file
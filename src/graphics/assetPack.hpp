@@ -0,0 +1,88 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace Graphics {
+
+    // Layout of a pack file: header, entry index, string table with the entry names, then the blobs. Every blob starts at
+    // a multiple of ASSET_PACK_ALIGNMENT so it can be copied straight to the GPU and read in place from the mapping
+    constexpr char ASSET_PACK_MAGIC[8] = {'V', 'K', 'A', 'P', 'A', 'C', 'K', '\0'};
+    constexpr uint32_t ASSET_PACK_VERSION = 1;
+    constexpr uint64_t ASSET_PACK_ALIGNMENT = 256;
+
+    enum class AssetType : uint32_t {
+        Raw = 0,
+        Mesh = 1,
+        Texture = 2
+    };
+
+    struct AssetPackHeader {
+        char magic[8];
+        uint32_t version;
+        uint32_t entryCount;
+        uint64_t stringTableOffset;
+        uint64_t stringTableSize;
+    };
+
+    struct AssetPackEntry {
+        uint64_t offset;
+        uint64_t size;
+        uint32_t nameOffset;
+        uint32_t nameLength;
+        AssetType type;
+        uint32_t reserved;
+    };
+
+    static_assert(sizeof(AssetPackHeader) == 32 && sizeof(AssetPackEntry) == 32, "pack structs are written as is");
+
+    struct AssetPackSource {
+        std::string name;
+        AssetType type = AssetType::Raw;
+        std::filesystem::path path;
+    };
+
+    // Writes a pack holding the sources in the given order, used by the offline packer
+    void writeAssetPack(const std::filesystem::path& path, const std::vector<AssetPackSource>& sources);
+
+    // Read only view of a pack file. The file is mapped instead of read, so opening costs nothing and a blob's pages only
+    // come from disk the first time something touches them, on whichever thread that is
+    class AssetPack {
+
+        public:
+            explicit AssetPack(const std::filesystem::path& path);
+            ~AssetPack();
+            AssetPack(const AssetPack&) = delete;
+            AssetPack& operator=(const AssetPack&) = delete;
+
+            // nullptr when the pack has no entry of that name
+            const AssetPackEntry* find(std::string_view name) const;
+            std::span<const std::byte> getData(const AssetPackEntry& entry) const;
+            std::string_view getName(const AssetPackEntry& entry) const;
+            // Asks the OS to start reading the blob in the background, a hint only
+            void prefetch(const AssetPackEntry& entry) const;
+            inline std::span<const AssetPackEntry> getEntries() const { return entries; }
+            inline uint64_t getFileSize() const { return fileSize; }
+
+        private:
+            const std::byte* mapped = nullptr;
+            uint64_t fileSize = 0;
+#ifdef _WIN32
+            void* fileHandle = nullptr;
+            void* mappingHandle = nullptr;
+#endif
+            std::span<const AssetPackEntry> entries;
+            std::unordered_map<std::string_view, uint32_t> index;
+
+            void map(const std::filesystem::path& path);
+            void unmap();
+            void validate();
+    };
+}
\ No newline at end of file
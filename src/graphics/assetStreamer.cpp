@@ -0,0 +1,110 @@
+#include "assetStreamer.hpp"
+#include "profiler.hpp"
+#include <cstring>
+namespace Graphics {
+
+    AssetStreamer::AssetStreamer(const AssetPack& pack, Allocator& allocator, Uploader& uploader, JobSystem& jobSystem) : pack(pack), allocator(allocator), uploader(uploader), jobSystem(jobSystem) {}
+
+//------------------------------REQUEST------------------------------
+    uint32_t AssetStreamer::request(std::string_view name, VkBufferUsageFlags usage) {
+        const AssetPackEntry* entry = pack.find(name);
+        if (!entry) throw std::runtime_error("asset " + std::string(name) + " is not in the pack!");
+        if (entry->size == 0) throw std::runtime_error("asset " + std::string(name) + " is empty!");
+
+        if (isIdle()) streamStart = std::chrono::steady_clock::now();
+
+        // Lets the OS read ahead while the blob waits for its wave
+        pack.prefetch(*entry);
+
+        const uint32_t handle = static_cast<uint32_t>(streams.size());
+        streams.push_back({entry, usage, State::Queued, {}});
+        queued.push_back(handle);
+        stats.requested++;
+        stats.bytesRequested += entry->size;
+        return handle;
+    }
+
+//------------------------------UPDATE------------------------------
+    void AssetStreamer::update() {
+        if (isIdle()) return;
+        PROFILE_ZONE("streamUpdate");
+        stats.framesWhileStreaming++;
+
+        if (!wave.empty()) {
+            if (!waveCounter->isDone()) return;
+            finishWave();
+        }
+        startWave();
+
+        // Without workers the copies only run inside wait, do them now instead of leaving the wave stuck
+        if (!wave.empty() && jobSystem.getWorkerCount() == 0) finishWave();
+        if (isIdle()) stats.streamMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - streamStart).count();
+    }
+
+    void AssetStreamer::finishWave() {
+        jobSystem.wait(*waveCounter);
+        uploader.submit();
+
+        for (uint32_t handle : wave) {
+            streams[handle].state = State::Resident;
+            stats.resident++;
+            stats.bytesResident += streams[handle].entry->size;
+        }
+        wave.clear();
+    }
+
+    void AssetStreamer::startWave() {
+        waveCounter = std::make_unique<JobCounter>();
+
+        while (!queued.empty()) {
+            Stream& stream = streams[queued.front()];
+            const std::span<const std::byte> data = pack.getData(*stream.entry);
+
+            std::optional<StagedUpload> upload = uploader.tryReserveUpload(data.size(), stream.usage);
+            if (!upload) {
+                // Ring is full, the rest waits for a later wave. A blob that never fits in one piece goes through the
+                // blocking path, which is safe only because nothing of this wave is reserved yet
+                if (!wave.empty() || data.size() <= uploader.getStagingSize()) break;
+                stream.buffer = uploader.uploadBuffer(data.data(), data.size(), stream.usage);
+                stream.state = State::Copying;
+                wave.push_back(queued.front());
+                queued.pop_front();
+                break;
+            }
+
+            stream.buffer = upload->buffer;
+            stream.state = State::Copying;
+            wave.push_back(queued.front());
+            queued.pop_front();
+
+            jobSystem.run([this, data, staging = upload->staging] {
+                std::memcpy(staging, data.data(), data.size());
+                uploader.writeFinished();
+            }, waveCounter.get());
+        }
+
+        if (!wave.empty()) stats.waves++;
+    }
+
+//------------------------------LOOKUP------------------------------
+    VkBuffer AssetStreamer::getBuffer(uint32_t handle) const {
+        return isResident(handle) ? streams[handle].buffer.buffer : VK_NULL_HANDLE;
+    }
+
+    AssetStreamStats AssetStreamer::getStats() const {
+        return stats;
+    }
+
+//------------------------------DESTROY------------------------------
+    AssetStreamer::~AssetStreamer() {
+        // Copies into staging have to end before the mapping or the uploader go away
+        if (waveCounter) {
+            try {
+                jobSystem.wait(*waveCounter);
+            } catch (...) {}
+        }
+        for (Stream& stream : streams) {
+            if (stream.buffer.buffer != VK_NULL_HANDLE) allocator.destroyBuffer(stream.buffer);
+        }
+    }
+}
\ No newline at end of file
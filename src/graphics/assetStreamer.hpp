@@ -0,0 +1,81 @@
+#pragma once
+
+#include "../includes/graphics.hpp"
+#include "allocator.hpp"
+#include "assetPack.hpp"
+#include "jobSystem.hpp"
+#include "uploader.hpp"
+#include <chrono>
+#include <deque>
+#include <memory>
+#include <optional>
+#include <string_view>
+#include <vector>
+
+namespace Graphics {
+
+    struct AssetStreamStats {
+        uint32_t requested = 0;
+        uint32_t resident = 0;
+        uint64_t bytesRequested = 0;
+        uint64_t bytesResident = 0;
+        uint32_t waves = 0;
+        // Frames that called update while blobs were still on their way
+        uint32_t framesWhileStreaming = 0;
+        // From the first request until the last queued blob was submitted
+        double streamMs = 0.0;
+    };
+
+    // Streams blobs of a mapped asset pack into device-local buffers while frames keep rendering. Each update starts a
+    // wave: staging ranges are reserved on the calling thread, then jobs copy the blobs from the mapping straight into
+    // them, so the page faults that read the file from disk happen on workers. Once every copy of a wave is done the next
+    // update submits it, and frames recorded afterwards pick the buffers up through Uploader::recordAcquire
+    class AssetStreamer {
+
+        public:
+            AssetStreamer(const AssetPack& pack, Allocator& allocator, Uploader& uploader, JobSystem& jobSystem);
+            // Buffers may still be read by submitted frames, the device has to be idle
+            ~AssetStreamer();
+            AssetStreamer(const AssetStreamer&) = delete;
+            AssetStreamer& operator=(const AssetStreamer&) = delete;
+
+            // Queues the blob and returns the handle its buffer is looked up with
+            uint32_t request(std::string_view name, VkBufferUsageFlags usage);
+            // Once per frame before recording, on the thread that owns the uploader
+            void update();
+            inline bool isIdle() const { return queued.empty() && wave.empty(); }
+            inline bool isResident(uint32_t handle) const { return streams[handle].state == State::Resident; }
+            // VK_NULL_HANDLE until the blob is resident
+            VkBuffer getBuffer(uint32_t handle) const;
+            AssetStreamStats getStats() const;
+
+        private:
+            enum class State {
+                Queued,
+                Copying,
+                Resident
+            };
+
+            struct Stream {
+                const AssetPackEntry* entry;
+                VkBufferUsageFlags usage;
+                State state = State::Queued;
+                BufferAllocation buffer;
+            };
+
+            const AssetPack& pack;
+            Allocator& allocator;
+            Uploader& uploader;
+            JobSystem& jobSystem;
+            std::vector<Stream> streams;
+            std::deque<uint32_t> queued;
+            std::vector<uint32_t> wave;
+            std::unique_ptr<JobCounter> waveCounter;
+
+            AssetStreamStats stats;
+            std::chrono::steady_clock::time_point streamStart;
+
+            void finishWave();
+            void startWave();
+    };
+}
\ No newline at end of file
@@ -0,0 +1,166 @@
+#include "benchmark.hpp"
+namespace Graphics {
+
+    Benchmark::Benchmark(uint32_t warmupFrames, uint32_t measuredFrames) : warmupFrames(warmupFrames), measuredFrames(measuredFrames) {
+        frameMs.reserve(measuredFrames);
+        waitMs.reserve(measuredFrames);
+        acquireMs.reserve(measuredFrames);
+        recordMs.reserve(measuredFrames);
+        submitMs.reserve(measuredFrames);
+        presentMs.reserve(measuredFrames);
+        gpuMs.reserve(measuredFrames);
+        visibleInstances.reserve(measuredFrames);
+        culledInstances.reserve(measuredFrames);
+        lastFrameEnd = Clock::now();
+    }
+
+//------------------------------FRAME FINISHED------------------------------
+    void Benchmark::frameFinished(const FrameTimings& timings) {
+        auto now = Clock::now();
+        framesSeen++;
+
+        // The frame that closes the warm-up only starts the clock, measured frames are the ones after it
+        if (framesSeen <= warmupFrames) {
+            lastFrameEnd = measureStart = now;
+            return;
+        }
+        if (framesSeen > warmupFrames + measuredFrames) return;
+
+        frameMs.push_back(std::chrono::duration<double, std::milli>(now - lastFrameEnd).count());
+        waitMs.push_back(timings.waitMs);
+        acquireMs.push_back(timings.acquireMs);
+        recordMs.push_back(timings.recordMs);
+        submitMs.push_back(timings.submitMs);
+        presentMs.push_back(timings.presentMs);
+        if (timings.gpuMs >= 0.0) gpuMs.push_back(timings.gpuMs);
+        if (timings.visibleInstances >= 0) {
+            visibleInstances.push_back(static_cast<double>(timings.visibleInstances));
+            culledInstances.push_back(static_cast<double>(timings.culledInstances));
+        }
+
+        lastFrameEnd = measureEnd = now;
+    }
+
+//------------------------------SUMMARIZE------------------------------
+    nlohmann::json Benchmark::summarize(std::vector<double> samples) {
+        nlohmann::json summary;
+        summary["samples"] = samples.size();
+        if (samples.empty()) return summary;
+
+        std::sort(samples.begin(), samples.end());
+
+        // Nearest-rank percentiles, no interpolation so every reported value is a real frame
+        auto percentile = [&samples](double p) {
+            size_t rank = static_cast<size_t>(std::ceil(p / 100.0 * static_cast<double>(samples.size())));
+            return samples[std::clamp<size_t>(rank, 1, samples.size()) - 1];
+        };
+
+        double sum = 0.0;
+        for (double sample : samples) sum += sample;
+
+        summary["mean"] = sum / static_cast<double>(samples.size());
+        summary["min"] = samples.front();
+        summary["p50"] = percentile(50.0);
+        summary["p95"] = percentile(95.0);
+        summary["p99"] = percentile(99.0);
+        summary["max"] = samples.back();
+        return summary;
+    }
+
+//------------------------------WRITE REPORT------------------------------
+    nlohmann::json Benchmark::buildReport(const nlohmann::json& context) const {
+        nlohmann::json report = context;
+        double measuredSeconds = std::chrono::duration<double>(measureEnd - measureStart).count();
+
+        report["warmupFrames"] = warmupFrames;
+        report["measuredFrames"] = frameMs.size();
+        report["averageFps"] = measuredSeconds > 0.0 ? static_cast<double>(frameMs.size()) / measuredSeconds : 0.0;
+        report["frameTimeMs"] = summarize(frameMs);
+        report["cpuMs"]["wait"] = summarize(waitMs);
+        report["cpuMs"]["acquire"] = summarize(acquireMs);
+        report["cpuMs"]["record"] = summarize(recordMs);
+        report["cpuMs"]["submit"] = summarize(submitMs);
+        report["cpuMs"]["present"] = summarize(presentMs);
+        report["gpuMs"] = summarize(gpuMs);
+        if (!visibleInstances.empty()) {
+            report["culling"]["visible"] = summarize(visibleInstances);
+            report["culling"]["culled"] = summarize(culledInstances);
+        }
+
+        // Throughput of the instanced path, every frame draws the whole scene once
+        if (context.contains("instanceCount")) report["instancesPerSecond"] = report["averageFps"].get<double>() * context["instanceCount"].get<double>();
+        return report;
+    }
+
+    void Benchmark::writeReport(const std::string& filename, const nlohmann::json& context) const {
+        nlohmann::json report = buildReport(context);
+
+        std::ofstream file(filename);
+        if (!file.is_open()) throw std::runtime_error("failed to open benchmark report: " + filename);
+        file << report.dump(4) << "\n";
+
+        std::cout << "Benchmark: " << frameMs.size() << " frames, p50 " << report["frameTimeMs"].value("p50", 0.0)
+                  << " ms, p99 " << report["frameTimeMs"].value("p99", 0.0) << " ms -> " << filename << "\n";
+    }
+
+//------------------------------JOB SYSTEM BENCHMARK------------------------------
+    nlohmann::json benchmarkJobSystem(uint32_t maxWorkers) {
+        using Clock = std::chrono::steady_clock;
+        constexpr uint32_t EMPTY_JOBS = 100000;
+        constexpr uint32_t WORK_ITEMS = 1024;
+        constexpr uint32_t WORK_ITERATIONS = 20000;
+
+        std::vector<uint32_t> workerCounts = {0};
+        for (uint32_t workers = 1; workers < maxWorkers; workers *= 2) workerCounts.push_back(workers);
+        if (maxWorkers) workerCounts.push_back(maxWorkers);
+
+        nlohmann::json passes = nlohmann::json::array();
+        double baselineWorkMs = 0.0;
+
+        for (uint32_t workers : workerCounts) {
+            JobSystem jobSystem(workers);
+
+            // Scheduling overhead: jobs that do nothing, submitted from the owning thread and drained by everyone
+            JobCounter emptyDone;
+            const auto emptyStart = Clock::now();
+            for (uint32_t i = 0; i < EMPTY_JOBS; i++) jobSystem.run([] {}, &emptyDone);
+            jobSystem.wait(emptyDone);
+            const double emptyNs = std::chrono::duration<double, std::nano>(Clock::now() - emptyStart).count() / EMPTY_JOBS;
+
+            // Scaling: a fixed amount of ALU work split into one job per item
+            std::vector<uint32_t> results(WORK_ITEMS);
+            JobCounter workDone;
+            const auto workStart = Clock::now();
+            jobSystem.parallelFor(WORK_ITEMS, 1, [&results](uint32_t first, uint32_t last) {
+                for (uint32_t item = first; item < last; item++) {
+                    uint32_t state = item + 1;
+                    for (uint32_t i = 0; i < WORK_ITERATIONS; i++) state = state * 1664525u + 1013904223u;
+                    results[item] = state;
+                }
+            }, workDone);
+            jobSystem.wait(workDone);
+            const double workMs = std::chrono::duration<double, std::milli>(Clock::now() - workStart).count();
+            if (workers == 0) baselineWorkMs = workMs;
+
+            nlohmann::json pass;
+            pass["workers"] = workers;
+            pass["threads"] = workers + 1;
+            pass["emptyJobNs"] = emptyNs;
+            pass["workMs"] = workMs;
+            pass["speedup"] = workMs > 0.0 ? baselineWorkMs / workMs : 0.0;
+            // Keeps the work loop from being optimized away
+            pass["checksum"] = std::accumulate(results.begin(), results.end(), 0u);
+            passes.push_back(pass);
+
+            std::cout << "Job benchmark: " << workers + 1 << " threads, " << emptyNs << " ns/job, " << workMs << " ms work (" << pass["speedup"].get<double>() << "x)\n";
+        }
+
+        nlohmann::json report;
+        report["mode"] = "job-benchmark";
+        report["hardwareThreads"] = std::thread::hardware_concurrency();
+        report["emptyJobs"] = EMPTY_JOBS;
+        report["workItems"] = WORK_ITEMS;
+        report["passes"] = passes;
+        return report;
+    }
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+#include "renderer.hpp"
+#include "jobSystem.hpp"
+#include <nlohmann/json.hpp>
+#include <chrono>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <cmath>
+#include <numeric>
+
+namespace Graphics {
+
+    class Benchmark {
+
+        public:
+            Benchmark(uint32_t warmupFrames, uint32_t measuredFrames);
+            void frameFinished(const FrameTimings& timings);
+            nlohmann::json buildReport(const nlohmann::json& context) const;
+            void writeReport(const std::string& filename, const nlohmann::json& context) const;
+
+            inline bool isFinished() const { return framesSeen >= warmupFrames + measuredFrames; }
+            inline uint32_t getTotalFrames() const { return warmupFrames + measuredFrames; }
+
+            // Sample count, mean, min, p50/p95/p99 and max, shared with the other reports that keep distributions
+            static nlohmann::json summarize(std::vector<double> samples);
+
+        private:
+            using Clock = std::chrono::steady_clock;
+
+            uint32_t warmupFrames;
+            uint32_t measuredFrames;
+            uint32_t framesSeen = 0;
+            Clock::time_point lastFrameEnd;
+            Clock::time_point measureStart;
+            Clock::time_point measureEnd;
+
+            std::vector<double> frameMs;
+            std::vector<double> waitMs;
+            std::vector<double> acquireMs;
+            std::vector<double> recordMs;
+            std::vector<double> submitMs;
+            std::vector<double> presentMs;
+            std::vector<double> gpuMs;
+            std::vector<double> visibleInstances;
+            std::vector<double> culledInstances;
+    };
+
+    // Per-job scheduling overhead and speed-up of a fixed ALU workload for 0, 1, 2, 4, ... maxWorkers worker threads
+    nlohmann::json benchmarkJobSystem(uint32_t maxWorkers);
+}
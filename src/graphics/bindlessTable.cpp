@@ -0,0 +1,186 @@
+#include "bindlessTable.hpp"
+namespace Graphics {
+
+    BindlessTable::BindlessTable(VkDevice device, const VkPhysicalDeviceLimits& limits, bool updateAfterBind) : vk_logicalDevice(device), updateAfterBind(updateAfterBind) {
+
+//------------------------------SIZE BINDINGS------------------------------
+        // The non update-after-bind limits are the lower ones, staying below them keeps both paths on one layout
+        if (limits.maxPerStageDescriptorStorageBuffers < STORAGE_BUFFER_CAPACITY || limits.maxDescriptorSetStorageBuffers < STORAGE_BUFFER_CAPACITY)
+            throw std::runtime_error("device supports too few storage buffer descriptors for the bindless table!");
+
+        const uint32_t samplerCapacity = std::min({MAX_SAMPLERS, limits.maxPerStageDescriptorSamplers, limits.maxDescriptorSetSamplers});
+        // The fragment stage sees every binding plus its color attachment
+        const uint32_t stageResourcesLeft = limits.maxPerStageResources > STORAGE_BUFFER_CAPACITY + samplerCapacity + 1 ? limits.maxPerStageResources - STORAGE_BUFFER_CAPACITY - samplerCapacity - 1 : 1;
+        const uint32_t imageCapacity = std::min({MAX_SAMPLED_IMAGES, limits.maxPerStageDescriptorSampledImages, limits.maxDescriptorSetSampledImages, stageResourcesLeft});
+
+        bindings[static_cast<uint32_t>(BindlessKind::StorageBuffer)].type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        bindings[static_cast<uint32_t>(BindlessKind::StorageBuffer)].elements.resize(STORAGE_BUFFER_CAPACITY);
+        bindings[static_cast<uint32_t>(BindlessKind::SampledImage)].type = VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE;
+        bindings[static_cast<uint32_t>(BindlessKind::SampledImage)].elements.resize(imageCapacity);
+        bindings[static_cast<uint32_t>(BindlessKind::Sampler)].type = VK_DESCRIPTOR_TYPE_SAMPLER;
+        bindings[static_cast<uint32_t>(BindlessKind::Sampler)].elements.resize(samplerCapacity);
+
+//------------------------------CREATE DESCRIPTOR SET LAYOUT------------------------------
+        std::array<VkDescriptorSetLayoutBinding, 3> layoutBindings{};
+        std::array<VkDescriptorBindingFlags, 3> bindingFlags{};
+        for (uint32_t i = 0; i < layoutBindings.size(); i++) {
+            layoutBindings[i].binding = i;
+            layoutBindings[i].descriptorType = bindings[i].type;
+            layoutBindings[i].descriptorCount = static_cast<uint32_t>(bindings[i].elements.size());
+            layoutBindings[i].stageFlags = bindings[i].type == VK_DESCRIPTOR_TYPE_STORAGE_BUFFER ? VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT : VK_SHADER_STAGE_FRAGMENT_BIT;
+            bindingFlags[i] = VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT | VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT;
+        }
+
+        VkDescriptorSetLayoutBindingFlagsCreateInfo bindingFlagsInfo{};
+        bindingFlagsInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO;
+        bindingFlagsInfo.bindingCount = static_cast<uint32_t>(bindingFlags.size());
+        bindingFlagsInfo.pBindingFlags = bindingFlags.data();
+
+        VkDescriptorSetLayoutCreateInfo descriptorSetLayoutInfo{};
+        descriptorSetLayoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+        descriptorSetLayoutInfo.pNext = updateAfterBind ? &bindingFlagsInfo : nullptr;
+        descriptorSetLayoutInfo.flags = updateAfterBind ? VK_DESCRIPTOR_SET_LAYOUT_CREATE_UPDATE_AFTER_BIND_POOL_BIT : 0;
+        descriptorSetLayoutInfo.bindingCount = static_cast<uint32_t>(layoutBindings.size());
+        descriptorSetLayoutInfo.pBindings = layoutBindings.data();
+
+        if (vkCreateDescriptorSetLayout(vk_logicalDevice, &descriptorSetLayoutInfo, nullptr, &vk_descriptorSetLayout) != VK_SUCCESS) throw std::runtime_error("failed to create bindless descriptor set layout!");
+
+//------------------------------CREATE DESCRIPTOR SET------------------------------
+        std::array<VkDescriptorPoolSize, 3> poolSizes{};
+        for (uint32_t i = 0; i < poolSizes.size(); i++) {
+            poolSizes[i].type = bindings[i].type;
+            poolSizes[i].descriptorCount = static_cast<uint32_t>(bindings[i].elements.size());
+        }
+
+        VkDescriptorPoolCreateInfo descriptorPoolInfo{};
+        descriptorPoolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+        descriptorPoolInfo.flags = updateAfterBind ? VK_DESCRIPTOR_POOL_CREATE_UPDATE_AFTER_BIND_BIT : 0;
+        descriptorPoolInfo.maxSets = 1;
+        descriptorPoolInfo.poolSizeCount = static_cast<uint32_t>(poolSizes.size());
+        descriptorPoolInfo.pPoolSizes = poolSizes.data();
+
+        if (vkCreateDescriptorPool(vk_logicalDevice, &descriptorPoolInfo, nullptr, &vk_descriptorPool) != VK_SUCCESS) throw std::runtime_error("failed to create bindless descriptor pool!");
+
+        VkDescriptorSetAllocateInfo descriptorSetInfo{};
+        descriptorSetInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+        descriptorSetInfo.descriptorPool = vk_descriptorPool;
+        descriptorSetInfo.descriptorSetCount = 1;
+        descriptorSetInfo.pSetLayouts = &vk_descriptorSetLayout;
+
+        if (vkAllocateDescriptorSets(vk_logicalDevice, &descriptorSetInfo, &vk_descriptorSet) != VK_SUCCESS) throw std::runtime_error("failed to allocate bindless descriptor set!");
+    }
+
+//------------------------------REGISTER------------------------------
+    uint32_t BindlessTable::registerBuffer(VkBuffer buffer, VkDeviceSize offset, VkDeviceSize range) {
+        Element element;
+        element.buffer = {buffer, offset, range};
+        return add(BindlessKind::StorageBuffer, element);
+    }
+
+    uint32_t BindlessTable::registerImage(VkImageView view, VkImageLayout layout) {
+        Element element;
+        element.image = {VK_NULL_HANDLE, view, layout};
+        return add(BindlessKind::SampledImage, element);
+    }
+
+    uint32_t BindlessTable::registerSampler(VkSampler sampler) {
+        Element element;
+        element.image = {sampler, VK_NULL_HANDLE, VK_IMAGE_LAYOUT_UNDEFINED};
+        return add(BindlessKind::Sampler, element);
+    }
+
+    uint32_t BindlessTable::add(BindlessKind kind, const Element& element) {
+        Binding& binding = bindings[static_cast<uint32_t>(kind)];
+
+        // Freed handles are reused first, so the used range stays dense
+        uint32_t handle;
+        if (!binding.freeHandles.empty()) {
+            handle = binding.freeHandles.back();
+            binding.freeHandles.pop_back();
+        } else if (binding.used < binding.elements.size()) {
+            handle = binding.used;
+        } else throw std::runtime_error("bindless table is full!");
+
+        const bool first = std::none_of(binding.elements.begin(), binding.elements.end(), [](const Element& e) { return e.registered; });
+        binding.elements[handle] = element;
+        binding.elements[handle].registered = true;
+        binding.used = std::max(binding.used, handle + 1);
+        write(kind, handle, 1, element);
+
+        if (!updateAfterBind && first) fillFreeElements(kind);
+        return handle;
+    }
+
+    void BindlessTable::release(BindlessKind kind, uint32_t handle) {
+        Binding& binding = bindings[static_cast<uint32_t>(kind)];
+        if (handle >= binding.elements.size() || !binding.elements[handle].registered) throw std::runtime_error("released bindless handle is not registered!");
+
+        binding.elements[handle].registered = false;
+        binding.freeHandles.push_back(handle);
+        if (!updateAfterBind) fillFreeElements(kind);
+    }
+
+//------------------------------WRITE------------------------------
+    void BindlessTable::write(BindlessKind kind, uint32_t first, uint32_t count, const Element& element) {
+        const Binding& binding = bindings[static_cast<uint32_t>(kind)];
+        const bool isBuffer = binding.type == VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        std::vector<VkDescriptorBufferInfo> bufferInfos(isBuffer ? count : 0, element.buffer);
+        std::vector<VkDescriptorImageInfo> imageInfos(isBuffer ? 0 : count, element.image);
+
+        VkWriteDescriptorSet descriptorWrite{};
+        descriptorWrite.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        descriptorWrite.dstSet = vk_descriptorSet;
+        descriptorWrite.dstBinding = static_cast<uint32_t>(kind);
+        descriptorWrite.dstArrayElement = first;
+        descriptorWrite.descriptorType = binding.type;
+        descriptorWrite.descriptorCount = count;
+        descriptorWrite.pBufferInfo = isBuffer ? bufferInfos.data() : nullptr;
+        descriptorWrite.pImageInfo = isBuffer ? nullptr : imageInfos.data();
+
+        vkUpdateDescriptorSets(vk_logicalDevice, 1, &descriptorWrite, 0, nullptr);
+    }
+
+    void BindlessTable::fillFreeElements(BindlessKind kind) {
+        // Without partially bound bindings every element a shader could index has to be valid, free ones repeat the
+        // first registered resource. A binding nothing is registered in yet stays empty, shaders must not use it then
+        const Binding& binding = bindings[static_cast<uint32_t>(kind)];
+        auto filler = std::find_if(binding.elements.begin(), binding.elements.end(), [](const Element& e) { return e.registered; });
+        if (filler == binding.elements.end()) return;
+
+        uint32_t runStart = 0;
+        for (uint32_t i = 0; i <= binding.elements.size(); i++) {
+            if (i < binding.elements.size() && !binding.elements[i].registered) continue;
+            if (i > runStart) write(kind, runStart, i - runStart, *filler);
+            runStart = i + 1;
+        }
+    }
+
+//------------------------------BIND------------------------------
+    void BindlessTable::bind(VkCommandBuffer commandBuffer, VkPipelineBindPoint bindPoint, VkPipelineLayout pipelineLayout) const {
+        vkCmdBindDescriptorSets(commandBuffer, bindPoint, pipelineLayout, 0, 1, &vk_descriptorSet, 0, nullptr);
+    }
+
+    BindlessStats BindlessTable::getStats() const {
+        auto count = [this](BindlessKind kind) {
+            const Binding& binding = bindings[static_cast<uint32_t>(kind)];
+            return static_cast<uint32_t>(std::count_if(binding.elements.begin(), binding.elements.end(), [](const Element& e) { return e.registered; }));
+        };
+        auto capacity = [this](BindlessKind kind) { return static_cast<uint32_t>(bindings[static_cast<uint32_t>(kind)].elements.size()); };
+
+        BindlessStats stats;
+        stats.storageBuffers = count(BindlessKind::StorageBuffer);
+        stats.storageBufferCapacity = capacity(BindlessKind::StorageBuffer);
+        stats.sampledImages = count(BindlessKind::SampledImage);
+        stats.sampledImageCapacity = capacity(BindlessKind::SampledImage);
+        stats.samplers = count(BindlessKind::Sampler);
+        stats.samplerCapacity = capacity(BindlessKind::Sampler);
+        stats.updateAfterBind = updateAfterBind;
+        return stats;
+    }
+
+//------------------------------DESTROY------------------------------
+    BindlessTable::~BindlessTable() {
+        vkDestroyDescriptorPool(vk_logicalDevice, vk_descriptorPool, nullptr);
+        vkDestroyDescriptorSetLayout(vk_logicalDevice, vk_descriptorSetLayout, nullptr);
+    }
+}
\ No newline at end of file
@@ -0,0 +1,82 @@
+#pragma once
+
+#include "../includes/graphics.hpp"
+#include <algorithm>
+#include <array>
+#include <stdexcept>
+#include <vector>
+
+namespace Graphics {
+
+    // Binding of the table each kind of resource lives in, a handle is the array element inside that binding
+    enum class BindlessKind : uint32_t {
+        StorageBuffer = 0,
+        SampledImage = 1,
+        Sampler = 2
+    };
+
+    struct BindlessStats {
+        uint32_t storageBuffers = 0;
+        uint32_t storageBufferCapacity = 0;
+        uint32_t sampledImages = 0;
+        uint32_t sampledImageCapacity = 0;
+        uint32_t samplers = 0;
+        uint32_t samplerCapacity = 0;
+        bool updateAfterBind = false;
+    };
+
+    // One global descriptor set holding every storage buffer, sampled image and sampler the renderer uses. Resources are
+    // registered once for an integer handle that shaders index the arrays with (passed as push constants), so a frame
+    // binds this set once per command buffer no matter how many resources it draws from.
+    // With updateAfterBind the arrays are partially bound and may change while frames in flight use the set, as long as
+    // those frames don't read the changed handles. Without it every element has to stay valid: free elements repeat a
+    // registered resource, and the table may only change while no submitted work uses it
+    class BindlessTable {
+
+        public:
+            // Must match BINDLESS_STORAGE_BUFFERS in the shaders, their arrays are sized at compile time
+            static constexpr uint32_t STORAGE_BUFFER_CAPACITY = 64;
+            static constexpr uint32_t MAX_SAMPLED_IMAGES = 1024;
+            static constexpr uint32_t MAX_SAMPLERS = 32;
+
+            BindlessTable(VkDevice device, const VkPhysicalDeviceLimits& limits, bool updateAfterBind);
+            ~BindlessTable();
+            BindlessTable(const BindlessTable&) = delete;
+            BindlessTable& operator=(const BindlessTable&) = delete;
+
+            uint32_t registerBuffer(VkBuffer buffer, VkDeviceSize offset = 0, VkDeviceSize range = VK_WHOLE_SIZE);
+            uint32_t registerImage(VkImageView view, VkImageLayout layout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+            uint32_t registerSampler(VkSampler sampler);
+            // The handle may be handed out again right away, so no in-flight frame may still read it
+            void release(BindlessKind kind, uint32_t handle);
+            void bind(VkCommandBuffer commandBuffer, VkPipelineBindPoint bindPoint, VkPipelineLayout pipelineLayout) const;
+            inline VkDescriptorSetLayout getSetLayout() const { return vk_descriptorSetLayout; }
+            inline bool getUpdateAfterBind() const { return updateAfterBind; }
+            BindlessStats getStats() const;
+
+        private:
+            struct Element {
+                VkDescriptorBufferInfo buffer{};
+                VkDescriptorImageInfo image{};
+                bool registered = false;
+            };
+
+            struct Binding {
+                VkDescriptorType type;
+                std::vector<Element> elements;
+                std::vector<uint32_t> freeHandles;
+                uint32_t used = 0;
+            };
+
+            VkDevice vk_logicalDevice;
+            bool updateAfterBind;
+            VkDescriptorSetLayout vk_descriptorSetLayout = VK_NULL_HANDLE;
+            VkDescriptorPool vk_descriptorPool = VK_NULL_HANDLE;
+            VkDescriptorSet vk_descriptorSet = VK_NULL_HANDLE;
+            std::array<Binding, 3> bindings;
+
+            uint32_t add(BindlessKind kind, const Element& element);
+            void write(BindlessKind kind, uint32_t first, uint32_t count, const Element& element);
+            void fillFreeElements(BindlessKind kind);
+    };
+}
\ No newline at end of file
@@ -0,0 +1,394 @@
+#include "blockDecoder.hpp"
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <stdexcept>
+
+namespace Graphics {
+
+    namespace {
+        using Block = std::array<std::array<uint8_t, 4>, 16>;
+
+        uint16_t readU16(const std::byte* data) {
+            return static_cast<uint16_t>(std::to_integer<uint16_t>(data[0]) | std::to_integer<uint16_t>(data[1]) << 8);
+        }
+
+        uint64_t readU64(const std::byte* data) {
+            uint64_t value = 0;
+            for (int i = 7; i >= 0; i--) value = value << 8 | std::to_integer<uint64_t>(data[i]);
+            return value;
+        }
+
+//------------------------------BC1 COLOR------------------------------
+        // BC2 and BC3 always use the four color mode, only BC1 switches to three colors plus black when c0 <= c1
+        void decodeColor(const std::byte* data, Block& block, bool allowPunchThrough, bool punchThroughAlpha) {
+            const uint16_t c0 = readU16(data);
+            const uint16_t c1 = readU16(data + 2);
+
+            std::array<std::array<uint8_t, 4>, 4> palette{};
+            for (int i = 0; i < 2; i++) {
+                const uint16_t c = i ? c1 : c0;
+                const uint8_t r = (c >> 11) & 31, g = (c >> 5) & 63, b = c & 31;
+                palette[i] = {static_cast<uint8_t>(r << 3 | r >> 2), static_cast<uint8_t>(g << 2 | g >> 4), static_cast<uint8_t>(b << 3 | b >> 2), 255};
+            }
+
+            const bool fourColors = !allowPunchThrough || c0 > c1;
+            for (int channel = 0; channel < 3; channel++) {
+                const int p0 = palette[0][channel], p1 = palette[1][channel];
+                if (fourColors) {
+                    palette[2][channel] = static_cast<uint8_t>((2 * p0 + p1 + 1) / 3);
+                    palette[3][channel] = static_cast<uint8_t>((p0 + 2 * p1 + 1) / 3);
+                } else {
+                    palette[2][channel] = static_cast<uint8_t>((p0 + p1 + 1) / 2);
+                    palette[3][channel] = 0;
+                }
+            }
+            palette[2][3] = 255;
+            palette[3][3] = fourColors || !punchThroughAlpha ? 255 : 0;
+
+            const uint32_t indices = readU16(data + 4) | static_cast<uint32_t>(readU16(data + 6)) << 16;
+            for (int pixel = 0; pixel < 16; pixel++) {
+                const auto& color = palette[(indices >> (2 * pixel)) & 3];
+                block[pixel][0] = color[0];
+                block[pixel][1] = color[1];
+                block[pixel][2] = color[2];
+                block[pixel][3] = color[3];
+            }
+        }
+
+//------------------------------BC4 CHANNEL------------------------------
+        // One channel of a BC3 alpha, BC4 or BC5 block. Signed blocks keep their values as two's complement bytes
+        void decodeChannel(const std::byte* data, Block& block, int channel, bool isSigned) {
+            int e0 = std::to_integer<int>(data[0]);
+            int e1 = std::to_integer<int>(data[1]);
+            if (isSigned) {
+                e0 = std::max(static_cast<int>(static_cast<int8_t>(e0)), -127);
+                e1 = std::max(static_cast<int>(static_cast<int8_t>(e1)), -127);
+            }
+
+            // Interpolation rounds to nearest, away from zero for negative values
+            auto mix = [](int a, int b, int wa, int wb, int divisor) {
+                const int sum = a * wa + b * wb;
+                return sum >= 0 ? (sum + divisor / 2) / divisor : -((-sum + divisor / 2) / divisor);
+            };
+
+            std::array<int, 8> palette{e0, e1};
+            if (e0 > e1) {
+                for (int i = 1; i < 7; i++) palette[i + 1] = mix(e0, e1, 7 - i, i, 7);
+            } else {
+                for (int i = 1; i < 5; i++) palette[i + 1] = mix(e0, e1, 5 - i, i, 5);
+                palette[6] = isSigned ? -127 : 0;
+                palette[7] = isSigned ? 127 : 255;
+            }
+
+            const uint64_t indices = readU64(data) >> 16;
+            for (int pixel = 0; pixel < 16; pixel++) block[pixel][channel] = static_cast<uint8_t>(palette[(indices >> (3 * pixel)) & 7]);
+        }
+
+//------------------------------BC7------------------------------
+        struct Bc7Mode {
+            uint8_t subsets;
+            uint8_t partitionBits;
+            uint8_t rotationBits;
+            uint8_t indexSelectionBits;
+            uint8_t colorBits;
+            uint8_t alphaBits;
+            uint8_t endpointPBits;
+            uint8_t sharedPBits;
+            uint8_t indexBits;
+            uint8_t secondaryIndexBits;
+        };
+
+        constexpr Bc7Mode BC7_MODES[8] = {
+            {3, 4, 0, 0, 4, 0, 1, 0, 3, 0},
+            {2, 6, 0, 0, 6, 0, 0, 1, 3, 0},
+            {3, 6, 0, 0, 5, 0, 0, 0, 2, 0},
+            {2, 6, 0, 0, 7, 0, 1, 0, 2, 0},
+            {1, 0, 2, 1, 5, 6, 0, 0, 2, 3},
+            {1, 0, 2, 0, 7, 8, 0, 0, 2, 2},
+            {1, 0, 0, 0, 7, 7, 1, 0, 4, 0},
+            {2, 6, 0, 0, 5, 5, 1, 0, 2, 0}
+        };
+
+        // Bit i is the subset of pixel i
+        constexpr uint16_t BC7_PARTITIONS_2[64] = {
+            0xcccc, 0x8888, 0xeeee, 0xecc8, 0xc880, 0xfeec, 0xfec8, 0xec80, 0xc800, 0xffec, 0xfe80, 0xe800, 0xffe8, 0xff00, 0xfff0, 0xf000,
+            0xf710, 0x008e, 0x7100, 0x08ce, 0x008c, 0x7310, 0x3100, 0x8cce, 0x088c, 0x3110, 0x6666, 0x366c, 0x17e8, 0x0ff0, 0x718e, 0x399c,
+            0xaaaa, 0xf0f0, 0x5a5a, 0x33cc, 0x3c3c, 0x55aa, 0x9696, 0xa55a, 0x73ce, 0x13c8, 0x324c, 0x3bdc, 0x6996, 0xc33c, 0x9966, 0x0660,
+            0x0272, 0x04e4, 0x4e40, 0x2720, 0xc936, 0x936c, 0x39c6, 0x639c, 0x9336, 0x9cc6, 0x817e, 0xe718, 0xccf0, 0x0fcc, 0x7744, 0xee22
+        };
+
+        // Bits 2i and 2i + 1 are the subset of pixel i
+        constexpr uint32_t BC7_PARTITIONS_3[64] = {
+            0xaa685050, 0x6a5a5040, 0x5a5a4200, 0x5450a0a8, 0xa5a50000, 0xa0a05050, 0x5555a0a0, 0x5a5a5050,
+            0xaa550000, 0xaa555500, 0xaaaa5500, 0x90909090, 0x94949494, 0xa4a4a4a4, 0xa9a59450, 0x2a0a4250,
+            0xa5945040, 0x0a425054, 0xa5a5a500, 0x55a0a0a0, 0xa8a85454, 0x6a6a4040, 0xa4a45000, 0x1a1a0500,
+            0x0050a4a4, 0xaaa59090, 0x14696914, 0x69691400, 0xa08585a0, 0xaa821414, 0x50a4a450, 0x6a5a0200,
+            0xa9a58000, 0x5090a0a8, 0xa8a09050, 0x24242424, 0x00aa5500, 0x24924924, 0x24499224, 0x50a50a50,
+            0x500aa550, 0xaaaa4444, 0x66660000, 0xa5a0a5a0, 0x50a050a0, 0x69286928, 0x44aaaa44, 0x66666600,
+            0xaa444444, 0x54a854a8, 0x95809580, 0x96969600, 0xa85454a8, 0x80959580, 0xaa141414, 0x96960000,
+            0xaaaa1414, 0xa05050a0, 0xa0a5a5a0, 0x96000000, 0x40804080, 0xa9a8a9a8, 0xaaaaaa44, 0x2a4a5254
+        };
+
+        // Anchor pixel of the second subset in two subset partitions, then of the second and third in three subset ones
+        constexpr uint8_t BC7_ANCHORS_2[64] = {
+            15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15,
+            15, 2, 8, 2, 2, 8, 8, 15, 2, 8, 2, 2, 8, 8, 2, 2,
+            15, 15, 6, 8, 2, 8, 15, 15, 2, 8, 2, 2, 2, 15, 15, 6,
+            6, 2, 6, 8, 15, 15, 2, 2, 15, 15, 15, 15, 15, 2, 2, 15
+        };
+
+        constexpr uint8_t BC7_ANCHORS_3_SECOND[64] = {
+            3, 3, 15, 15, 8, 3, 15, 15, 8, 8, 6, 6, 6, 5, 3, 3,
+            3, 3, 8, 15, 3, 3, 6, 10, 5, 8, 8, 6, 8, 5, 15, 15,
+            8, 15, 3, 5, 6, 10, 8, 15, 15, 3, 15, 5, 15, 15, 15, 15,
+            3, 15, 5, 5, 5, 8, 5, 10, 5, 10, 8, 13, 15, 12, 3, 3
+        };
+
+        constexpr uint8_t BC7_ANCHORS_3_THIRD[64] = {
+            15, 8, 8, 3, 15, 15, 3, 8, 15, 15, 15, 15, 15, 15, 15, 8,
+            15, 8, 15, 3, 15, 8, 15, 8, 3, 15, 6, 10, 15, 15, 10, 8,
+            15, 3, 15, 10, 10, 8, 9, 10, 6, 15, 8, 15, 3, 6, 6, 8,
+            15, 3, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 3, 15, 15, 8
+        };
+
+        constexpr uint8_t BC7_WEIGHTS_2[4] = {0, 21, 43, 64};
+        constexpr uint8_t BC7_WEIGHTS_3[8] = {0, 9, 18, 27, 37, 46, 55, 64};
+        constexpr uint8_t BC7_WEIGHTS_4[16] = {0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64};
+
+        class BitReader {
+
+            public:
+                explicit BitReader(const std::byte* data) : low(readU64(data)), high(readU64(data + 8)) {}
+
+                uint32_t read(uint32_t count) {
+                    uint32_t value = 0;
+                    for (uint32_t i = 0; i < count; i++, position++) {
+                        const uint64_t word = position < 64 ? low : high;
+                        value |= static_cast<uint32_t>((word >> (position & 63)) & 1) << i;
+                    }
+                    return value;
+                }
+
+            private:
+                uint64_t low;
+                uint64_t high;
+                uint32_t position = 0;
+        };
+
+        const uint8_t* bc7Weights(uint32_t bits) {
+            return bits == 2 ? BC7_WEIGHTS_2 : bits == 3 ? BC7_WEIGHTS_3 : BC7_WEIGHTS_4;
+        }
+
+        void decodeBc7(const std::byte* data, Block& block) {
+            uint32_t modeIndex = 0;
+            while (modeIndex < 8 && !((std::to_integer<uint32_t>(data[0]) >> modeIndex) & 1)) modeIndex++;
+
+            // Reserved mode, the block decodes to transparent black
+            if (modeIndex == 8) {
+                for (auto& pixel : block) pixel = {0, 0, 0, 0};
+                return;
+            }
+
+            const Bc7Mode& mode = BC7_MODES[modeIndex];
+            BitReader bits(data);
+            bits.read(modeIndex + 1);
+
+            const uint32_t partition = bits.read(mode.partitionBits);
+            const uint32_t rotation = bits.read(mode.rotationBits);
+            const uint32_t indexSelection = bits.read(mode.indexSelectionBits);
+
+            // Endpoints are stored channel by channel, each channel for every endpoint of every subset
+            std::array<std::array<uint32_t, 4>, 6> endpoints{};
+            const uint32_t endpointCount = mode.subsets * 2u;
+            for (uint32_t channel = 0; channel < 3; channel++) {
+                for (uint32_t e = 0; e < endpointCount; e++) endpoints[e][channel] = bits.read(mode.colorBits);
+            }
+            for (uint32_t e = 0; e < endpointCount; e++) endpoints[e][3] = mode.alphaBits ? bits.read(mode.alphaBits) : 255;
+
+            uint32_t colorBits = mode.colorBits;
+            uint32_t alphaBits = mode.alphaBits;
+            if (mode.endpointPBits || mode.sharedPBits) {
+                std::array<uint32_t, 6> pBits{};
+                if (mode.endpointPBits) {
+                    for (uint32_t e = 0; e < endpointCount; e++) pBits[e] = bits.read(1);
+                } else {
+                    for (uint32_t s = 0; s < mode.subsets; s++) pBits[2 * s] = pBits[2 * s + 1] = bits.read(1);
+                }
+                for (uint32_t e = 0; e < endpointCount; e++) {
+                    for (uint32_t channel = 0; channel < 3; channel++) endpoints[e][channel] = endpoints[e][channel] << 1 | pBits[e];
+                    if (mode.alphaBits) endpoints[e][3] = endpoints[e][3] << 1 | pBits[e];
+                }
+                colorBits++;
+                if (alphaBits) alphaBits++;
+            }
+
+            // Expand to 8 bits by repeating the top bits
+            for (uint32_t e = 0; e < endpointCount; e++) {
+                for (uint32_t channel = 0; channel < 3; channel++) {
+                    endpoints[e][channel] = (endpoints[e][channel] << (8 - colorBits)) | (endpoints[e][channel] >> (2 * colorBits - 8));
+                }
+                if (alphaBits) endpoints[e][3] = (endpoints[e][3] << (8 - alphaBits)) | (endpoints[e][3] >> (2 * alphaBits - 8));
+            }
+
+            std::array<uint32_t, 16> subsetOf{};
+            std::array<bool, 16> anchor{};
+            anchor[0] = true;
+            for (uint32_t pixel = 0; pixel < 16; pixel++) {
+                if (mode.subsets == 2) subsetOf[pixel] = (BC7_PARTITIONS_2[partition] >> pixel) & 1;
+                else if (mode.subsets == 3) subsetOf[pixel] = (BC7_PARTITIONS_3[partition] >> (2 * pixel)) & 3;
+            }
+            if (mode.subsets == 2) anchor[BC7_ANCHORS_2[partition]] = true;
+            if (mode.subsets == 3) {
+                anchor[BC7_ANCHORS_3_SECOND[partition]] = true;
+                anchor[BC7_ANCHORS_3_THIRD[partition]] = true;
+            }
+
+            // Anchor pixels drop the top bit of their index, it is always zero
+            std::array<uint32_t, 16> indices{};
+            std::array<uint32_t, 16> secondaryIndices{};
+            for (uint32_t pixel = 0; pixel < 16; pixel++) indices[pixel] = bits.read(mode.indexBits - (anchor[pixel] ? 1 : 0));
+            if (mode.secondaryIndexBits) {
+                for (uint32_t pixel = 0; pixel < 16; pixel++) secondaryIndices[pixel] = bits.read(mode.secondaryIndexBits - (pixel == 0 ? 1 : 0));
+            }
+
+            for (uint32_t pixel = 0; pixel < 16; pixel++) {
+                const auto& e0 = endpoints[2 * subsetOf[pixel]];
+                const auto& e1 = endpoints[2 * subsetOf[pixel] + 1];
+
+                uint32_t colorWeight = bc7Weights(mode.indexBits)[indices[pixel]];
+                uint32_t alphaWeight = colorWeight;
+                if (mode.secondaryIndexBits) {
+                    // Mode 4 may swap which index set drives color and which drives alpha
+                    const uint32_t secondaryWeight = bc7Weights(mode.secondaryIndexBits)[secondaryIndices[pixel]];
+                    if (indexSelection) alphaWeight = colorWeight, colorWeight = secondaryWeight;
+                    else alphaWeight = secondaryWeight;
+                }
+
+                for (uint32_t channel = 0; channel < 4; channel++) {
+                    const uint32_t weight = channel == 3 ? alphaWeight : colorWeight;
+                    block[pixel][channel] = static_cast<uint8_t>(((64 - weight) * e0[channel] + weight * e1[channel] + 32) >> 6);
+                }
+
+                if (rotation) std::swap(block[pixel][3], block[pixel][rotation - 1]);
+            }
+        }
+
+//------------------------------DECODE BLOCK------------------------------
+        uint32_t compressedBlockBytes(VkFormat format) {
+            switch (format) {
+                case VK_FORMAT_BC1_RGB_UNORM_BLOCK:
+                case VK_FORMAT_BC1_RGB_SRGB_BLOCK:
+                case VK_FORMAT_BC1_RGBA_UNORM_BLOCK:
+                case VK_FORMAT_BC1_RGBA_SRGB_BLOCK:
+                case VK_FORMAT_BC4_UNORM_BLOCK:
+                case VK_FORMAT_BC4_SNORM_BLOCK:
+                    return 8;
+                default:
+                    return 16;
+            }
+        }
+
+        // RGBA values of the 16 pixels of a block
+        void decodeBlock(VkFormat format, const std::byte* data, Block& block) {
+            switch (format) {
+                case VK_FORMAT_BC1_RGB_UNORM_BLOCK:
+                case VK_FORMAT_BC1_RGB_SRGB_BLOCK:
+                    decodeColor(data, block, true, false);
+                    break;
+                case VK_FORMAT_BC1_RGBA_UNORM_BLOCK:
+                case VK_FORMAT_BC1_RGBA_SRGB_BLOCK:
+                    decodeColor(data, block, true, true);
+                    break;
+                case VK_FORMAT_BC2_UNORM_BLOCK:
+                case VK_FORMAT_BC2_SRGB_BLOCK: {
+                    decodeColor(data + 8, block, false, false);
+                    const uint64_t alpha = readU64(data);
+                    for (int pixel = 0; pixel < 16; pixel++) block[pixel][3] = static_cast<uint8_t>(((alpha >> (4 * pixel)) & 15) * 17);
+                    break;
+                }
+                case VK_FORMAT_BC3_UNORM_BLOCK:
+                case VK_FORMAT_BC3_SRGB_BLOCK:
+                    decodeColor(data + 8, block, false, false);
+                    decodeChannel(data, block, 3, false);
+                    break;
+                case VK_FORMAT_BC4_UNORM_BLOCK:
+                case VK_FORMAT_BC4_SNORM_BLOCK:
+                    decodeChannel(data, block, 0, format == VK_FORMAT_BC4_SNORM_BLOCK);
+                    break;
+                case VK_FORMAT_BC5_UNORM_BLOCK:
+                case VK_FORMAT_BC5_SNORM_BLOCK:
+                    decodeChannel(data, block, 0, format == VK_FORMAT_BC5_SNORM_BLOCK);
+                    decodeChannel(data + 8, block, 1, format == VK_FORMAT_BC5_SNORM_BLOCK);
+                    break;
+                case VK_FORMAT_BC7_UNORM_BLOCK:
+                case VK_FORMAT_BC7_SRGB_BLOCK:
+                    decodeBc7(data, block);
+                    break;
+                default:
+                    throw std::runtime_error("no decoder for this block-compressed format!");
+            }
+        }
+    }
+
+//------------------------------DECODED FORMAT------------------------------
+    VkFormat blockDecodedFormat(VkFormat format) {
+        switch (format) {
+            case VK_FORMAT_BC1_RGB_UNORM_BLOCK:
+            case VK_FORMAT_BC1_RGBA_UNORM_BLOCK:
+            case VK_FORMAT_BC2_UNORM_BLOCK:
+            case VK_FORMAT_BC3_UNORM_BLOCK:
+            case VK_FORMAT_BC7_UNORM_BLOCK:
+                return VK_FORMAT_R8G8B8A8_UNORM;
+            case VK_FORMAT_BC1_RGB_SRGB_BLOCK:
+            case VK_FORMAT_BC1_RGBA_SRGB_BLOCK:
+            case VK_FORMAT_BC2_SRGB_BLOCK:
+            case VK_FORMAT_BC3_SRGB_BLOCK:
+            case VK_FORMAT_BC7_SRGB_BLOCK:
+                return VK_FORMAT_R8G8B8A8_SRGB;
+            case VK_FORMAT_BC4_UNORM_BLOCK: return VK_FORMAT_R8_UNORM;
+            case VK_FORMAT_BC4_SNORM_BLOCK: return VK_FORMAT_R8_SNORM;
+            case VK_FORMAT_BC5_UNORM_BLOCK: return VK_FORMAT_R8G8_UNORM;
+            case VK_FORMAT_BC5_SNORM_BLOCK: return VK_FORMAT_R8G8_SNORM;
+            default: return VK_FORMAT_UNDEFINED;
+        }
+    }
+
+    uint32_t blockDecodedTexelBytes(VkFormat format) {
+        switch (blockDecodedFormat(format)) {
+            case VK_FORMAT_R8_UNORM:
+            case VK_FORMAT_R8_SNORM:
+                return 1;
+            case VK_FORMAT_R8G8_UNORM:
+            case VK_FORMAT_R8G8_SNORM:
+                return 2;
+            default:
+                return 4;
+        }
+    }
+
+//------------------------------DECODE ROWS------------------------------
+    void decodeBlockRows(VkFormat format, uint32_t width, uint32_t height, const std::byte* blocks, std::byte* texels, uint32_t firstRow, uint32_t lastRow) {
+        const uint32_t blocksWide = (width + 3) / 4;
+        const uint32_t texelBytes = blockDecodedTexelBytes(format);
+        const uint32_t blockBytes = compressedBlockBytes(format);
+        blocks += static_cast<size_t>(firstRow) * blocksWide * blockBytes;
+        Block block{};
+
+        for (uint32_t row = firstRow; row < lastRow; row++) {
+            for (uint32_t column = 0; column < blocksWide; column++) {
+                for (auto& pixel : block) pixel = {0, 0, 0, 255};
+                decodeBlock(format, blocks, block);
+                blocks += blockBytes;
+
+                // Blocks on the right and bottom edge cover pixels past the level, those are dropped
+                for (uint32_t y = 0; y < 4 && row * 4 + y < height; y++) {
+                    for (uint32_t x = 0; x < 4 && column * 4 + x < width; x++) {
+                        std::byte* texel = texels + (static_cast<size_t>(row * 4 + y) * width + column * 4 + x) * texelBytes;
+                        std::memcpy(texel, block[y * 4 + x].data(), texelBytes);
+                    }
+                }
+            }
+        }
+    }
+}
\ No newline at end of file
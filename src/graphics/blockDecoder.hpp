@@ -0,0 +1,18 @@
+#pragma once
+
+#include "../includes/graphics.hpp"
+#include <cstddef>
+#include <cstdint>
+
+namespace Graphics {
+
+    // CPU decoders for the BC formats, the fallback for GPUs without textureCompressionBC (most mobile ones).
+    // BC1-3 and BC7 decode to RGBA8, BC4 to R8 and BC5 to R8G8, keeping UNORM/SNORM/SRGB. BC6H has no decoder
+
+    // Format a BC format decodes to, VK_FORMAT_UNDEFINED when there is no decoder for it
+    VkFormat blockDecodedFormat(VkFormat format);
+    uint32_t blockDecodedTexelBytes(VkFormat format);
+    // Decodes block rows [firstRow, lastRow) of a width x height level. blocks holds the whole level, texels receives it
+    // tightly packed in the decoded format. Rows are independent, so ranges can be decoded in parallel
+    void decodeBlockRows(VkFormat format, uint32_t width, uint32_t height, const std::byte* blocks, std::byte* texels, uint32_t firstRow, uint32_t lastRow);
+}
\ No newline at end of file
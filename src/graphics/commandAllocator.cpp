@@ -0,0 +1,73 @@
+#include "commandAllocator.hpp"
+#include "profiler.hpp"
+#include <algorithm>
+namespace Graphics {
+
+    CommandAllocator::CommandAllocator(VkDevice device, uint32_t queueFamilyIndex, uint32_t framesInFlight, uint32_t contextCount) : vk_logicalDevice(device), contextCount(contextCount) {
+        if (!framesInFlight || !contextCount) throw std::runtime_error("command allocator needs at least one frame slot and context!");
+
+//------------------------------CREATE POOLS------------------------------
+        // TRANSIENT: buffers live for one frame, and without RESET_COMMAND_BUFFER the driver need not track them one by one
+        pools.resize(static_cast<size_t>(framesInFlight) * contextCount);
+        for (auto& pool : pools) {
+            VkCommandPoolCreateInfo poolInfo{};
+            poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+            poolInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+            poolInfo.queueFamilyIndex = queueFamilyIndex;
+
+            if (vkCreateCommandPool(vk_logicalDevice, &poolInfo, nullptr, &pool.vk_commandPool) != VK_SUCCESS) throw std::runtime_error("failed to create frame command pool!");
+        }
+    }
+
+//------------------------------RESET------------------------------
+    void CommandAllocator::reset(uint32_t frameSlot) {
+        PROFILE_ZONE("resetCommandPools");
+        // No RELEASE_RESOURCES: the pools keep their memory, the next frame records into it again
+        for (uint32_t context = 0; context < contextCount; context++) {
+            Pool& pool = pools[static_cast<size_t>(frameSlot) * contextCount + context];
+            if (!pool.used[0] && !pool.used[1]) continue;
+
+            if (vkResetCommandPool(vk_logicalDevice, pool.vk_commandPool, 0) != VK_SUCCESS) throw std::runtime_error("failed to reset frame command pool!");
+            pool.used = {};
+        }
+    }
+
+//------------------------------ALLOCATE------------------------------
+    VkCommandBuffer CommandAllocator::allocate(uint32_t frameSlot, uint32_t context, VkCommandBufferLevel level) {
+        Pool& pool = pools[static_cast<size_t>(frameSlot) * contextCount + context];
+        const size_t levelIndex = level == VK_COMMAND_BUFFER_LEVEL_SECONDARY ? 1 : 0;
+        auto& buffers = pool.vk_commandBuffers[levelIndex];
+        uint32_t& used = pool.used[levelIndex];
+
+        if (used == buffers.size()) {
+            // Doubling keeps the number of growth steps logarithmic in the busiest frame
+            const uint32_t growth = std::max<uint32_t>(static_cast<uint32_t>(buffers.size()), 1);
+            buffers.resize(buffers.size() + growth);
+
+            VkCommandBufferAllocateInfo allocInfo{};
+            allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+            allocInfo.commandPool = pool.vk_commandPool;
+            allocInfo.level = level;
+            allocInfo.commandBufferCount = growth;
+
+            if (vkAllocateCommandBuffers(vk_logicalDevice, &allocInfo, buffers.data() + used) != VK_SUCCESS) {
+                buffers.resize(used);
+                throw std::runtime_error("failed to allocate frame command buffers!");
+            }
+        }
+        return buffers[used++];
+    }
+
+    size_t CommandAllocator::getAllocatedCount() const {
+        size_t count = 0;
+        for (const auto& pool : pools) count += pool.vk_commandBuffers[0].size() + pool.vk_commandBuffers[1].size();
+        return count;
+    }
+
+//------------------------------DESTROY------------------------------
+    // Destroying a pool frees its buffers with it
+    CommandAllocator::~CommandAllocator() {
+        for (auto& pool : pools)
+            if (pool.vk_commandPool != VK_NULL_HANDLE) vkDestroyCommandPool(vk_logicalDevice, pool.vk_commandPool, nullptr);
+    }
+}
\ No newline at end of file
@@ -0,0 +1,44 @@
+#pragma once
+
+#include "../includes/graphics.hpp"
+#include <array>
+#include <stdexcept>
+#include <vector>
+
+namespace Graphics {
+
+    // Command buffers for one queue family, recycled per frame slot instead of per buffer. Every (frame slot, context)
+    // pair owns a TRANSIENT pool and the buffers ever allocated from it; reset() recycles the slot's pools in one call
+    // and allocate() just hands out the next buffer, so a frame costs the same however many buffers it records.
+    // A context is one recording thread: its pools are only ever touched by that thread between two resets
+    class CommandAllocator {
+
+        public:
+            CommandAllocator(VkDevice device, uint32_t queueFamilyIndex, uint32_t framesInFlight, uint32_t contextCount = 1);
+            ~CommandAllocator();
+            CommandAllocator(const CommandAllocator&) = delete;
+            CommandAllocator& operator=(const CommandAllocator&) = delete;
+
+            // Only once the slot's fence (or timeline value) has been waited on, nothing recorded from it may still be pending
+            void reset(uint32_t frameSlot);
+            // Valid until the slot's next reset. Only allocates from the driver when a frame needs more buffers than any before it
+            VkCommandBuffer allocate(uint32_t frameSlot, uint32_t context = 0, VkCommandBufferLevel level = VK_COMMAND_BUFFER_LEVEL_PRIMARY);
+
+            inline uint32_t getContextCount() const { return contextCount; }
+            // Buffers owned by every pool together, stops growing once the busiest frame has been seen
+            size_t getAllocatedCount() const;
+
+        private:
+            struct Pool {
+                VkCommandPool vk_commandPool = VK_NULL_HANDLE;
+                // Indexed by level: primaries, then secondaries
+                std::array<std::vector<VkCommandBuffer>, 2> vk_commandBuffers;
+                std::array<uint32_t, 2> used{};
+            };
+
+            VkDevice vk_logicalDevice;
+            uint32_t contextCount;
+            // frameSlot * contextCount + context
+            std::vector<Pool> pools;
+    };
+}
\ No newline at end of file
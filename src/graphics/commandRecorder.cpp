@@ -0,0 +1,47 @@
+#include "commandRecorder.hpp"
+namespace Graphics {
+
+    // Slices share nothing: each is its own allocator context, so a job never touches another slice's pools
+    CommandRecorder::CommandRecorder(VkDevice device, JobSystem& jobSystem, uint32_t queueFamilyIndex, uint32_t framesInFlight, uint32_t sliceCount) : jobSystem(jobSystem), commandAllocator(device, queueFamilyIndex, framesInFlight, sliceCount) {
+        sliceResults.resize(sliceCount);
+    }
+
+//------------------------------RECORD------------------------------
+    const std::vector<VkCommandBuffer>& CommandRecorder::record(uint32_t frameSlot, const VkCommandBufferInheritanceInfo& inheritance, uint32_t itemCount, const RecordFunction& recordItems) {
+        JobCounter counter;
+        jobSystem.parallelFor(getSliceCount(), 1, [&](uint32_t first, uint32_t last) {
+            for (uint32_t slice = first; slice < last; slice++) recordSlice(slice, frameSlot, inheritance, itemCount, recordItems);
+        }, counter);
+        jobSystem.wait(counter);
+
+        // Slices without items leave a null handle behind, only hand out what was actually recorded
+        recorded.clear();
+        for (auto commandBuffer : sliceResults) {
+            if (commandBuffer != VK_NULL_HANDLE) recorded.push_back(commandBuffer);
+        }
+        return recorded;
+    }
+
+    void CommandRecorder::recordSlice(uint32_t sliceIndex, uint32_t frameSlot, const VkCommandBufferInheritanceInfo& inheritance, uint32_t itemCount, const RecordFunction& recordItems) {
+        const uint64_t sliceCount = getSliceCount();
+        const uint32_t firstItem = static_cast<uint32_t>(itemCount * sliceIndex / sliceCount);
+        const uint32_t lastItem = static_cast<uint32_t>(itemCount * (sliceIndex + 1) / sliceCount);
+
+        sliceResults[sliceIndex] = VK_NULL_HANDLE;
+        if (firstItem == lastItem) return;
+
+        // beginFrame already recycled the slot's pools, this is a bump of the slice's cursor
+        VkCommandBuffer commandBuffer = commandAllocator.allocate(frameSlot, sliceIndex, VK_COMMAND_BUFFER_LEVEL_SECONDARY);
+
+        VkCommandBufferBeginInfo beginInfo{};
+        beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+        beginInfo.flags = VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT | VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+        beginInfo.pInheritanceInfo = &inheritance;
+
+        if (vkBeginCommandBuffer(commandBuffer, &beginInfo) != VK_SUCCESS) throw std::runtime_error("failed to begin recording secondary command buffer!");
+        recordItems(commandBuffer, firstItem, lastItem);
+        if (vkEndCommandBuffer(commandBuffer) != VK_SUCCESS) throw std::runtime_error("failed to record secondary command buffer!");
+
+        sliceResults[sliceIndex] = commandBuffer;
+    }
+}
\ No newline at end of file
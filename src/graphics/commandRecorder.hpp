@@ -0,0 +1,38 @@
+#pragma once
+
+#include "../includes/graphics.hpp"
+#include "commandAllocator.hpp"
+#include "jobSystem.hpp"
+#include <functional>
+#include <stdexcept>
+#include <vector>
+
+namespace Graphics {
+
+    // Records a draw list in parallel: the list is cut into slices that run as jobs, every slice is one context of the
+    // allocator and records into a secondary command buffer, the caller executes the results from its primary buffer.
+    // A slice's pools are only used by the one job recording that slice, whichever worker picks it up
+    class CommandRecorder {
+
+        public:
+            using RecordFunction = std::function<void(VkCommandBuffer commandBuffer, uint32_t firstItem, uint32_t lastItem)>;
+
+            CommandRecorder(VkDevice device, JobSystem& jobSystem, uint32_t queueFamilyIndex, uint32_t framesInFlight, uint32_t sliceCount);
+            CommandRecorder(const CommandRecorder&) = delete;
+            CommandRecorder& operator=(const CommandRecorder&) = delete;
+
+            // Recycles the slot's secondary buffers, once per frame after the slot's fence has been waited on
+            inline void beginFrame(uint32_t frameSlot) { commandAllocator.reset(frameSlot); }
+            // Blocks until every slice has been recorded, the frame slot's fence must already have been waited on
+            const std::vector<VkCommandBuffer>& record(uint32_t frameSlot, const VkCommandBufferInheritanceInfo& inheritance, uint32_t itemCount, const RecordFunction& recordItems);
+            inline uint32_t getSliceCount() const { return commandAllocator.getContextCount(); }
+
+        private:
+            JobSystem& jobSystem;
+            CommandAllocator commandAllocator;
+            std::vector<VkCommandBuffer> sliceResults;
+            std::vector<VkCommandBuffer> recorded;
+
+            void recordSlice(uint32_t sliceIndex, uint32_t frameSlot, const VkCommandBufferInheritanceInfo& inheritance, uint32_t itemCount, const RecordFunction& recordItems);
+    };
+}
@@ -0,0 +1,43 @@
+#include "deletionQueue.hpp"
+namespace Graphics {
+
+//------------------------------PUSH------------------------------
+    void DeletionQueue::push(uint64_t lastUsedFrame, std::function<void()> destroy) {
+        std::lock_guard<std::mutex> lock(mutex);
+        pending.push_back({lastUsedFrame, std::move(destroy)});
+    }
+
+//------------------------------FLUSH------------------------------
+    void DeletionQueue::flush(uint64_t completedFrame) {
+        // Entries are pushed in frame order, so everything retired by a finished frame sits at the front. They run
+        // outside the lock, a destroy that lets go of another handle retires into this queue again
+        std::vector<Entry> finished;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            while (!pending.empty() && pending.front().lastUsedFrame <= completedFrame) {
+                finished.push_back(std::move(pending.front()));
+                pending.pop_front();
+            }
+        }
+        for (auto& entry : finished) entry.destroy();
+    }
+
+    void DeletionQueue::flushAll() {
+        std::deque<Entry> finished;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            finished.swap(pending);
+        }
+        for (auto& entry : finished) entry.destroy();
+    }
+
+    size_t DeletionQueue::size() {
+        std::lock_guard<std::mutex> lock(mutex);
+        return pending.size();
+    }
+
+//------------------------------DESTROY------------------------------
+    DeletionQueue::~DeletionQueue() {
+        flushAll();
+    }
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <vector>
+
+namespace Graphics {
+
+    // Vulkan objects that may still be referenced by in-flight frames are retired here with the number of the
+    // last frame that used them, and destroyed once the renderer knows that frame has finished on the GPU.
+    // Any thread may retire, flushing belongs to the thread that tracks frame completion
+    class DeletionQueue {
+
+        public:
+            ~DeletionQueue();
+
+            void push(uint64_t lastUsedFrame, std::function<void()> destroy);
+            // Retires with the frame being recorded, between frames that is the last one submitted
+            inline void retire(std::function<void()> destroy) { push(recordingFrame.load(std::memory_order_relaxed), std::move(destroy)); }
+            // Set by the renderer before it records a frame
+            inline void setRecordingFrame(uint64_t frame) { recordingFrame.store(frame, std::memory_order_relaxed); }
+            void flush(uint64_t completedFrame);
+            void flushAll();
+            size_t size();
+
+        private:
+            struct Entry {
+                uint64_t lastUsedFrame;
+                std::function<void()> destroy;
+            };
+
+            std::mutex mutex;
+            std::deque<Entry> pending;
+            std::atomic<uint64_t> recordingFrame = 0;
+    };
+}
@@ -1,11 +1,22 @@
 #include "device.hpp"
+#include "profiler.hpp"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#endif
 
 namespace Graphics {
 
-    Device::Device(VkInstance instance, VkSurfaceKHR surface, const bool enableValidationLayers, const std::vector<const char*>& validationLayers) {
+    Device::Device(VkInstance instance, VkSurfaceKHR surface, const bool enableValidationLayers, const std::vector<const char*>& validationLayers, uint32_t apiVersion, const std::string& selectionCache, bool features2Supported) {
 
 //------------------------------CREATE PHYSICAL DEVICE------------------------------
 
+        // Without a surface (offscreen headless mode) there is nothing to present to, so the swapchain extension is optional
+        if (surface != VK_NULL_HANDLE) deviceExtensions.push_back(VK_KHR_SWAPCHAIN_EXTENSION_NAME);
+
+        selection.span.start = std::chrono::steady_clock::now();
         uint32_t deviceCount;
         vkEnumeratePhysicalDevices(instance, &deviceCount, nullptr);
         if (!deviceCount) {
@@ -13,24 +24,115 @@ namespace Graphics {
         }
         std::vector<VkPhysicalDevice> devices(deviceCount);
         vkEnumeratePhysicalDevices(instance, &deviceCount, devices.data());
+        selection.candidates = deviceCount;
+
+        // Every device is rated once, the queue layout found on the way is kept for the logical device and swapchain
+        if (!selectionCache.empty()) selection.cacheHit = loadSelectionCache(selectionCache, devices, surface);
+        if (!selection.cacheHit) {
+            for (const auto& device : devices) {
+                QueueFamilyIndices indices;
+                const int64_t score = rateDevice(device, surface, indices);
+                if (score < 0) continue;
+
+                selection.suitable++;
+                if (vk_physicalDevice == VK_NULL_HANDLE || score > selection.score) {
+                    vk_physicalDevice = device;
+                    queueFamilyIndices = indices;
+                    selection.score = score;
+                }
+            }
 
-        for (const auto& device : devices) {
-            if (isDeviceSuitable(device, surface)) {
-                vk_physicalDevice = device;
-                break;
+            if (vk_physicalDevice == VK_NULL_HANDLE) {
+                throw std::runtime_error("Failed to find a suitable GPU!");
             }
         }
 
-        if (vk_physicalDevice == VK_NULL_HANDLE) {
-            throw std::runtime_error("Failed to find a suitable GPU!");
+        vkGetPhysicalDeviceProperties(vk_physicalDevice, &vk_physicalDeviceProperties);
+        if (!selectionCache.empty() && !selection.cacheHit) saveSelectionCache(selectionCache, deviceCount, surface != VK_NULL_HANDLE);
+        selection.span.end = std::chrono::steady_clock::now();
+
+//------------------------------QUERY VULKAN 1.2 FEATURES------------------------------
+
+        // Core on 1.1 and later, the KHR alias on a 1.0 instance that enabled VK_KHR_get_physical_device_properties2
+        PFN_vkGetPhysicalDeviceFeatures2 getFeatures2 = nullptr;
+        if (features2Supported) getFeatures2 = reinterpret_cast<PFN_vkGetPhysicalDeviceFeatures2>(vkGetInstanceProcAddr(instance, apiVersion >= VK_API_VERSION_1_1 ? "vkGetPhysicalDeviceFeatures2" : "vkGetPhysicalDeviceFeatures2KHR"));
+
+        if (getFeatures2 && apiVersion >= VK_API_VERSION_1_2 && vk_physicalDeviceProperties.apiVersion >= VK_API_VERSION_1_2) {
+            VkPhysicalDeviceVulkan12Features supportedFeatures12{};
+            supportedFeatures12.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES;
+
+            VkPhysicalDeviceFeatures2 supportedFeatures{};
+            supportedFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+            supportedFeatures.pNext = &supportedFeatures12;
+
+            getFeatures2(vk_physicalDevice, &supportedFeatures);
+            timelineSemaphoresSupported = supportedFeatures12.timelineSemaphore == VK_TRUE;
+            updateAfterBindSupported = supportedFeatures12.descriptorBindingPartiallyBound == VK_TRUE &&
+                                       supportedFeatures12.descriptorBindingStorageBufferUpdateAfterBind == VK_TRUE &&
+                                       supportedFeatures12.descriptorBindingSampledImageUpdateAfterBind == VK_TRUE;
         }
 
+//------------------------------QUERY PRESENT WAIT------------------------------
+
+        // Present id and present wait only count together, the frame pacer needs an id to wait on. Neither needs Vulkan 1.2
+        const bool presentExtensions = surface != VK_NULL_HANDLE && hasDeviceExtension(vk_physicalDevice, VK_KHR_PRESENT_ID_EXTENSION_NAME) && hasDeviceExtension(vk_physicalDevice, VK_KHR_PRESENT_WAIT_EXTENSION_NAME);
+        if (getFeatures2 && presentExtensions) {
+            VkPhysicalDevicePresentWaitFeaturesKHR supportedPresentWait{};
+            supportedPresentWait.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PRESENT_WAIT_FEATURES_KHR;
+            VkPhysicalDevicePresentIdFeaturesKHR supportedPresentId{};
+            supportedPresentId.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PRESENT_ID_FEATURES_KHR;
+            supportedPresentId.pNext = &supportedPresentWait;
+
+            VkPhysicalDeviceFeatures2 supportedFeatures{};
+            supportedFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+            supportedFeatures.pNext = &supportedPresentId;
+
+            getFeatures2(vk_physicalDevice, &supportedFeatures);
+            presentWaitSupported = supportedPresentId.presentId == VK_TRUE && supportedPresentWait.presentWait == VK_TRUE;
+        }
+        // GPU timestamps are only usable if the graphics queue actually writes meaningful bits
+        uint32_t queueFamilyCount;
+        vkGetPhysicalDeviceQueueFamilyProperties(vk_physicalDevice, &queueFamilyCount, nullptr);
+        std::vector<VkQueueFamilyProperties> queueFamilies(queueFamilyCount);
+        vkGetPhysicalDeviceQueueFamilyProperties(vk_physicalDevice, &queueFamilyCount, queueFamilies.data());
+        timestampValidBits = queueFamilies[queueFamilyIndices.graphicsFamily.value()].timestampValidBits;
+        timestampsSupported = timestampValidBits > 0 && vk_physicalDeviceProperties.limits.timestampPeriod > 0.0f;
+
+        if (presentWaitSupported) {
+            deviceExtensions.push_back(VK_KHR_PRESENT_ID_EXTENSION_NAME);
+            deviceExtensions.push_back(VK_KHR_PRESENT_WAIT_EXTENSION_NAME);
+        }
+
+        // Calibration needs the GPU clock and the host clock std::chrono::steady_clock runs on in the same call
+        if (timestampsSupported && hasDeviceExtension(vk_physicalDevice, VK_EXT_CALIBRATED_TIMESTAMPS_EXTENSION_NAME)) {
+            auto vkGetPhysicalDeviceCalibrateableTimeDomainsEXT = reinterpret_cast<PFN_vkGetPhysicalDeviceCalibrateableTimeDomainsEXT>(vkGetInstanceProcAddr(instance, "vkGetPhysicalDeviceCalibrateableTimeDomainsEXT"));
+            uint32_t domainCount = 0;
+            if (vkGetPhysicalDeviceCalibrateableTimeDomainsEXT) vkGetPhysicalDeviceCalibrateableTimeDomainsEXT(vk_physicalDevice, &domainCount, nullptr);
+            std::vector<VkTimeDomainEXT> domains(domainCount);
+            if (domainCount) vkGetPhysicalDeviceCalibrateableTimeDomainsEXT(vk_physicalDevice, &domainCount, domains.data());
+            calibratedTimestampsSupported = std::find(domains.begin(), domains.end(), VK_TIME_DOMAIN_DEVICE_EXT) != domains.end() &&
+                                            std::find(domains.begin(), domains.end(), HOST_TIME_DOMAIN) != domains.end();
+        }
+        if (calibratedTimestampsSupported) deviceExtensions.push_back(VK_EXT_CALIBRATED_TIMESTAMPS_EXTENSION_NAME);
+
+        // The bindless table is indexed with push constants, every device it can run on has to allow that
+        deviceFeatures.shaderStorageBufferArrayDynamicIndexing = VK_TRUE;
+        deviceFeatures.shaderSampledImageArrayDynamicIndexing = VK_TRUE;
+
+        // Block-compressed textures are uploaded as is where the GPU samples them, the texture loader decodes them otherwise
+        VkPhysicalDeviceFeatures supportedFeatures;
+        vkGetPhysicalDeviceFeatures(vk_physicalDevice, &supportedFeatures);
+        deviceFeatures.textureCompressionBC = supportedFeatures.textureCompressionBC;
+
 //------------------------------CREATE LOGICAL DEVICE------------------------------
 
-        QueueFamilyIndices indices = findQueueFamilies(vk_physicalDevice, surface);
+        const QueueFamilyIndices& indices = queueFamilyIndices;
         float queuePriority = 1.0f;
         std::vector<VkDeviceQueueCreateInfo> queueInfos;
-        std::set<uint32_t> uniqueQueueFamilies = {indices.graphicsFamily.value(), indices.presentFamily.value()};
+        std::set<uint32_t> uniqueQueueFamilies = {indices.graphicsFamily.value()};
+        if (indices.presentFamily.has_value()) uniqueQueueFamilies.insert(indices.presentFamily.value());
+        uniqueQueueFamilies.insert(indices.transferFamily.value());
+        uniqueQueueFamilies.insert(indices.computeFamily.value());
 
         for (uint32_t queueFamily : uniqueQueueFamilies) {
 
@@ -51,6 +153,27 @@ namespace Graphics {
         deviceInfo.enabledExtensionCount = static_cast<uint32_t>(deviceExtensions.size());
         deviceInfo.ppEnabledExtensionNames = deviceExtensions.data();
         deviceInfo.pEnabledFeatures = &deviceFeatures;
+
+        VkPhysicalDeviceVulkan12Features features12{};
+        features12.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES;
+        features12.timelineSemaphore = timelineSemaphoresSupported;
+        features12.descriptorBindingPartiallyBound = updateAfterBindSupported;
+        features12.descriptorBindingStorageBufferUpdateAfterBind = updateAfterBindSupported;
+        features12.descriptorBindingSampledImageUpdateAfterBind = updateAfterBindSupported;
+        if (timelineSemaphoresSupported || updateAfterBindSupported) deviceInfo.pNext = &features12;
+
+        // Chained in front of whatever is already there, the 1.2 struct is there or not independently
+        VkPhysicalDevicePresentWaitFeaturesKHR presentWaitFeatures{};
+        presentWaitFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PRESENT_WAIT_FEATURES_KHR;
+        presentWaitFeatures.presentWait = VK_TRUE;
+        VkPhysicalDevicePresentIdFeaturesKHR presentIdFeatures{};
+        presentIdFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PRESENT_ID_FEATURES_KHR;
+        presentIdFeatures.presentId = VK_TRUE;
+        presentIdFeatures.pNext = &presentWaitFeatures;
+        if (presentWaitSupported) {
+            presentWaitFeatures.pNext = const_cast<void*>(deviceInfo.pNext);
+            deviceInfo.pNext = &presentIdFeatures;
+        }
         deviceInfo.ppEnabledExtensionNames = deviceExtensions.data();
 
         if (enableValidationLayers) {
@@ -62,15 +185,26 @@ namespace Graphics {
 
         if(vkCreateDevice(vk_physicalDevice, &deviceInfo, nullptr, &vk_logicalDevice) != VK_SUCCESS) throw std::runtime_error("failed to create device!");
 
+        allocator = std::make_unique<Allocator>(vk_physicalDevice, vk_logicalDevice);
+
         vkGetDeviceQueue(vk_logicalDevice, indices.graphicsFamily.value(), 0, &vk_graphicsQueue);
-        vkGetDeviceQueue(vk_logicalDevice, indices.presentFamily.value(), 0, &vk_presentQueue);
+
+        if (indices.presentFamily.has_value()) vkGetDeviceQueue(vk_logicalDevice, indices.presentFamily.value(), 0, &vk_presentQueue);
+        vkGetDeviceQueue(vk_logicalDevice, indices.transferFamily.value(), 0, &vk_transferQueue);
+        vkGetDeviceQueue(vk_logicalDevice, indices.computeFamily.value(), 0, &vk_computeQueue);
+
+        if (presentWaitSupported) vk_waitForPresent = reinterpret_cast<PFN_vkWaitForPresentKHR>(vkGetDeviceProcAddr(vk_logicalDevice, "vkWaitForPresentKHR"));
+        presentWaitSupported = vk_waitForPresent != nullptr;
+        if (calibratedTimestampsSupported) vk_getCalibratedTimestamps = reinterpret_cast<PFN_vkGetCalibratedTimestampsEXT>(vkGetDeviceProcAddr(vk_logicalDevice, "vkGetCalibratedTimestampsEXT"));
+        calibratedTimestampsSupported = vk_getCalibratedTimestamps != nullptr;
     }
 
 //------------------------------CREATE QUEUE FAMILIES------------------------------
 
     QueueFamilyIndices Device::findQueueFamilies(VkPhysicalDevice device, VkSurfaceKHR surface) {
         QueueFamilyIndices indices;
-        VkBool32 presentSupport;
+        VkBool32 presentSupport = VK_FALSE;
+        bool requirePresent = surface != VK_NULL_HANDLE;
 
         uint32_t queueFamilyCount;
         vkGetPhysicalDeviceQueueFamilyProperties(device, &queueFamilyCount, nullptr);
@@ -80,30 +214,36 @@ namespace Graphics {
         int i = 0;
         for (const auto& queueFamily : queueFamilies) {
 
-            vkGetPhysicalDeviceSurfaceSupportKHR(device, i, surface, &presentSupport);
+            if (requirePresent) vkGetPhysicalDeviceSurfaceSupportKHR(device, i, surface, &presentSupport);
 
-            if(queueFamily.queueFlags & VK_QUEUE_GRAPHICS_BIT)  indices.graphicsFamily = i;
-            if (presentSupport) indices.presentFamily = i;
-            if(indices.isComplete()) break;
+            if(queueFamily.queueFlags & VK_QUEUE_GRAPHICS_BIT && !indices.graphicsFamily.has_value())  indices.graphicsFamily = i;
+            // Presenting from the graphics family keeps the swapchain images exclusive to one family
+            if (presentSupport && (!indices.presentFamily.has_value() || indices.graphicsFamily == static_cast<uint32_t>(i))) indices.presentFamily = i;
+            if ((queueFamily.queueFlags & VK_QUEUE_TRANSFER_BIT) && !(queueFamily.queueFlags & (VK_QUEUE_GRAPHICS_BIT | VK_QUEUE_COMPUTE_BIT)) && !indices.transferFamily.has_value()) indices.transferFamily = i;
+            if ((queueFamily.queueFlags & VK_QUEUE_COMPUTE_BIT) && !(queueFamily.queueFlags & VK_QUEUE_GRAPHICS_BIT) && !indices.computeFamily.has_value()) indices.computeFamily = i;
             
             i++;
         }
 
+        // Graphics queues always support transfers, so uploads fall back to them without a dedicated family
+        if (!indices.transferFamily.has_value()) indices.transferFamily = indices.graphicsFamily;
+        // Devices always expose a family with both graphics and compute, so compute work then shares the graphics queue
+        if (!indices.computeFamily.has_value()) indices.computeFamily = indices.graphicsFamily;
+
         return indices;
     }
 //------------------------------CREATE SWAP CHAIN------------------------------
 
-    void Device::createSwapChain(GLFWwindow* window, VkSurfaceKHR surface) {
+    void Device::createSwapChain(GLFWwindow* window, VkSurfaceKHR surface, VkExtent2D windowlessExtent) {
+        PROFILE_ZONE("createSwapChain");
         SwapChainSupportDetails swapChainSupport = querySwapChainSupport(vk_physicalDevice, surface);
-        uint32_t imageCount = swapChainSupport.capabilities.minImageCount + 1;
-        QueueFamilyIndices indices = findQueueFamilies(vk_physicalDevice, surface);
-        uint32_t queueFamilyIndices[] = {indices.graphicsFamily.value(), indices.presentFamily.value()};
+        const QueueFamilyIndices& indices = queueFamilyIndices;
+        uint32_t sharedFamilies[] = {indices.graphicsFamily.value(), indices.presentFamily.value()};
 
         VkSurfaceFormatKHR surfaceFormat = chooseSwapSurfaceFormat(swapChainSupport.format);
         VkPresentModeKHR presentMode = chooseSwapPresentMode(swapChainSupport.present);
-        VkExtent2D extent = chooseSwapExtent(swapChainSupport.capabilities, window);
-
-        if (swapChainSupport.capabilities.maxImageCount > 0 && imageCount > swapChainSupport.capabilities.maxImageCount) imageCount = swapChainSupport.capabilities.maxImageCount;
+        VkExtent2D extent = chooseSwapExtent(swapChainSupport.capabilities, window, windowlessExtent);
+        uint32_t imageCount = chooseSwapImageCount(swapChainSupport.capabilities, presentMode);
 
         VkSwapchainCreateInfoKHR swapChainInfo{};
         swapChainInfo.sType = VK_STRUCTURE_TYPE_SWAPCHAIN_CREATE_INFO_KHR;
@@ -118,7 +258,7 @@ namespace Graphics {
         if (indices.graphicsFamily != indices.presentFamily) {
             swapChainInfo.imageSharingMode = VK_SHARING_MODE_CONCURRENT;
             swapChainInfo.queueFamilyIndexCount = 2;
-            swapChainInfo.pQueueFamilyIndices = queueFamilyIndices;
+            swapChainInfo.pQueueFamilyIndices = sharedFamilies;
         } else {
             swapChainInfo.imageSharingMode = VK_SHARING_MODE_EXCLUSIVE;
             swapChainInfo.queueFamilyIndexCount = 0;
@@ -129,9 +269,12 @@ namespace Graphics {
         swapChainInfo.compositeAlpha = VK_COMPOSITE_ALPHA_OPAQUE_BIT_KHR;
         swapChainInfo.clipped = VK_TRUE;
         swapChainInfo.presentMode = presentMode;
-        swapChainInfo.oldSwapchain = VK_NULL_HANDLE;
+        // Lets the driver reuse resources of the swapchain being replaced, the old one is retired by the caller
+        swapChainInfo.oldSwapchain = vk_swapChain;
 
-        if (vkCreateSwapchainKHR(vk_logicalDevice, &swapChainInfo, nullptr, &vk_swapChain) != VK_SUCCESS) throw std::runtime_error("failed to create swap chain!");
+        VkSwapchainKHR swapChain;
+        if (vkCreateSwapchainKHR(vk_logicalDevice, &swapChainInfo, nullptr, &swapChain) != VK_SUCCESS) throw std::runtime_error("failed to create swap chain!");
+        vk_swapChain = swapChain;
 
         vkGetSwapchainImagesKHR(vk_logicalDevice, vk_swapChain, &imageCount, nullptr);
         vk_swapChainImages.resize(imageCount);
@@ -139,6 +282,9 @@ namespace Graphics {
 
         vk_swapChainImageFormat = surfaceFormat.format;
         vk_swapChainExtent = extent;
+        vk_presentMode = presentMode;
+
+        std::cout << "Swap chain: " << presentProfileName(presentProfile) << " profile, " << presentModeName(presentMode) << ", " << imageCount << " images (" << extent.width << "x" << extent.height << ")" << std::endl;
     }
 
 //------------------------------CREATE IMAGE VIEWS------------------------------
@@ -167,6 +313,49 @@ namespace Graphics {
         }
     }
 
+//------------------------------RECREATE SWAP CHAIN------------------------------
+
+    RetiredSwapChain Device::recreateSwapChain(GLFWwindow* window, VkSurfaceKHR surface, VkExtent2D windowlessExtent) {
+        PROFILE_ZONE("recreateSwapChain");
+        RetiredSwapChain retired;
+        retired.swapChain = vk_swapChain;
+        retired.imageViews = std::move(vk_swapChainImageViews);
+        vk_swapChainImageViews.clear();
+
+        createSwapChain(window, surface, windowlessExtent);
+        createImageViews();
+        return retired;
+    }
+
+//------------------------------CREATE OFFSCREEN TARGETS------------------------------
+
+    void Device::createOffscreenTargets(VkExtent2D extent, VkFormat format, uint32_t count) {
+        vk_swapChainImages.resize(count);
+        offscreenImages.resize(count);
+
+        for (uint32_t i = 0; i < count; i++) {
+            VkImageCreateInfo imageInfo{};
+            imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+            imageInfo.imageType = VK_IMAGE_TYPE_2D;
+            imageInfo.format = format;
+            imageInfo.extent = {extent.width, extent.height, 1};
+            imageInfo.mipLevels = 1;
+            imageInfo.arrayLayers = 1;
+            imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+            imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+            imageInfo.usage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+            imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+            imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+
+            offscreenImages[i] = allocator->createImage(imageInfo, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+            vk_swapChainImages[i] = offscreenImages[i].image;
+        }
+
+        vk_swapChainImageFormat = format;
+        vk_swapChainExtent = extent;
+        createImageViews();
+    }
+
 //------------------------------QUERY SWAP CHAIN SUPPORT------------------------------
 
     SwapChainSupportDetails Device::querySwapChainSupport(VkPhysicalDevice device, VkSurfaceKHR surface) {
@@ -205,18 +394,201 @@ namespace Graphics {
         return requiredExtensions.empty();
     }
 
-//------------------------------CHECK IS DEVICE SUITABLE------------------------------
+    bool Device::hasDeviceExtension(VkPhysicalDevice device, const char* name) {
+        uint32_t extensionCount;
+        vkEnumerateDeviceExtensionProperties(device, nullptr, &extensionCount, nullptr);
+        std::vector<VkExtensionProperties> availableProperties(extensionCount);
+        vkEnumerateDeviceExtensionProperties(device, nullptr, &extensionCount, availableProperties.data());
+
+        for (const auto& extension : availableProperties) if (std::strcmp(extension.extensionName, name) == 0) return true;
+        return false;
+    }
+
+//------------------------------WAIT FOR PRESENT------------------------------
 
-    bool Device::isDeviceSuitable(VkPhysicalDevice device, VkSurfaceKHR surface) {
-        bool extensionsSupported = checkDeviceExtensionSupport(device);
+    VkResult Device::waitForPresent(uint64_t presentId, uint64_t timeout) {
+        return vk_waitForPresent(vk_logicalDevice, vk_swapChain, presentId, timeout);
+    }
 
-        bool swapChainAdequate;
-        if (extensionsSupported) {
+//------------------------------CALIBRATED TIMESTAMPS------------------------------
+
+    bool Device::getCalibratedTimestamps(uint64_t& deviceTicks, int64_t& hostNs) {
+        if (!calibratedTimestampsSupported) return false;
+
+        VkCalibratedTimestampInfoEXT infos[2]{};
+        infos[0].sType = VK_STRUCTURE_TYPE_CALIBRATED_TIMESTAMP_INFO_EXT;
+        infos[0].timeDomain = VK_TIME_DOMAIN_DEVICE_EXT;
+        infos[1].sType = VK_STRUCTURE_TYPE_CALIBRATED_TIMESTAMP_INFO_EXT;
+        infos[1].timeDomain = HOST_TIME_DOMAIN;
+        uint64_t timestamps[2];
+        uint64_t maxDeviation;
+        if (vk_getCalibratedTimestamps(vk_logicalDevice, 2, infos, timestamps, &maxDeviation) != VK_SUCCESS) return false;
+
+        deviceTicks = timestamps[0];
+#ifdef _WIN32
+        // Performance counter ticks, steady_clock counts the same ticks in nanoseconds
+        LARGE_INTEGER frequency;
+        QueryPerformanceFrequency(&frequency);
+        const uint64_t counter = timestamps[1];
+        const uint64_t ticksPerSecond = static_cast<uint64_t>(frequency.QuadPart);
+        hostNs = static_cast<int64_t>(counter / ticksPerSecond * 1'000'000'000 + counter % ticksPerSecond * 1'000'000'000 / ticksPerSecond);
+#else
+        hostNs = static_cast<int64_t>(timestamps[1]);
+#endif
+        return true;
+    }
+
+//------------------------------RATE DEVICE------------------------------
+
+    int64_t Device::rateDevice(VkPhysicalDevice device, VkSurfaceKHR surface, QueueFamilyIndices& indices) {
+        bool requirePresent = surface != VK_NULL_HANDLE;
+
+        indices = findQueueFamilies(device, surface);
+        if (!indices.isComplete(requirePresent) || !checkDeviceExtensionSupport(device)) return -1;
+
+        // The bindless table is indexed with push constants
+        VkPhysicalDeviceFeatures supportedFeatures;
+        vkGetPhysicalDeviceFeatures(device, &supportedFeatures);
+        if (!supportedFeatures.shaderStorageBufferArrayDynamicIndexing || !supportedFeatures.shaderSampledImageArrayDynamicIndexing) return -1;
+
+        if (requirePresent) {
             SwapChainSupportDetails swapChainSupport = querySwapChainSupport(device, surface);
-            swapChainAdequate = !swapChainSupport.format.empty() && !swapChainSupport.present.empty();
+            if (swapChainSupport.format.empty() || swapChainSupport.present.empty()) return -1;
+        }
+
+        VkPhysicalDeviceProperties properties;
+        vkGetPhysicalDeviceProperties(device, &properties);
+
+        // The device type outweighs everything else, a discrete GPU wins even with the worst queue layout
+        int64_t score = 0;
+        if (properties.deviceType == VK_PHYSICAL_DEVICE_TYPE_DISCRETE_GPU) score += 100000;
+        else if (properties.deviceType == VK_PHYSICAL_DEVICE_TYPE_INTEGRATED_GPU) score += 50000;
+        else if (properties.deviceType == VK_PHYSICAL_DEVICE_TYPE_VIRTUAL_GPU) score += 20000;
+
+        // Dedicated families let uploads and culling overlap the graphics queue
+        if (indices.transferFamily != indices.graphicsFamily) score += 1000;
+        if (indices.computeFamily != indices.graphicsFamily) score += 1000;
+        if (requirePresent && indices.presentFamily == indices.graphicsFamily) score += 500;
+        if (supportedFeatures.textureCompressionBC) score += 500;
+
+        // Between otherwise equal devices the one with more device local memory, in MiB
+        VkPhysicalDeviceMemoryProperties memoryProperties;
+        vkGetPhysicalDeviceMemoryProperties(device, &memoryProperties);
+        VkDeviceSize deviceLocalBytes = 0;
+        for (uint32_t i = 0; i < memoryProperties.memoryHeapCount; i++) {
+            if (memoryProperties.memoryHeaps[i].flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT) deviceLocalBytes += memoryProperties.memoryHeaps[i].size;
+        }
+        return score + static_cast<int64_t>(std::min<VkDeviceSize>(deviceLocalBytes >> 20, 999));
+    }
+
+//------------------------------SELECTION CACHE------------------------------
+
+    static std::string uuidString(const uint8_t* uuid) {
+        static constexpr char DIGITS[] = "0123456789abcdef";
+        std::string text;
+        for (uint32_t i = 0; i < VK_UUID_SIZE; i++) {
+            text += DIGITS[uuid[i] >> 4];
+            text += DIGITS[uuid[i] & 0xF];
+        }
+        return text;
+    }
+
+    bool Device::loadSelectionCache(const std::filesystem::path& path, const std::vector<VkPhysicalDevice>& devices, VkSurfaceKHR surface) {
+        std::ifstream file(path);
+        if (!file.is_open()) return false;
+        nlohmann::json cache = nlohmann::json::parse(file, nullptr, false);
+        if (cache.is_discarded() || !cache.is_object()) return false;
+
+        // A hand-edited or stale file may hold a key of the wrong type, that is a miss like any other
+        try {
+            // A device added or removed since the last launch may change the choice, so it is rated again
+            const bool requirePresent = surface != VK_NULL_HANDLE;
+            if (cache.value("deviceCount", 0u) != devices.size() || cache.value("present", !requirePresent) != requirePresent) return false;
+
+            for (const auto& device : devices) {
+                VkPhysicalDeviceProperties properties;
+                vkGetPhysicalDeviceProperties(device, &properties);
+                if (properties.vendorID != cache.value("vendorID", 0u) || properties.deviceID != cache.value("deviceID", 0u) ||
+                    properties.driverVersion != cache.value("driverVersion", 0u) || uuidString(properties.pipelineCacheUUID) != cache.value("uuid", std::string())) continue;
+
+                // Same GPU and driver, so features and extensions are what they were. Only the families are checked again
+                uint32_t queueFamilyCount;
+                vkGetPhysicalDeviceQueueFamilyProperties(device, &queueFamilyCount, nullptr);
+                QueueFamilyIndices indices;
+                indices.graphicsFamily = cache.value("graphicsFamily", UINT32_MAX);
+                indices.transferFamily = cache.value("transferFamily", UINT32_MAX);
+                indices.computeFamily = cache.value("computeFamily", UINT32_MAX);
+                if (requirePresent) indices.presentFamily = cache.value("presentFamily", UINT32_MAX);
+                for (const auto& family : {indices.graphicsFamily, indices.presentFamily, indices.transferFamily, indices.computeFamily}) {
+                    if (family.has_value() && family.value() >= queueFamilyCount) return false;
+                }
+
+                // The surface is new every launch
+                if (requirePresent) {
+                    VkBool32 presentSupport = VK_FALSE;
+                    vkGetPhysicalDeviceSurfaceSupportKHR(device, indices.presentFamily.value(), surface, &presentSupport);
+                    if (!presentSupport) return false;
+                }
+
+                // Read before anything is assigned, a throw here must leave the device unselected
+                const int64_t score = cache.value("score", int64_t(0));
+                vk_physicalDevice = device;
+                queueFamilyIndices = indices;
+                selection.suitable = 1;
+                selection.score = score;
+                return true;
+            }
+        } catch (const nlohmann::json::exception&) {
+            return false;
         }
+        return false;
+    }
 
-        return findQueueFamilies(device, surface).isComplete() && extensionsSupported && swapChainAdequate;
+    void Device::saveSelectionCache(const std::filesystem::path& path, uint32_t deviceCount, bool present) {
+        nlohmann::json cache;
+        cache["deviceName"] = vk_physicalDeviceProperties.deviceName;
+        cache["vendorID"] = vk_physicalDeviceProperties.vendorID;
+        cache["deviceID"] = vk_physicalDeviceProperties.deviceID;
+        cache["driverVersion"] = vk_physicalDeviceProperties.driverVersion;
+        cache["uuid"] = uuidString(vk_physicalDeviceProperties.pipelineCacheUUID);
+        cache["deviceCount"] = deviceCount;
+        cache["present"] = present;
+        cache["score"] = selection.score;
+        cache["graphicsFamily"] = queueFamilyIndices.graphicsFamily.value();
+        if (present) cache["presentFamily"] = queueFamilyIndices.presentFamily.value();
+        cache["transferFamily"] = queueFamilyIndices.transferFamily.value();
+        cache["computeFamily"] = queueFamilyIndices.computeFamily.value();
+
+        // Same as the pipeline cache: write next to the real file and rename, a failed write only costs a cache miss.
+        // Runs inside the constructor, so nothing here may throw
+        std::error_code error;
+        if (path.has_parent_path()) std::filesystem::create_directories(path.parent_path(), error);
+        if (error) {
+            std::cerr << "Failed to create device cache directory " << path.parent_path().string() << ": " << error.message() << "\n";
+            return;
+        }
+        std::filesystem::path tempPath = path;
+        tempPath += ".tmp";
+        {
+            std::ofstream file(tempPath, std::ios::trunc);
+            if (!file.is_open()) {
+                std::cerr << "Failed to write device cache " << tempPath.string() << "\n";
+                return;
+            }
+            // A driver-reported name that isn't valid UTF-8 is written with replacement characters instead of throwing
+            file << cache.dump(4, ' ', false, nlohmann::json::error_handler_t::replace) << "\n";
+            if (!file) {
+                file.close();
+                std::cerr << "Failed to write device cache " << tempPath.string() << "\n";
+                std::filesystem::remove(tempPath, error);
+                return;
+            }
+        }
+        std::filesystem::rename(tempPath, path, error);
+        if (error) {
+            std::cerr << "Failed to replace device cache " << path.string() << ": " << error.message() << "\n";
+            std::filesystem::remove(tempPath, error);
+        }
     }
 
 //------------------------------CHOOSE SWAP SURFACE FORMAT------------------------------
@@ -233,25 +605,59 @@ namespace Graphics {
 //------------------------------CHOOSE SWAP CHAIN MODE------------------------------
 
     VkPresentModeKHR Device::chooseSwapPresentMode(const std::vector<VkPresentModeKHR>& availablePresentModes) {
-        for (const auto& availablePresentMode : availablePresentModes) {
-            if (availablePresentMode == VK_PRESENT_MODE_MAILBOX_KHR) return availablePresentMode;
+        // FIFO is the only mode every surface must support, so it ends every preference list
+        std::vector<VkPresentModeKHR> preferred;
+        switch (presentProfile) {
+            case PresentProfile::LowLatency:
+                preferred = {VK_PRESENT_MODE_IMMEDIATE_KHR, VK_PRESENT_MODE_MAILBOX_KHR, VK_PRESENT_MODE_FIFO_RELAXED_KHR};
+                break;
+            case PresentProfile::Throughput:
+                preferred = {VK_PRESENT_MODE_MAILBOX_KHR, VK_PRESENT_MODE_IMMEDIATE_KHR};
+                break;
+            case PresentProfile::PowerSaving:
+                // Relaxed still caps at the refresh rate but shows a late frame right away instead of holding it a whole interval
+                preferred = {VK_PRESENT_MODE_FIFO_RELAXED_KHR};
+                break;
+        }
+
+        for (VkPresentModeKHR mode : preferred) {
+            if (std::find(availablePresentModes.begin(), availablePresentModes.end(), mode) != availablePresentModes.end()) return mode;
         }
 
         return VK_PRESENT_MODE_FIFO_KHR;
     }
 
+//------------------------------CHOOSE SWAP IMAGE COUNT------------------------------
+
+    uint32_t Device::chooseSwapImageCount(const VkSurfaceCapabilitiesKHR& capabilities, VkPresentModeKHR presentMode) {
+        uint32_t imageCount = capabilities.minImageCount + 1;
+
+        if (presentProfile == PresentProfile::LowLatency) {
+            // Mailbox needs a spare image to replace, without one it degrades to FIFO behaviour
+            imageCount = capabilities.minImageCount + (presentMode == VK_PRESENT_MODE_MAILBOX_KHR ? 1 : 0);
+        }
+        else if (presentProfile == PresentProfile::Throughput) imageCount = capabilities.minImageCount + 2;
+
+        if (capabilities.maxImageCount > 0 && imageCount > capabilities.maxImageCount) imageCount = capabilities.maxImageCount;
+        return imageCount;
+    }
+
 //------------------------------CHOOSE SWAP CHAIN------------------------------
 
-    VkExtent2D Device::chooseSwapExtent(const VkSurfaceCapabilitiesKHR& capabilities, GLFWwindow* window) {
+    VkExtent2D Device::chooseSwapExtent(const VkSurfaceCapabilitiesKHR& capabilities, GLFWwindow* window, VkExtent2D windowlessExtent) {
         if (capabilities.currentExtent.width != std::numeric_limits<uint32_t>::max()) {return capabilities.currentExtent;}
         else {
-            int width, height;
-            glfwGetFramebufferSize(window, &width, &height);
+            VkExtent2D actualExtent = windowlessExtent;
 
-            VkExtent2D actualExtent = {
-            static_cast<uint32_t>(width),
-            static_cast<uint32_t>(height)
-            };
+            if (window) {
+                int width, height;
+                glfwGetFramebufferSize(window, &width, &height);
+
+                actualExtent = {
+                static_cast<uint32_t>(width),
+                static_cast<uint32_t>(height)
+                };
+            }
 
             actualExtent.width = std::clamp(actualExtent.width, capabilities.minImageExtent.width, capabilities.maxImageExtent.width);
             actualExtent.height = std::clamp(actualExtent.height, capabilities.minImageExtent.height, capabilities.maxImageExtent.height);
@@ -260,25 +666,42 @@ namespace Graphics {
         }   
     }
 
-//------------------------------ CREATE COMMAND POOL FUNC------------------------------
-    void Device::createCommandPool(VkSurfaceKHR surface) {
-        QueueFamilyIndices queueFamilyIndices = findQueueFamilies(vk_physicalDevice, surface);
-
-        VkCommandPoolCreateInfo poolInfo{};
-        poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
-        poolInfo.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
-        poolInfo.queueFamilyIndex = queueFamilyIndices.graphicsFamily.value();
-        
-        if (vkCreateCommandPool(vk_logicalDevice, &poolInfo, nullptr, &vk_commandPool) != VK_SUCCESS) throw std::runtime_error("failed to create command pool!");
-    }
-
 //------------------------------DESTROY------------------------------
     Device::~Device() {
         for (auto imageView : vk_swapChainImageViews) {
             vkDestroyImageView(vk_logicalDevice, imageView, nullptr);
         }
         if (vk_swapChain != VK_NULL_HANDLE) vkDestroySwapchainKHR(vk_logicalDevice, vk_swapChain, nullptr); 
-        if (vk_commandPool != VK_NULL_HANDLE) vkDestroyCommandPool(vk_logicalDevice, vk_commandPool, nullptr);
+        for (auto& image : offscreenImages) allocator->destroyImage(image);
+        allocator.reset();
         if (vk_logicalDevice != VK_NULL_HANDLE) vkDestroyDevice(vk_logicalDevice, nullptr);
     }
+
+//------------------------------PRESENT PROFILES------------------------------
+
+    PresentProfile parsePresentProfile(const std::string& name) {
+        if (name == "low-latency") return PresentProfile::LowLatency;
+        if (name == "throughput") return PresentProfile::Throughput;
+        if (name == "power-saving") return PresentProfile::PowerSaving;
+        throw std::runtime_error("unknown present profile: " + name + "!");
+    }
+
+    const char* presentProfileName(PresentProfile profile) {
+        switch (profile) {
+            case PresentProfile::LowLatency: return "low-latency";
+            case PresentProfile::Throughput: return "throughput";
+            case PresentProfile::PowerSaving: return "power-saving";
+        }
+        return "unknown";
+    }
+
+    const char* presentModeName(VkPresentModeKHR presentMode) {
+        switch (presentMode) {
+            case VK_PRESENT_MODE_IMMEDIATE_KHR: return "immediate";
+            case VK_PRESENT_MODE_MAILBOX_KHR: return "mailbox";
+            case VK_PRESENT_MODE_FIFO_KHR: return "fifo";
+            case VK_PRESENT_MODE_FIFO_RELAXED_KHR: return "fifo-relaxed";
+            default: return "unknown";
+        }
+    }
 }
\ No newline at end of file
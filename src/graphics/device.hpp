@@ -1,10 +1,20 @@
 #pragma once
 
 #include "../includes/graphics.hpp"
+#include "allocator.hpp"
+#include "startupTrace.hpp"
+#include <nlohmann/json.hpp>
 #include <stdexcept>
 #include <optional>
 #include <set>
 #include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <limits>
+#include <memory>
+#include <string>
+#include <iostream>
 #include <vector>
 
 namespace Graphics {
@@ -19,57 +29,151 @@ namespace Graphics {
     {
         std::optional<uint32_t> graphicsFamily;
         std::optional<uint32_t> presentFamily;
+        // A transfer-only family when the device has one (DMA engine), otherwise the graphics family
+        std::optional<uint32_t> transferFamily;
+        // A compute family without graphics (async compute engine) when available, otherwise the graphics family
+        std::optional<uint32_t> computeFamily;
 
-        inline bool isComplete() {
-            return graphicsFamily.has_value() && presentFamily.has_value();
+        inline bool isComplete(bool requirePresent = true) {
+            return graphicsFamily.has_value() && (presentFamily.has_value() || !requirePresent);
         }
     };
     
 
+    // LowLatency: tearing allowed, fewest images queued ahead of the display
+    // Throughput: never blocks on vsync, extra images so the GPU always has one to render into
+    // PowerSaving: paced to the display refresh so the GPU idles between frames
+    enum class PresentProfile {
+        LowLatency,
+        Throughput,
+        PowerSaving
+    };
+
+    PresentProfile parsePresentProfile(const std::string& name);
+    const char* presentProfileName(PresentProfile profile);
+    const char* presentModeName(VkPresentModeKHR presentMode);
+
+    // How the physical device was picked. Without a cache hit every device was rated and the highest score won
+    struct DeviceSelection {
+        uint32_t candidates = 0;
+        uint32_t suitable = 0;
+        int64_t score = 0;
+        // The cached device and queue layout were still valid, nothing else was rated
+        bool cacheHit = false;
+        TraceSpan span;
+    };
+
+    // Handles replaced by recreateSwapChain, they stay alive until every frame that used them has finished
+    struct RetiredSwapChain {
+        VkSwapchainKHR swapChain = VK_NULL_HANDLE;
+        std::vector<VkImageView> imageViews;
+    };
+
     class Device {
     public:
         Device(
         VkInstance instance,
         VkSurfaceKHR surface,
         bool enableValidationLayers,
-        const std::vector<const char*>& validationLayers
+        const std::vector<const char*>& validationLayers,
+        uint32_t apiVersion = VK_API_VERSION_1_0,
+        // Remembers the chosen device and queue layout by pipeline cache UUID, empty disables it
+        const std::string& selectionCache = "",
+        // The instance can query extension features, see Instance::getFeatures2Supported
+        bool features2Supported = false
         );
-        void createSwapChain(GLFWwindow* window, VkSurfaceKHR surface);
+        void createSwapChain(GLFWwindow* window, VkSurfaceKHR surface, VkExtent2D windowlessExtent = {});
+        RetiredSwapChain recreateSwapChain(GLFWwindow* window, VkSurfaceKHR surface, VkExtent2D windowlessExtent = {});
+        inline void setPresentProfile(PresentProfile profile) { presentProfile = profile; }
+        void createOffscreenTargets(VkExtent2D extent, VkFormat format, uint32_t count);
         inline VkSwapchainKHR getSwapChain() { return vk_swapChain; }
         inline VkFormat getSwapChainImageFormat() { return vk_swapChainImageFormat; }
         inline VkExtent2D getSwapChainExtent() { return vk_swapChainExtent; }
         inline std::vector<VkImageView> getSwapChainImageViews() { return vk_swapChainImageViews; }
+        inline PresentProfile getPresentProfile() const { return presentProfile; }
+        inline VkPresentModeKHR getPresentMode() const { return vk_presentMode; }
+        inline uint32_t getSwapChainImageCount() const { return static_cast<uint32_t>(vk_swapChainImages.size()); }
         inline VkDevice getLogicalDevice() { return vk_logicalDevice; }
-        inline VkCommandPool getCommandPool() { return vk_commandPool; }
         inline VkQueue getPresentQueue() { return vk_presentQueue; }
         inline VkQueue getGraphicsQueue() { return vk_graphicsQueue; }
+        inline VkQueue getTransferQueue() { return vk_transferQueue; }
+        inline VkQueue getComputeQueue() { return vk_computeQueue; }
+        inline uint32_t getGraphicsQueueFamily() const { return queueFamilyIndices.graphicsFamily.value(); }
+        inline uint32_t getTransferQueueFamily() const { return queueFamilyIndices.transferFamily.value(); }
+        inline uint32_t getComputeQueueFamily() const { return queueFamilyIndices.computeFamily.value(); }
+        inline Allocator& getAllocator() { return *allocator; }
+        inline const VkPhysicalDeviceProperties& getPhysicalDeviceProperties() const { return vk_physicalDeviceProperties; }
+        inline const char* getDeviceName() const { return vk_physicalDeviceProperties.deviceName; }
+        inline float getTimestampPeriod() const { return vk_physicalDeviceProperties.limits.timestampPeriod; }
+        inline bool getTimestampsSupported() const { return timestampsSupported; }
+        inline uint32_t getTimestampValidBits() const { return timestampValidBits; }
+        // Only true when both the instance and the GPU are on Vulkan 1.2, the feature is enabled on the device then
+        inline bool getTimelineSemaphoresSupported() const { return timelineSemaphoresSupported; }
+        // Partially bound, update-after-bind storage buffer and image descriptors, same Vulkan 1.2 requirement as above
+        inline bool getUpdateAfterBindSupported() const { return updateAfterBindSupported; }
+        inline bool getTextureCompressionBCSupported() const { return deviceFeatures.textureCompressionBC == VK_TRUE; }
+        inline VkPhysicalDevice getPhysicalDevice() const { return vk_physicalDevice; }
+        inline const DeviceSelection& getSelection() const { return selection; }
+        // VK_KHR_present_id and VK_KHR_present_wait, both enabled whenever the GPU has them and the instance can query them
+        inline bool getPresentWaitSupported() const { return presentWaitSupported; }
+        // Blocks until the present tagged with presentId reached the display or the timeout (ns) ran out. Host access to
+        // the swapchain has to be synchronized with vkQueuePresentKHR, so this belongs on the thread that presents
+        VkResult waitForPresent(uint64_t presentId, uint64_t timeout);
+        // VK_EXT_calibrated_timestamps with a host domain matching std::chrono::steady_clock
+        inline bool getCalibratedTimestampsSupported() const { return calibratedTimestampsSupported; }
+        // A GPU timestamp and the steady clock (ns since its epoch) sampled at the same moment, false without support
+        bool getCalibratedTimestamps(uint64_t& deviceTicks, int64_t& hostNs);
         void createImageViews();
-        void createCommandPool(VkSurfaceKHR surface);
         ~Device();
 
     private:
+#ifdef _WIN32
+        static constexpr VkTimeDomainEXT HOST_TIME_DOMAIN = VK_TIME_DOMAIN_QUERY_PERFORMANCE_COUNTER_EXT;
+#else
+        static constexpr VkTimeDomainEXT HOST_TIME_DOMAIN = VK_TIME_DOMAIN_CLOCK_MONOTONIC_EXT;
+#endif
+
         VkPhysicalDevice vk_physicalDevice = VK_NULL_HANDLE;
         VkPhysicalDeviceFeatures deviceFeatures{};
+        VkPhysicalDeviceProperties vk_physicalDeviceProperties{};
+        DeviceSelection selection;
+        bool timestampsSupported = false;
+        uint32_t timestampValidBits = 0;
+        bool timelineSemaphoresSupported = false;
+        bool updateAfterBindSupported = false;
+        bool presentWaitSupported = false;
+        PFN_vkWaitForPresentKHR vk_waitForPresent = nullptr;
+        bool calibratedTimestampsSupported = false;
+        PFN_vkGetCalibratedTimestampsEXT vk_getCalibratedTimestamps = nullptr;
         std::vector<VkImage> vk_swapChainImages;
+        std::vector<ImageAllocation> offscreenImages;
         VkDevice vk_logicalDevice = VK_NULL_HANDLE;
-        VkQueue vk_graphicsQueue;
-        VkQueue vk_presentQueue;
-        VkSwapchainKHR vk_swapChain;
+        std::unique_ptr<Allocator> allocator;
+        VkQueue vk_graphicsQueue = VK_NULL_HANDLE;
+        VkQueue vk_presentQueue = VK_NULL_HANDLE;
+        VkQueue vk_transferQueue = VK_NULL_HANDLE;
+        VkQueue vk_computeQueue = VK_NULL_HANDLE;
+        QueueFamilyIndices queueFamilyIndices;
+        VkSwapchainKHR vk_swapChain = VK_NULL_HANDLE;
         VkFormat vk_swapChainImageFormat;
-        VkCommandPool vk_commandPool;
+        VkPresentModeKHR vk_presentMode = VK_PRESENT_MODE_FIFO_KHR;
+        PresentProfile presentProfile = PresentProfile::Throughput;
         std::vector<VkImageView> vk_swapChainImageViews;
         VkExtent2D vk_swapChainExtent;
-        const std::vector<const char*> deviceExtensions = {
-            VK_KHR_SWAPCHAIN_EXTENSION_NAME
-        };
+        std::vector<const char*> deviceExtensions;
         
         QueueFamilyIndices findQueueFamilies(VkPhysicalDevice device, VkSurfaceKHR surface);
         SwapChainSupportDetails querySwapChainSupport(VkPhysicalDevice device, VkSurfaceKHR surface);
         VkSurfaceFormatKHR chooseSwapSurfaceFormat(const std::vector<VkSurfaceFormatKHR>& availableFormats);
         VkPresentModeKHR chooseSwapPresentMode(const std::vector<VkPresentModeKHR>& availablePresentModes);
-        VkExtent2D chooseSwapExtent(const VkSurfaceCapabilitiesKHR& capabilities, GLFWwindow* window);
+        uint32_t chooseSwapImageCount(const VkSurfaceCapabilitiesKHR& capabilities, VkPresentModeKHR presentMode);
+        VkExtent2D chooseSwapExtent(const VkSurfaceCapabilitiesKHR& capabilities, GLFWwindow* window, VkExtent2D windowlessExtent);
         bool checkDeviceExtensionSupport(VkPhysicalDevice device);
-        bool isDeviceSuitable(VkPhysicalDevice device, VkSurfaceKHR surface);
+        bool hasDeviceExtension(VkPhysicalDevice device, const char* name);
+        // -1 for a device the renderer can't run on, otherwise higher is better. indices receives its queue layout
+        int64_t rateDevice(VkPhysicalDevice device, VkSurfaceKHR surface, QueueFamilyIndices& indices);
+        bool loadSelectionCache(const std::filesystem::path& path, const std::vector<VkPhysicalDevice>& devices, VkSurfaceKHR surface);
+        void saveSelectionCache(const std::filesystem::path& path, uint32_t deviceCount, bool present);
     };
 
 }
\ No newline at end of file
@@ -0,0 +1,142 @@
+#include "framePacer.hpp"
+#include "benchmark.hpp"
+#include "profiler.hpp"
+#include <algorithm>
+#include <thread>
+
+namespace Graphics {
+
+    static double elapsedMs(std::chrono::steady_clock::time_point start, std::chrono::steady_clock::time_point end) {
+        return std::chrono::duration<double, std::milli>(end - start).count();
+    }
+
+    FramePacer::FramePacer(Device& device, Renderer& renderer, const FramePacingSettings& settings) : device(device), renderer(renderer), settings(settings) {
+        presentWait = device.getPresentWaitSupported();
+        vsync = device.getPresentMode() == VK_PRESENT_MODE_FIFO_KHR || device.getPresentMode() == VK_PRESENT_MODE_FIFO_RELAXED_KHR;
+        refreshMs = 1000.0 / (settings.refreshRate > 0.0 ? settings.refreshRate : 60.0);
+        this->settings.maxQueuedFrames = std::max(1u, settings.maxQueuedFrames);
+        inputTime = Clock::now();
+    }
+
+//------------------------------BEGIN FRAME------------------------------
+    void FramePacer::beginFrame() {
+        PROFILE_ZONE("pacerWait");
+        if (settings.enabled) waitForFrames(settings.maxQueuedFrames);
+        else if (presentWait) {
+            pollFrames();
+            waitForFrames(MAX_PENDING_FRAMES);
+        }
+        // The renderer waits for the frame that last used the slot anyway, doing it here costs nothing extra
+        else waitForFrames(renderer.getFramesInFlight());
+
+        if (settings.enabled) {
+            PROFILE_ZONE("pacerSleep");
+            const auto sleepStart = Clock::now();
+            if (sleepMs > 0.0) std::this_thread::sleep_for(std::chrono::duration<double, std::milli>(sleepMs));
+            sleptMs.push(elapsedMs(sleepStart, Clock::now()));
+        }
+        inputTime = Clock::now();
+    }
+
+//------------------------------FRAME FINISHED------------------------------
+    void FramePacer::frameFinished() {
+        const uint64_t frameNumber = renderer.getFrameNumber();
+        if (frameNumber == submittedFrames) return;
+        submittedFrames = frameNumber;
+
+        const FrameTimings& timings = renderer.getLastFrameTimings();
+        pending.push_back({frameNumber - 1, timings.presentId, inputTime, timings.submitTime, timings.presentTime});
+
+        // Polling right after the present as well narrows down when earlier frames reached the display
+        if (!settings.enabled && presentWait) pollFrames();
+    }
+
+    void FramePacer::swapChainRecreated() {
+        if (presentWait) {
+            droppedFrames += pending.size();
+            pending.clear();
+        }
+        // The gap around the recreation is not a missed refresh
+        hasLastDisplay = false;
+    }
+
+//------------------------------WAIT FOR DISPLAY------------------------------
+    void FramePacer::waitForFrames(uint64_t depth) {
+        while (!pending.empty() && pending.front().frame + depth <= renderer.getFrameNumber()) {
+            const PendingFrame frame = pending.front();
+            pending.pop_front();
+
+            if (presentWait) {
+                // Timed out or went out of date, the image may never have been shown
+                const VkResult result = device.waitForPresent(frame.presentId, PRESENT_TIMEOUT);
+                if (result != VK_SUCCESS && result != VK_SUBOPTIMAL_KHR) {
+                    droppedFrames++;
+                    hasLastDisplay = false;
+                    continue;
+                }
+                frameDisplayed(frame, Clock::now());
+                continue;
+            }
+
+            renderer.waitForFrame(frame.frame);
+            Clock::time_point displayTime = Clock::now();
+            if (vsync && hasLastDisplay) displayTime = std::max(displayTime, lastDisplayTime + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double, std::milli>(refreshMs)));
+            frameDisplayed(frame, displayTime);
+        }
+    }
+
+    void FramePacer::pollFrames() {
+        while (!pending.empty() && device.waitForPresent(pending.front().presentId, 0) == VK_SUCCESS) {
+            frameDisplayed(pending.front(), Clock::now());
+            pending.pop_front();
+        }
+    }
+
+//------------------------------CONTROLLER------------------------------
+    void FramePacer::frameDisplayed(const PendingFrame& frame, Clock::time_point displayTime) {
+        displayedFrames++;
+        inputToSubmitMs.push(elapsedMs(frame.inputTime, frame.submitTime));
+        inputToPresentMs.push(elapsedMs(frame.inputTime, frame.presentTime));
+        inputToDisplayMs.push(elapsedMs(frame.inputTime, displayTime));
+
+        if (hasLastDisplay) {
+            const double intervalMs = elapsedMs(lastDisplayTime, displayTime);
+            displayIntervalMs.push(intervalMs);
+
+            // Only FIFO ties frames to refreshes, other modes have no deadline to sleep towards
+            if (vsync) {
+                if (intervalMs > 1.5 * refreshMs) {
+                    missedFrames++;
+                    onTimeFrames = 0;
+                    sleepMs = std::max(0.0, sleepMs * 0.5 - SLEEP_STEP_MS);
+                } else if (++onTimeFrames >= RAISE_AFTER_FRAMES) {
+                    onTimeFrames = 0;
+                    sleepMs = std::min(sleepMs + SLEEP_STEP_MS, std::max(0.0, refreshMs - settings.marginMs));
+                }
+            }
+        }
+        lastDisplayTime = displayTime;
+        hasLastDisplay = true;
+    }
+
+//------------------------------REPORT------------------------------
+    nlohmann::json FramePacer::buildReport() const {
+        nlohmann::json report;
+        // Polled display times are an upper bound, off by up to the time between two polls
+        report["method"] = presentWait ? (settings.enabled ? "present-wait" : "present-poll") : "estimated";
+        report["pacing"] = settings.enabled;
+        report["maxQueuedFrames"] = settings.maxQueuedFrames;
+        report["refreshMs"] = refreshMs;
+        report["missedFrames"] = missedFrames;
+        report["droppedFrames"] = droppedFrames;
+        report["displayedFrames"] = displayedFrames;
+        // Latencies below only cover the most recent frames, the counters above the whole run
+        report["sampleWindow"] = SAMPLE_WINDOW;
+        report["inputToSubmitMs"] = Benchmark::summarize(inputToSubmitMs.samples);
+        report["inputToPresentMs"] = Benchmark::summarize(inputToPresentMs.samples);
+        report["inputToDisplayMs"] = Benchmark::summarize(inputToDisplayMs.samples);
+        report["displayIntervalMs"] = Benchmark::summarize(displayIntervalMs.samples);
+        if (settings.enabled) report["sleepMs"] = Benchmark::summarize(sleptMs.samples);
+        return report;
+    }
+}
\ No newline at end of file
@@ -0,0 +1,113 @@
+#pragma once
+
+#include "../includes/graphics.hpp"
+#include "device.hpp"
+#include "renderer.hpp"
+#include <nlohmann/json.hpp>
+#include <chrono>
+#include <deque>
+#include <vector>
+
+namespace Graphics {
+
+    struct FramePacingSettings {
+        // Off only measures, nothing waits or sleeps for the latency tracking beyond what the renderer already does
+        bool enabled = false;
+        // Frames that may be between input sampling and the display. Before sampling input for frame N the pacer
+        // waits until frame N - maxQueuedFrames is on screen
+        uint32_t maxQueuedFrames = 1;
+        // Headroom the sleep keeps to the refresh interval
+        double marginMs = 1.0;
+        double refreshRate = 60.0;
+    };
+
+    // Follows every presented frame from input sampling through submit and present to the display. With
+    // VK_KHR_present_wait a frame is on screen when vkWaitForPresentKHR returns for its present id; without it the
+    // display time is estimated as the GPU completion of the frame, pushed to one refresh after the previous frame when
+    // FIFO presentation allows no more than one image per refresh.
+    // Pacing samples input as late as still makes the next refresh: once the queued frame is on screen a controller
+    // sleeps, growing the sleep while frames keep their refresh and halving it on every miss
+    class FramePacer {
+
+        public:
+            FramePacer(Device& device, Renderer& renderer, const FramePacingSettings& settings);
+
+            // Call right before polling input, the time it returns at is the input sample of the next frame
+            void beginFrame();
+            // Call right after drawFrame, before the swapchain is recreated. A frame whose acquire failed never
+            // reached the queue and is skipped
+            void frameFinished();
+            // Present ids of the retired swapchain can't be waited on anymore, their frames are dropped
+            void swapChainRecreated();
+
+            nlohmann::json buildReport() const;
+            inline bool getPresentWait() const { return presentWait; }
+            inline double getSleepMs() const { return sleepMs; }
+
+        private:
+            using Clock = std::chrono::steady_clock;
+
+            struct PendingFrame {
+                uint64_t frame;
+                uint64_t presentId;
+                Clock::time_point inputTime;
+                Clock::time_point submitTime;
+                Clock::time_point presentTime;
+            };
+
+            // A present that takes longer than this (ns) is treated as lost, not waited on forever
+            static constexpr uint64_t PRESENT_TIMEOUT = 100'000'000;
+            // While only measuring presents are polled, a frame this far back is waited for instead
+            static constexpr uint64_t MAX_PENDING_FRAMES = 16;
+            // On-time frames in a row before the sleep grows by one step
+            static constexpr uint32_t RAISE_AFTER_FRAMES = 30;
+            static constexpr double SLEEP_STEP_MS = 0.25;
+            // The report covers this many recent frames, the pacer runs for whole interactive sessions
+            static constexpr size_t SAMPLE_WINDOW = 4096;
+
+            // Fixed-size ring of the latest samples, the oldest is overwritten once it is full. Percentiles don't depend
+            // on the order, so the storage is summarized as is
+            struct SampleWindow {
+                std::vector<double> samples;
+                size_t next = 0;
+
+                inline void push(double sample) {
+                    if (samples.size() < SAMPLE_WINDOW) samples.push_back(sample);
+                    else samples[next] = sample;
+                    next = (next + 1) % SAMPLE_WINDOW;
+                }
+            };
+
+            Device& device;
+            Renderer& renderer;
+            FramePacingSettings settings;
+            bool presentWait;
+            // FIFO and FIFO relaxed show one image per refresh, a longer gap between two frames is a missed refresh
+            bool vsync;
+            double refreshMs;
+
+            Clock::time_point inputTime;
+            uint64_t submittedFrames = 0;
+            std::deque<PendingFrame> pending;
+            Clock::time_point lastDisplayTime;
+            bool hasLastDisplay = false;
+
+            double sleepMs = 0.0;
+            uint32_t onTimeFrames = 0;
+            uint64_t missedFrames = 0;
+            uint64_t droppedFrames = 0;
+            uint64_t displayedFrames = 0;
+
+            SampleWindow inputToSubmitMs;
+            SampleWindow inputToPresentMs;
+            SampleWindow inputToDisplayMs;
+            SampleWindow displayIntervalMs;
+            SampleWindow sleptMs;
+
+            // Blocks until every pending frame at least depth frames back is on screen
+            void waitForFrames(uint64_t depth);
+            // Takes the pending frames that already reached the display without blocking, present wait only
+            void pollFrames();
+            void frameDisplayed(const PendingFrame& frame, Clock::time_point displayTime);
+    };
+}
\ No newline at end of file
@@ -0,0 +1,209 @@
+#include "gpuCulling.hpp"
+#include "shaders/cull.comp.hpp"
+namespace Graphics {
+
+    GpuCuller::GpuCuller(VkDevice device, Allocator& allocator, VkPipelineCache pipelineCache, uint32_t framesInFlight, VkBuffer instanceBuffer, uint32_t instanceCount, uint32_t indexCount, float meshRadius, const std::vector<uint32_t>& queueFamilies)
+        : vk_logicalDevice(device), allocator(allocator), instanceCount(instanceCount), indexCount(indexCount), meshRadius(meshRadius), crossQueue(queueFamilies.size() > 1) {
+
+//------------------------------CREATE DESCRIPTOR SET LAYOUT------------------------------
+        std::array<VkDescriptorSetLayoutBinding, 3> bindings{};
+        for (uint32_t i = 0; i < bindings.size(); i++) {
+            bindings[i].binding = i;
+            bindings[i].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+            bindings[i].descriptorCount = 1;
+            bindings[i].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+        }
+
+        VkDescriptorSetLayoutCreateInfo descriptorSetLayoutInfo{};
+        descriptorSetLayoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+        descriptorSetLayoutInfo.bindingCount = static_cast<uint32_t>(bindings.size());
+        descriptorSetLayoutInfo.pBindings = bindings.data();
+
+        if (vkCreateDescriptorSetLayout(vk_logicalDevice, &descriptorSetLayoutInfo, nullptr, &vk_descriptorSetLayout) != VK_SUCCESS) throw std::runtime_error("failed to create cull descriptor set layout!");
+
+//------------------------------CREATE PIPELINE------------------------------
+        VkPushConstantRange pushConstantRange{};
+        pushConstantRange.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+        pushConstantRange.offset = 0;
+        pushConstantRange.size = sizeof(CullPushConstants);
+
+        VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
+        pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+        pipelineLayoutInfo.setLayoutCount = 1;
+        pipelineLayoutInfo.pSetLayouts = &vk_descriptorSetLayout;
+        pipelineLayoutInfo.pushConstantRangeCount = 1;
+        pipelineLayoutInfo.pPushConstantRanges = &pushConstantRange;
+
+        if (vkCreatePipelineLayout(vk_logicalDevice, &pipelineLayoutInfo, nullptr, &vk_pipelineLayout) != VK_SUCCESS) throw std::runtime_error("failed to create cull pipeline layout!");
+
+        vk_pipeline = createComputePipeline(pipelineCache, Shaders::cull_comp);
+
+//------------------------------CREATE SLOT BUFFERS------------------------------
+        VkDescriptorPoolSize poolSize{};
+        poolSize.type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        poolSize.descriptorCount = static_cast<uint32_t>(bindings.size()) * framesInFlight;
+
+        VkDescriptorPoolCreateInfo descriptorPoolInfo{};
+        descriptorPoolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+        descriptorPoolInfo.maxSets = framesInFlight;
+        descriptorPoolInfo.poolSizeCount = 1;
+        descriptorPoolInfo.pPoolSizes = &poolSize;
+
+        if (vkCreateDescriptorPool(vk_logicalDevice, &descriptorPoolInfo, nullptr, &vk_descriptorPool) != VK_SUCCESS) throw std::runtime_error("failed to create cull descriptor pool!");
+
+        slots.resize(framesInFlight);
+        for (auto& slot : slots) {
+            VkBufferCreateInfo bufferInfo{};
+            bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+            bufferInfo.sharingMode = crossQueue ? VK_SHARING_MODE_CONCURRENT : VK_SHARING_MODE_EXCLUSIVE;
+            bufferInfo.queueFamilyIndexCount = crossQueue ? static_cast<uint32_t>(queueFamilies.size()) : 0;
+            bufferInfo.pQueueFamilyIndices = crossQueue ? queueFamilies.data() : nullptr;
+
+            bufferInfo.size = sizeof(uint32_t) * instanceCount;
+            bufferInfo.usage = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT;
+            slot.visibleBuffer = allocator.createBuffer(bufferInfo, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+
+            bufferInfo.size = sizeof(VkDrawIndexedIndirectCommand);
+            bufferInfo.usage = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
+            slot.indirectBuffer = allocator.createBuffer(bufferInfo, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+
+            bufferInfo.size = sizeof(uint32_t);
+            bufferInfo.usage = VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+            slot.readbackBuffer = allocator.createBuffer(bufferInfo, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+
+            VkDescriptorSetAllocateInfo descriptorSetInfo{};
+            descriptorSetInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+            descriptorSetInfo.descriptorPool = vk_descriptorPool;
+            descriptorSetInfo.descriptorSetCount = 1;
+            descriptorSetInfo.pSetLayouts = &vk_descriptorSetLayout;
+
+            if (vkAllocateDescriptorSets(vk_logicalDevice, &descriptorSetInfo, &slot.vk_descriptorSet) != VK_SUCCESS) throw std::runtime_error("failed to allocate cull descriptor set!");
+
+            std::array<VkDescriptorBufferInfo, 3> bufferInfos{};
+            bufferInfos[0].buffer = instanceBuffer;
+            bufferInfos[1].buffer = slot.visibleBuffer.buffer;
+            bufferInfos[2].buffer = slot.indirectBuffer.buffer;
+
+            std::array<VkWriteDescriptorSet, 3> descriptorWrites{};
+            for (uint32_t i = 0; i < descriptorWrites.size(); i++) {
+                bufferInfos[i].offset = 0;
+                bufferInfos[i].range = VK_WHOLE_SIZE;
+
+                descriptorWrites[i].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+                descriptorWrites[i].dstSet = slot.vk_descriptorSet;
+                descriptorWrites[i].dstBinding = i;
+                descriptorWrites[i].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+                descriptorWrites[i].descriptorCount = 1;
+                descriptorWrites[i].pBufferInfo = &bufferInfos[i];
+            }
+
+            vkUpdateDescriptorSets(vk_logicalDevice, static_cast<uint32_t>(descriptorWrites.size()), descriptorWrites.data(), 0, nullptr);
+        }
+    }
+
+//------------------------------RECORD------------------------------
+    void GpuCuller::record(VkCommandBuffer commandBuffer, uint32_t frameSlot, const FrustumPlanes& planes) {
+        Slot& slot = slots[frameSlot];
+
+        // Reset the draw command, instanceCount is the atomic cursor the shader compacts into
+        VkDrawIndexedIndirectCommand drawCommand{};
+        drawCommand.indexCount = indexCount;
+        vkCmdUpdateBuffer(commandBuffer, slot.indirectBuffer.buffer, 0, sizeof(drawCommand), &drawCommand);
+
+        VkBufferMemoryBarrier resetBarrier{};
+        resetBarrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+        resetBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        resetBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+        resetBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        resetBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        resetBarrier.buffer = slot.indirectBuffer.buffer;
+        resetBarrier.offset = 0;
+        resetBarrier.size = VK_WHOLE_SIZE;
+        vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 0, nullptr, 1, &resetBarrier, 0, nullptr);
+
+        CullPushConstants pushConstants{};
+        for (uint32_t i = 0; i < 4; i++) {
+            for (uint32_t j = 0; j < 4; j++) pushConstants.planes[i][j] = planes[i][j];
+        }
+        pushConstants.instanceCount = instanceCount;
+        pushConstants.meshRadius = meshRadius;
+
+        vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, vk_pipeline);
+        vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, vk_pipelineLayout, 0, 1, &slot.vk_descriptorSet, 0, nullptr);
+        vkCmdPushConstants(commandBuffer, vk_pipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(pushConstants), &pushConstants);
+        vkCmdDispatch(commandBuffer, (instanceCount + WORKGROUP_SIZE - 1) / WORKGROUP_SIZE, 1, 1);
+
+        // Results feed the indirect draw, the vertex shader and the count readback below. A compute queue can't name
+        // the graphics stages, there the semaphore the draws wait on carries that part of the dependency
+        VkMemoryBarrier cullBarrier{};
+        cullBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+        cullBarrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+        cullBarrier.dstAccessMask = crossQueue ? VK_ACCESS_TRANSFER_READ_BIT : VK_ACCESS_INDIRECT_COMMAND_READ_BIT | VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_TRANSFER_READ_BIT;
+        VkPipelineStageFlags consumerStages = crossQueue ? VK_PIPELINE_STAGE_TRANSFER_BIT : VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_TRANSFER_BIT;
+        vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, consumerStages, 0, 1, &cullBarrier, 0, nullptr, 0, nullptr);
+
+        VkBufferCopy region{};
+        region.srcOffset = offsetof(VkDrawIndexedIndirectCommand, instanceCount);
+        region.dstOffset = 0;
+        region.size = sizeof(uint32_t);
+        vkCmdCopyBuffer(commandBuffer, slot.indirectBuffer.buffer, slot.readbackBuffer.buffer, 1, &region);
+
+        VkMemoryBarrier readbackBarrier{};
+        readbackBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+        readbackBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        readbackBarrier.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+        vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_HOST_BIT, 0, 1, &readbackBarrier, 0, nullptr, 0, nullptr);
+
+        slot.recorded = true;
+    }
+
+//------------------------------READ STATS------------------------------
+    bool GpuCuller::readStats(uint32_t frameSlot, CullStats& stats) const {
+        const Slot& slot = slots[frameSlot];
+        if (!slot.recorded) return false;
+
+        stats.visible = *static_cast<const uint32_t*>(slot.readbackBuffer.allocation.mapped);
+        stats.culled = instanceCount - stats.visible;
+        return true;
+    }
+
+//------------------------------CREATE COMPUTE PIPELINE------------------------------
+    VkPipeline GpuCuller::createComputePipeline(VkPipelineCache pipelineCache, std::span<const uint32_t> code) {
+        VkShaderModuleCreateInfo shaderModuleInfo{};
+        shaderModuleInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
+        shaderModuleInfo.codeSize = code.size_bytes();
+        shaderModuleInfo.pCode = code.data();
+
+        VkShaderModule shaderModule;
+        if (vkCreateShaderModule(vk_logicalDevice, &shaderModuleInfo, nullptr, &shaderModule) != VK_SUCCESS) throw std::runtime_error("failed to create cull shader module!");
+
+        VkComputePipelineCreateInfo pipelineInfo{};
+        pipelineInfo.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+        pipelineInfo.stage.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+        pipelineInfo.stage.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+        pipelineInfo.stage.module = shaderModule;
+        pipelineInfo.stage.pName = "main";
+        pipelineInfo.layout = vk_pipelineLayout;
+
+        VkPipeline pipeline;
+        VkResult result = vkCreateComputePipelines(vk_logicalDevice, pipelineCache, 1, &pipelineInfo, nullptr, &pipeline);
+        vkDestroyShaderModule(vk_logicalDevice, shaderModule, nullptr);
+
+        if (result != VK_SUCCESS) throw std::runtime_error("failed to create cull pipeline!");
+        return pipeline;
+    }
+
+//------------------------------DESTROY------------------------------
+    GpuCuller::~GpuCuller() {
+        for (auto& slot : slots) {
+            allocator.destroyBuffer(slot.visibleBuffer);
+            allocator.destroyBuffer(slot.indirectBuffer);
+            allocator.destroyBuffer(slot.readbackBuffer);
+        }
+
+        vkDestroyPipeline(vk_logicalDevice, vk_pipeline, nullptr);
+        vkDestroyPipelineLayout(vk_logicalDevice, vk_pipelineLayout, nullptr);
+        vkDestroyDescriptorPool(vk_logicalDevice, vk_descriptorPool, nullptr);
+        vkDestroyDescriptorSetLayout(vk_logicalDevice, vk_descriptorSetLayout, nullptr);
+    }
+}
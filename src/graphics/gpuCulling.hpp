@@ -0,0 +1,72 @@
+#pragma once
+
+#include "../includes/graphics.hpp"
+#include "allocator.hpp"
+#include <array>
+#include <cstddef>
+#include <span>
+#include <stdexcept>
+#include <vector>
+
+namespace Graphics {
+
+    struct CullStats {
+        uint32_t visible = 0;
+        uint32_t culled = 0;
+    };
+
+    // Frustum planes as (normal.xy, 0, distance), a sphere is inside when dot(normal, center) + distance >= -radius
+    using FrustumPlanes = std::array<std::array<float, 4>, 4>;
+
+    // Compute pass that tests every instance's bounding sphere against the frustum and compacts the survivors into a
+    // visible index list plus a single VkDrawIndexedIndirectCommand. Buffers are per frame slot, so recording one frame
+    // never touches data an earlier in-flight frame is still drawing from.
+    // With queueFamilies set the pass runs on a separate compute queue: the results are shared concurrently with those
+    // families and the graphics submission picks them up through a semaphore instead of a pipeline barrier
+    class GpuCuller {
+
+        public:
+            GpuCuller(VkDevice device, Allocator& allocator, VkPipelineCache pipelineCache, uint32_t framesInFlight, VkBuffer instanceBuffer, uint32_t instanceCount, uint32_t indexCount, float meshRadius, const std::vector<uint32_t>& queueFamilies = {});
+            ~GpuCuller();
+            GpuCuller(const GpuCuller&) = delete;
+            GpuCuller& operator=(const GpuCuller&) = delete;
+
+            // Must be recorded outside the render pass, leaves the results ready for indirect draws and vertex shaders
+            void record(VkCommandBuffer commandBuffer, uint32_t frameSlot, const FrustumPlanes& planes);
+            // Only valid once the slot's fence has signaled, returns false if the slot has not been culled yet
+            bool readStats(uint32_t frameSlot, CullStats& stats) const;
+            inline VkBuffer getVisibleBuffer(uint32_t frameSlot) const { return slots[frameSlot].visibleBuffer.buffer; }
+            inline VkBuffer getIndirectBuffer(uint32_t frameSlot) const { return slots[frameSlot].indirectBuffer.buffer; }
+
+        private:
+            struct CullPushConstants {
+                float planes[4][4];
+                uint32_t instanceCount;
+                float meshRadius;
+            };
+
+            struct Slot {
+                BufferAllocation visibleBuffer;
+                BufferAllocation indirectBuffer;
+                BufferAllocation readbackBuffer;
+                VkDescriptorSet vk_descriptorSet = VK_NULL_HANDLE;
+                bool recorded = false;
+            };
+
+            static constexpr uint32_t WORKGROUP_SIZE = 64;
+
+            VkDevice vk_logicalDevice;
+            Allocator& allocator;
+            uint32_t instanceCount;
+            uint32_t indexCount;
+            float meshRadius;
+            bool crossQueue;
+            VkDescriptorSetLayout vk_descriptorSetLayout = VK_NULL_HANDLE;
+            VkDescriptorPool vk_descriptorPool = VK_NULL_HANDLE;
+            VkPipelineLayout vk_pipelineLayout = VK_NULL_HANDLE;
+            VkPipeline vk_pipeline = VK_NULL_HANDLE;
+            std::vector<Slot> slots;
+
+            VkPipeline createComputePipeline(VkPipelineCache pipelineCache, std::span<const uint32_t> code);
+    };
+}
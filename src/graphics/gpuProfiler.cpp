@@ -0,0 +1,95 @@
+#include "gpuProfiler.hpp"
+
+namespace Graphics {
+
+    GpuProfiler::GpuProfiler(Device& device, uint32_t framesInFlight) : device(device), vk_logicalDevice(device.getLogicalDevice()), slots(framesInFlight) {
+        if (!device.getTimestampsSupported()) throw std::runtime_error("gpu profiler needs timestamps on the graphics queue!");
+
+        VkQueryPoolCreateInfo queryPoolInfo{};
+        queryPoolInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+        queryPoolInfo.queryType = VK_QUERY_TYPE_TIMESTAMP;
+        queryPoolInfo.queryCount = 2 * MAX_ZONES * framesInFlight;
+
+        if (vkCreateQueryPool(vk_logicalDevice, &queryPoolInfo, nullptr, &vk_queryPool) != VK_SUCCESS) throw std::runtime_error("failed to create gpu profiler query pool!");
+
+        timestampPeriod = device.getTimestampPeriod();
+        const uint32_t validBits = device.getTimestampValidBits();
+        timestampMask = validBits >= 64 ? UINT64_MAX : (uint64_t{1} << validBits) - 1;
+        calibrated = device.getCalibratedTimestampsSupported();
+        Profiler::setGpuCalibrated(calibrated);
+        results.resize(2 * MAX_ZONES);
+        for (auto& slot : slots) slot.zones.reserve(MAX_ZONES);
+    }
+
+//------------------------------RECORD------------------------------
+    void GpuProfiler::beginFrame(VkCommandBuffer commandBuffer, uint32_t frameSlot) {
+        Slot& slot = slots[frameSlot];
+        slot.zones.clear();
+        slot.queries = 0;
+        slot.submitted = false;
+        recordingSlot = frameSlot;
+        vkCmdResetQueryPool(commandBuffer, vk_queryPool, 2 * MAX_ZONES * frameSlot, 2 * MAX_ZONES);
+    }
+
+    uint32_t GpuProfiler::beginZone(VkCommandBuffer commandBuffer, const char* name) {
+        Slot& slot = slots[recordingSlot];
+        if (!Profiler::isEnabled() || slot.zones.size() == MAX_ZONES) return NO_ZONE;
+
+        const uint32_t query = 2 * MAX_ZONES * recordingSlot + slot.queries;
+        vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, vk_queryPool, query);
+        slot.zones.push_back({name, query, false});
+        slot.queries += 2;
+        return static_cast<uint32_t>(slot.zones.size() - 1);
+    }
+
+    void GpuProfiler::endZone(VkCommandBuffer commandBuffer, uint32_t zone) {
+        if (zone == NO_ZONE) return;
+
+        Zone& recorded = slots[recordingSlot].zones[zone];
+        vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, vk_queryPool, recorded.query + 1);
+        recorded.ended = true;
+    }
+
+    void GpuProfiler::frameSubmitted(std::chrono::steady_clock::time_point submitTime) {
+        Slot& slot = slots[recordingSlot];
+        slot.submitted = true;
+        slot.submitNs = std::chrono::duration_cast<std::chrono::nanoseconds>(submitTime.time_since_epoch()).count();
+    }
+
+//------------------------------COLLECT------------------------------
+    void GpuProfiler::collect(uint32_t frameSlot) {
+        Slot& slot = slots[frameSlot];
+        if (!slot.submitted || slot.zones.empty()) return;
+        slot.submitted = false;
+
+        // Zones are allocated in order, so the slot's queries are one contiguous range
+        if (vkGetQueryPoolResults(vk_logicalDevice, vk_queryPool, 2 * MAX_ZONES * frameSlot, slot.queries, slot.queries * sizeof(uint64_t), results.data(), sizeof(uint64_t), VK_QUERY_RESULT_64_BIT) != VK_SUCCESS) return;
+
+        // A calibration taken now lies after every timestamp of the slot, converting backwards from it is exact as
+        // long as the GPU clock doesn't drift within a few frames
+        uint64_t referenceTicks = results[0];
+        int64_t referenceNs = slot.submitNs;
+        if (calibrated && !device.getCalibratedTimestamps(referenceTicks, referenceNs)) {
+            referenceTicks = results[0];
+            referenceNs = slot.submitNs;
+        }
+        auto toNs = [&](uint64_t ticks) {
+            // Wraps within the valid bits, shifted up so the sign of the difference survives
+            const uint32_t shift = static_cast<uint32_t>(std::countl_zero(timestampMask));
+            const int64_t delta = static_cast<int64_t>(((ticks - referenceTicks) & timestampMask) << shift) >> shift;
+            return referenceNs + static_cast<int64_t>(static_cast<double>(delta) * timestampPeriod);
+        };
+
+        const uint32_t firstQuery = 2 * MAX_ZONES * frameSlot;
+        for (const auto& zone : slot.zones) {
+            if (!zone.ended) continue;
+            const uint32_t index = zone.query - firstQuery;
+            Profiler::recordGpu(zone.name, toNs(results[index]), toNs(results[index + 1]));
+        }
+    }
+
+//------------------------------DESTROY------------------------------
+    GpuProfiler::~GpuProfiler() {
+        vkDestroyQueryPool(vk_logicalDevice, vk_queryPool, nullptr);
+    }
+}
\ No newline at end of file
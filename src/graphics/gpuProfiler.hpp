@@ -0,0 +1,64 @@
+#pragma once
+
+#include "../includes/graphics.hpp"
+#include "device.hpp"
+#include "profiler.hpp"
+#include <bit>
+#include <chrono>
+#include <cstdint>
+#include <vector>
+
+namespace Graphics {
+
+    // GPU zones of the graphics queue, one timestamp pair each, read back per frame slot once its fence has signaled and
+    // handed to the Profiler in steady clock time. With VK_EXT_calibrated_timestamps every read back samples both clocks
+    // together, so the zones line up with the CPU zones of the same frame; without it the first timestamp of a frame is
+    // pinned to the moment the frame was submitted, which keeps durations and order but shifts them to the right
+    class GpuProfiler {
+
+        public:
+            static constexpr uint32_t MAX_ZONES = 16;
+            static constexpr uint32_t NO_ZONE = UINT32_MAX;
+
+            GpuProfiler(Device& device, uint32_t framesInFlight);
+            ~GpuProfiler();
+            GpuProfiler(const GpuProfiler&) = delete;
+            GpuProfiler& operator=(const GpuProfiler&) = delete;
+
+            // Resets the queries of the slot, recorded before any zone of the frame
+            void beginFrame(VkCommandBuffer commandBuffer, uint32_t frameSlot);
+            // Zones past MAX_ZONES in a frame or while the profiler is off return NO_ZONE and are not recorded. Names
+            // have to outlive the profiler, string literals only
+            uint32_t beginZone(VkCommandBuffer commandBuffer, const char* name);
+            void endZone(VkCommandBuffer commandBuffer, uint32_t zone);
+            void frameSubmitted(std::chrono::steady_clock::time_point submitTime);
+            // Only once the slot's last frame has finished, its queries are read without waiting
+            void collect(uint32_t frameSlot);
+            inline bool getCalibrated() const { return calibrated; }
+
+        private:
+            struct Zone {
+                const char* name;
+                uint32_t query;
+                bool ended;
+            };
+
+            struct Slot {
+                std::vector<Zone> zones;
+                uint32_t queries = 0;
+                bool submitted = false;
+                int64_t submitNs = 0;
+            };
+
+            Device& device;
+            VkDevice vk_logicalDevice;
+            VkQueryPool vk_queryPool = VK_NULL_HANDLE;
+            double timestampPeriod;
+            // Bits above timestampValidBits are undefined, differences are taken within the valid ones
+            uint64_t timestampMask;
+            bool calibrated;
+            std::vector<Slot> slots;
+            uint32_t recordingSlot = 0;
+            std::vector<uint64_t> results;
+    };
+}
\ No newline at end of file
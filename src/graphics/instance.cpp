@@ -2,10 +2,19 @@
 
 namespace Graphics {
 
-    Instance::Instance() {
+    Instance::Instance(bool headless, bool requestVulkan12) {
 //------------------------------VALIDATION LAYERS CHECK------------------------------
         if (enableValidationLayers && !checkValidationLayerSupport()) throw std::runtime_error("validation layers requested, but not available!");
 
+//------------------------------API VERSION------------------------------
+        // A 1.0 loader doesn't export vkEnumerateInstanceVersion and can only create 1.0 instances
+        if (requestVulkan12) {
+            auto vkEnumerateInstanceVersion = reinterpret_cast<PFN_vkEnumerateInstanceVersion>(vkGetInstanceProcAddr(VK_NULL_HANDLE, "vkEnumerateInstanceVersion"));
+            uint32_t loaderVersion = VK_API_VERSION_1_0;
+            if (vkEnumerateInstanceVersion) vkEnumerateInstanceVersion(&loaderVersion);
+            if (loaderVersion >= VK_API_VERSION_1_2) apiVersion = VK_API_VERSION_1_2;
+        }
+
 //------------------------------ENGINE INFO------------------------------
         VkApplicationInfo engineInfo{};
         engineInfo.sType = VK_STRUCTURE_TYPE_APPLICATION_INFO;
@@ -13,23 +22,38 @@ namespace Graphics {
         engineInfo.applicationVersion = VK_MAKE_VERSION(0, 0, 1);
         engineInfo.pEngineName = "UranEngine";
         engineInfo.engineVersion = VK_MAKE_VERSION(0, 0, 1);
-        engineInfo.apiVersion = VK_API_VERSION_1_0;
+        engineInfo.apiVersion = apiVersion;
 
 //------------------------------INSTANCE INFO------------------------------
 
-        uint32_t glfwExtensionCount = 0;
-        const char** glfwExtensions;
-        glfwExtensions = glfwGetRequiredInstanceExtensions(&glfwExtensionCount);
-
-        std::vector<const char*> extensions(glfwExtensions, glfwExtensions + glfwExtensionCount);
+        std::vector<const char*> extensions;
+
+        if (!headless) {
+            uint32_t glfwExtensionCount = 0;
+            const char** glfwExtensions;
+            glfwExtensions = glfwGetRequiredInstanceExtensions(&glfwExtensionCount);
+            extensions.assign(glfwExtensions, glfwExtensions + glfwExtensionCount);
+        } else if (checkInstanceExtensionSupport(VK_EXT_HEADLESS_SURFACE_EXTENSION_NAME)) {
+            // Headless runs don't need any surface, but a headless surface lets them exercise the swapchain path too
+            extensions.push_back(VK_KHR_SURFACE_EXTENSION_NAME);
+            extensions.push_back(VK_EXT_HEADLESS_SURFACE_EXTENSION_NAME);
+            headlessSurfaceSupported = true;
+        }
 
         if (enableValidationLayers) extensions.push_back(VK_EXT_DEBUG_UTILS_EXTENSION_NAME);
 
+        // Extension features like present wait are only reported through vkGetPhysicalDeviceFeatures2, 1.0 needs the extension
+        if (apiVersion >= VK_API_VERSION_1_1) features2Supported = true;
+        else if (checkInstanceExtensionSupport(VK_KHR_GET_PHYSICAL_DEVICE_PROPERTIES_2_EXTENSION_NAME)) {
+            extensions.push_back(VK_KHR_GET_PHYSICAL_DEVICE_PROPERTIES_2_EXTENSION_NAME);
+            features2Supported = true;
+        }
+
         VkInstanceCreateInfo instanceInfo{};
         instanceInfo.sType = VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO;
         instanceInfo.pApplicationInfo = &engineInfo;
-        instanceInfo.enabledExtensionCount = glfwExtensionCount;
-        instanceInfo.ppEnabledExtensionNames = glfwExtensions;
+        instanceInfo.enabledExtensionCount = static_cast<uint32_t>(extensions.size());
+        instanceInfo.ppEnabledExtensionNames = extensions.data();
         if (enableValidationLayers) {
             instanceInfo.enabledLayerCount = static_cast<uint32_t>(vk_validationLayers.size());
             instanceInfo.ppEnabledLayerNames = vk_validationLayers.data();
@@ -45,6 +69,20 @@ namespace Graphics {
         if (glfwCreateWindowSurface(vk_instance, window, nullptr, &vk_surface) != VK_SUCCESS) throw std::runtime_error("failde to create surface!");
     }
 
+//------------------------------CREATE HEADLESS SURFACE------------------------------
+
+    void Instance::createHeadlessSurface() {
+        if (!headlessSurfaceSupported) throw std::runtime_error("VK_EXT_headless_surface is not available!");
+
+        auto vkCreateHeadlessSurfaceEXT = reinterpret_cast<PFN_vkCreateHeadlessSurfaceEXT>(vkGetInstanceProcAddr(vk_instance, "vkCreateHeadlessSurfaceEXT"));
+        if (!vkCreateHeadlessSurfaceEXT) throw std::runtime_error("failed to load vkCreateHeadlessSurfaceEXT!");
+
+        VkHeadlessSurfaceCreateInfoEXT surfaceInfo{};
+        surfaceInfo.sType = VK_STRUCTURE_TYPE_HEADLESS_SURFACE_CREATE_INFO_EXT;
+
+        if (vkCreateHeadlessSurfaceEXT(vk_instance, &surfaceInfo, nullptr, &vk_surface) != VK_SUCCESS) throw std::runtime_error("failed to create headless surface!");
+    }
+
 //------------------------------CHECK VALIDATION LAYERS SUPPORT------------------------------
 
     bool Instance::checkValidationLayerSupport() {
@@ -69,6 +107,20 @@ namespace Graphics {
         return true;
     }
 
+//------------------------------CHECK INSTANCE EXTENSION SUPPORT------------------------------
+
+    bool Instance::checkInstanceExtensionSupport(const char* extensionName) {
+        uint32_t extensionCount;
+        vkEnumerateInstanceExtensionProperties(nullptr, &extensionCount, nullptr);
+        std::vector<VkExtensionProperties> availableExtensions(extensionCount);
+        vkEnumerateInstanceExtensionProperties(nullptr, &extensionCount, availableExtensions.data());
+
+        for (const auto& extension : availableExtensions) {
+            if (strcmp(extensionName, extension.extensionName) == 0) return true;
+        }
+        return false;
+    }
+
 //------------------------------DESTROY INSTANCE------------------------------
 
     Instance::~Instance() {
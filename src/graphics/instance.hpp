@@ -10,13 +10,19 @@ namespace Graphics {
     class Instance {
 
         public:
-            Instance();
+            // requestVulkan12 creates a 1.2 instance when the loader supports it, getApiVersion reports what was used
+            Instance(bool headless = false, bool requestVulkan12 = false);
             void createSurface(GLFWwindow* window);
+            void createHeadlessSurface();
             ~Instance();
 
             inline VkInstance getInstance() const { return vk_instance; }
             inline VkSurfaceKHR getSurface() const { return vk_surface; }
             inline bool getEnableValidationLayers() const { return enableValidationLayers; }
+            inline bool getHeadlessSurfaceSupport() const { return headlessSurfaceSupported; }
+            inline uint32_t getApiVersion() const { return apiVersion; }
+            // vkGetPhysicalDeviceFeatures2 is usable: core from 1.1, through VK_KHR_get_physical_device_properties2 on 1.0
+            inline bool getFeatures2Supported() const { return features2Supported; }
             inline const std::vector<const char*> getValidationLayers() const { return vk_validationLayers; }
 
         private:
@@ -26,10 +32,14 @@ namespace Graphics {
                 const bool enableValidationLayers = true;
             #endif
 
-            VkInstance vk_instance;
-            VkSurfaceKHR vk_surface;
+            VkInstance vk_instance = VK_NULL_HANDLE;
+            VkSurfaceKHR vk_surface = VK_NULL_HANDLE;
+            bool headlessSurfaceSupported = false;
+            bool features2Supported = false;
+            uint32_t apiVersion = VK_API_VERSION_1_0;
             const std::vector<const char*> vk_validationLayers = {"VK_LAYER_KHRONOS_validation"};
 
             bool checkValidationLayerSupport();
+            bool checkInstanceExtensionSupport(const char* extensionName);
     };
 }
\ No newline at end of file
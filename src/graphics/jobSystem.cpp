@@ -0,0 +1,218 @@
+#include "jobSystem.hpp"
+#include "profiler.hpp"
+namespace Graphics {
+
+    namespace {
+        // Set on worker threads, tells a thread which queue it owns
+        thread_local const JobSystem* workerSystem = nullptr;
+        thread_local int32_t workerQueue = -1;
+    }
+
+//------------------------------WORK STEALING QUEUE------------------------------
+    bool WorkStealingQueue::push(Job* job) {
+        const int64_t b = bottom.load(std::memory_order_relaxed);
+        const int64_t t = top.load(std::memory_order_acquire);
+        if (b - t >= CAPACITY) return false;
+
+        buffer[b & (CAPACITY - 1)].store(job, std::memory_order_relaxed);
+        bottom.store(b + 1, std::memory_order_release);
+        return true;
+    }
+
+    Job* WorkStealingQueue::pop() {
+        // Claim the bottom element first, then check whether a thief got to it through top
+        const int64_t b = bottom.load(std::memory_order_relaxed) - 1;
+        bottom.store(b, std::memory_order_seq_cst);
+        int64_t t = top.load(std::memory_order_seq_cst);
+
+        if (t > b) {
+            bottom.store(b + 1, std::memory_order_relaxed);
+            return nullptr;
+        }
+
+        Job* job = buffer[b & (CAPACITY - 1)].load(std::memory_order_relaxed);
+        if (t == b) {
+            // Last element, owner and thieves race for it on top
+            if (!top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) job = nullptr;
+            bottom.store(b + 1, std::memory_order_relaxed);
+        }
+        return job;
+    }
+
+    Job* WorkStealingQueue::steal() {
+        // seq_cst pairs with the owner's pop, so both never take the last element
+        int64_t t = top.load(std::memory_order_seq_cst);
+        const int64_t b = bottom.load(std::memory_order_seq_cst);
+        if (t >= b) return nullptr;
+
+        Job* job = buffer[t & (CAPACITY - 1)].load(std::memory_order_relaxed);
+        if (!top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) return nullptr;
+        return job;
+    }
+
+//------------------------------START WORKERS------------------------------
+    uint32_t JobSystem::defaultWorkerCount() {
+        return std::max(1u, std::thread::hardware_concurrency()) - 1;
+    }
+
+    JobSystem::JobSystem(uint32_t workerCount) : ownerThread(std::this_thread::get_id()) {
+        for (uint32_t i = 0; i <= workerCount; i++) queues.push_back(std::make_unique<WorkStealingQueue>());
+        for (uint32_t i = 0; i < workerCount; i++) workers.emplace_back(&JobSystem::work, this, i + 1);
+    }
+
+//------------------------------SUBMIT------------------------------
+    void JobSystem::run(std::function<void()> function, JobCounter* counter, JobCounter* after) {
+        Job* job = new Job{std::move(function), counter};
+        if (counter) counter->pending.fetch_add(1, std::memory_order_relaxed);
+
+        if (after) {
+            // Checked under the lock the finishing job takes, so the continuation is either seen by it or queued here
+            std::lock_guard<std::mutex> lock(after->mutex);
+            if (after->pending.load(std::memory_order_acquire) > 0) {
+                after->continuations.push_back(job);
+                return;
+            }
+        }
+
+        schedule(job);
+    }
+
+    void JobSystem::parallelFor(uint32_t count, uint32_t grain, const std::function<void(uint32_t first, uint32_t last)>& function, JobCounter& counter) {
+        // The caller may pass a temporary, every job keeps the shared copy alive until it ran
+        auto shared = std::make_shared<std::function<void(uint32_t, uint32_t)>>(function);
+        grain = std::max(1u, grain);
+        for (uint32_t first = 0; first < count; first += grain) {
+            const uint32_t last = std::min(count, first + grain);
+            run([shared, first, last] { (*shared)(first, last); }, &counter);
+        }
+    }
+
+    void JobSystem::schedule(Job* job) {
+        const int32_t queueIndex = currentQueue();
+        queuedJobs.fetch_add(1, std::memory_order_seq_cst);
+
+        // A full queue runs the job right away, which keeps the submitting thread busy instead of failing
+        if (queueIndex >= 0) {
+            if (!queues[queueIndex]->push(job)) {
+                queuedJobs.fetch_sub(1, std::memory_order_relaxed);
+                execute(job);
+                return;
+            }
+        } else {
+            std::lock_guard<std::mutex> lock(injectedMutex);
+            injected.push_back(job);
+        }
+
+        if (sleepingWorkers.load(std::memory_order_seq_cst) > 0) {
+            std::lock_guard<std::mutex> lock(sleepMutex);
+            wakeUp.notify_one();
+        }
+    }
+
+//------------------------------EXECUTE------------------------------
+    Job* JobSystem::findJob(int32_t queueIndex, std::minstd_rand& random) {
+        Job* job = queueIndex >= 0 ? queues[queueIndex]->pop() : nullptr;
+
+        if (!job) {
+            std::lock_guard<std::mutex> lock(injectedMutex);
+            if (!injected.empty()) {
+                job = injected.back();
+                injected.pop_back();
+            }
+        }
+
+        // One pass over the other queues starting at a random victim, so thieves don't all hit the same one
+        const uint32_t queueCount = static_cast<uint32_t>(queues.size());
+        const uint32_t start = random() % queueCount;
+        for (uint32_t i = 0; i < queueCount && !job; i++) {
+            const uint32_t victim = (start + i) % queueCount;
+            if (static_cast<int32_t>(victim) != queueIndex) job = queues[victim]->steal();
+        }
+
+        if (job) queuedJobs.fetch_sub(1, std::memory_order_relaxed);
+        return job;
+    }
+
+    void JobSystem::execute(Job* job) {
+        std::exception_ptr thrown;
+        try {
+            PROFILE_ZONE("job");
+            job->function();
+        } catch (...) {
+            thrown = std::current_exception();
+        }
+
+        // The counter is only released under its lock, so a waiter that saw it done can't free it under us
+        std::vector<Job*> ready;
+        if (job->counter) {
+            std::lock_guard<std::mutex> lock(job->counter->mutex);
+            if (thrown && !job->counter->error) job->counter->error = thrown;
+            if (job->counter->pending.fetch_sub(1, std::memory_order_acq_rel) == 1) ready.swap(job->counter->continuations);
+        }
+        delete job;
+
+        for (Job* continuation : ready) schedule(continuation);
+    }
+
+    void JobSystem::wait(JobCounter& counter) {
+        std::minstd_rand random(static_cast<uint32_t>(reinterpret_cast<uintptr_t>(&counter)));
+        const int32_t queueIndex = currentQueue();
+
+        while (!counter.isDone()) {
+            if (Job* job = findJob(queueIndex, random)) execute(job);
+            else std::this_thread::yield();
+        }
+
+        // Waits out a job that is still unlocking the counter after the last decrement
+        std::exception_ptr thrown;
+        {
+            std::lock_guard<std::mutex> lock(counter.mutex);
+            thrown.swap(counter.error);
+        }
+        if (thrown) std::rethrow_exception(thrown);
+    }
+
+//------------------------------WORK------------------------------
+    void JobSystem::work(uint32_t queueIndex) {
+        workerSystem = this;
+        workerQueue = static_cast<int32_t>(queueIndex);
+        std::minstd_rand random(queueIndex);
+        PROFILE_THREAD(("job worker " + std::to_string(queueIndex)).c_str());
+
+        while (!stopRequested.load(std::memory_order_relaxed)) {
+            if (Job* job = findJob(static_cast<int32_t>(queueIndex), random)) {
+                execute(job);
+                continue;
+            }
+
+            // The submitter bumps queuedJobs before it reads sleepingWorkers, so one of the two sides always sees the other
+            std::unique_lock<std::mutex> lock(sleepMutex);
+            sleepingWorkers.fetch_add(1, std::memory_order_seq_cst);
+            wakeUp.wait(lock, [this] { return stopRequested.load(std::memory_order_relaxed) || queuedJobs.load(std::memory_order_seq_cst) > 0; });
+            sleepingWorkers.fetch_sub(1, std::memory_order_relaxed);
+        }
+    }
+
+    int32_t JobSystem::currentQueue() const {
+        if (workerSystem == this) return workerQueue;
+        if (std::this_thread::get_id() == ownerThread) return 0;
+        return -1;
+    }
+
+//------------------------------DESTROY------------------------------
+    JobSystem::~JobSystem() {
+        {
+            std::lock_guard<std::mutex> lock(sleepMutex);
+            stopRequested = true;
+        }
+        wakeUp.notify_all();
+
+        for (auto& worker : workers) worker.join();
+
+        // Jobs nobody waited for still run here, on the destroying thread. Finishing them releases their counters, so
+        // continuations deferred on those are queued and run too instead of leaking; once the queues are empty none is left
+        std::minstd_rand random;
+        const int32_t queueIndex = currentQueue();
+        while (Job* job = findJob(queueIndex, random)) execute(job);
+    }
+}
\ No newline at end of file
@@ -0,0 +1,111 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+namespace Graphics {
+
+    struct Job;
+
+    // Counts the jobs signaling it that have not finished yet. Jobs can be made to wait for a counter instead of being
+    // queued right away, which is how dependencies between jobs are expressed
+    class JobCounter {
+
+        public:
+            JobCounter() = default;
+            JobCounter(const JobCounter&) = delete;
+            JobCounter& operator=(const JobCounter&) = delete;
+
+            // A finishing job may still be touching the counter, only JobSystem::wait makes it safe to destroy
+            inline bool isDone() const { return pending.load(std::memory_order_acquire) == 0; }
+
+        private:
+            friend class JobSystem;
+
+            std::atomic<uint32_t> pending = 0;
+            std::mutex mutex;
+            std::vector<Job*> continuations;
+            // First exception of a job signaling this counter, guarded by mutex and handed to whoever waits on it
+            std::exception_ptr error;
+    };
+
+    struct Job {
+        std::function<void()> function;
+        JobCounter* counter = nullptr;
+    };
+
+    // Chase-Lev deque: the owning thread pushes and pops at the bottom, every other thread steals from the top
+    class WorkStealingQueue {
+
+        public:
+            static constexpr int64_t CAPACITY = 4096;
+
+            // Owner only, returns false when full
+            bool push(Job* job);
+            // Owner only
+            Job* pop();
+            Job* steal();
+
+        private:
+            alignas(64) std::atomic<int64_t> top = 0;
+            alignas(64) std::atomic<int64_t> bottom = 0;
+            std::array<std::atomic<Job*>, CAPACITY> buffer{};
+    };
+
+    // Worker threads that each own a work-stealing queue. Jobs are pushed to the queue of the thread that submits them
+    // and idle threads steal from the others, the thread that created the system owns a queue too and runs jobs while it
+    // waits. Any other thread may submit, its jobs go through a shared locked queue instead
+    class JobSystem {
+
+        public:
+            // With 0 workers every job runs on the creating thread inside wait
+            explicit JobSystem(uint32_t workerCount);
+            ~JobSystem();
+            JobSystem(const JobSystem&) = delete;
+            JobSystem& operator=(const JobSystem&) = delete;
+
+            // counter is incremented now and decremented when function returns. With after set the job is only queued
+            // once that counter is done, so it runs after every job signaling it
+            void run(std::function<void()> function, JobCounter* counter = nullptr, JobCounter* after = nullptr);
+            // Splits [0, count) into jobs of at most grain items, function gets (first, last) of its range
+            void parallelFor(uint32_t count, uint32_t grain, const std::function<void(uint32_t first, uint32_t last)>& function, JobCounter& counter);
+            // Runs queued jobs until counter is done, rethrows the first exception a job signaling it threw since the last
+            // wait on it. Jobs without a counter have nobody to report to, their exceptions are dropped
+            void wait(JobCounter& counter);
+            inline uint32_t getWorkerCount() const { return static_cast<uint32_t>(workers.size()); }
+            // One worker per hardware thread besides the creating one
+            static uint32_t defaultWorkerCount();
+
+        private:
+            std::vector<std::thread> workers;
+            // Index 0 belongs to the creating thread, i + 1 to worker i
+            std::vector<std::unique_ptr<WorkStealingQueue>> queues;
+
+            std::mutex injectedMutex;
+            std::vector<Job*> injected;
+
+            std::mutex sleepMutex;
+            std::condition_variable wakeUp;
+            std::atomic<int64_t> queuedJobs = 0;
+            std::atomic<uint32_t> sleepingWorkers = 0;
+            std::atomic<bool> stopRequested = false;
+            std::thread::id ownerThread;
+
+            void work(uint32_t queueIndex);
+            void schedule(Job* job);
+            Job* findJob(int32_t queueIndex, std::minstd_rand& random);
+            void execute(Job* job);
+            int32_t currentQueue() const;
+    };
+}
\ No newline at end of file
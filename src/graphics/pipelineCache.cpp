@@ -0,0 +1,104 @@
+#include "pipelineCache.hpp"
+namespace Graphics {
+
+    PipelineCache::PipelineCache(VkDevice device, const VkPhysicalDeviceProperties& properties, const std::string& filename) : vk_logicalDevice(device), cachePath(filename) {
+        statsPath = cachePath;
+        statsPath += ".json";
+
+//------------------------------LOAD CACHE FILE------------------------------
+        std::vector<char> initialData;
+        std::ifstream file(cachePath, std::ios::ate | std::ios::binary);
+
+        if (file.is_open()) {
+            initialData.resize(static_cast<size_t>(file.tellg()));
+            file.seekg(0);
+            file.read(initialData.data(), initialData.size());
+
+            // A cache from another driver or GPU is useless at best, start from scratch instead of handing it to the driver
+            if (!validateHeader(initialData, properties)) {
+                std::cerr << "Pipeline cache " << cachePath.string() << " was created for another device or driver, ignoring it\n";
+                initialData.clear();
+            }
+        }
+        warmStart = !initialData.empty();
+
+//------------------------------CREATE PIPELINE CACHE------------------------------
+        VkPipelineCacheCreateInfo cacheInfo{};
+        cacheInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+        cacheInfo.initialDataSize = initialData.size();
+        cacheInfo.pInitialData = initialData.empty() ? nullptr : initialData.data();
+
+        if (vkCreatePipelineCache(vk_logicalDevice, &cacheInfo, nullptr, &vk_pipelineCache) != VK_SUCCESS) throw std::runtime_error("failed to create pipeline cache!");
+    }
+
+//------------------------------VALIDATE HEADER------------------------------
+    bool PipelineCache::validateHeader(const std::vector<char>& data, const VkPhysicalDeviceProperties& properties) {
+        VkPipelineCacheHeaderVersionOne header{};
+        if (data.size() < sizeof(header)) return false;
+        std::memcpy(&header, data.data(), sizeof(header));
+
+        return header.headerSize >= sizeof(header)
+            && header.headerVersion == VK_PIPELINE_CACHE_HEADER_VERSION_ONE
+            && header.vendorID == properties.vendorID
+            && header.deviceID == properties.deviceID
+            && std::memcmp(header.pipelineCacheUUID, properties.pipelineCacheUUID, VK_UUID_SIZE) == 0;
+    }
+
+//------------------------------SAVE------------------------------
+    void PipelineCache::save() {
+        size_t dataSize = 0;
+        if (vkGetPipelineCacheData(vk_logicalDevice, vk_pipelineCache, &dataSize, nullptr) != VK_SUCCESS || !dataSize) return;
+
+        std::vector<char> data(dataSize);
+        if (vkGetPipelineCacheData(vk_logicalDevice, vk_pipelineCache, &dataSize, data.data()) != VK_SUCCESS) return;
+
+        // Write next to the real file and rename, so a crash mid-write never leaves a truncated cache behind
+        if (cachePath.has_parent_path()) std::filesystem::create_directories(cachePath.parent_path());
+        std::filesystem::path tempPath = cachePath;
+        tempPath += ".tmp";
+
+        {
+            std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+            if (!file.is_open()) {
+                std::cerr << "Failed to write pipeline cache " << tempPath.string() << "\n";
+                return;
+            }
+            file.write(data.data(), dataSize);
+        }
+        std::filesystem::rename(tempPath, cachePath);
+    }
+
+//------------------------------REPORT SAVINGS------------------------------
+    void PipelineCache::reportSavings() {
+        nlohmann::json stats;
+        std::ifstream statsFile(statsPath);
+        if (statsFile.is_open()) stats = nlohmann::json::parse(statsFile, nullptr, false);
+        if (stats.is_discarded()) stats = nlohmann::json::object();
+
+        // The first run without a cache is the baseline every warm start is compared against
+        if (!warmStart || !stats.contains("coldCreationMs")) {
+            stats["coldCreationMs"] = creationMs;
+            std::cout << "Pipeline creation took " << creationMs << " ms (cold cache)\n";
+        } else {
+            double coldMs = stats.at("coldCreationMs").get<double>();
+            std::cout << "Pipeline creation took " << creationMs << " ms (warm cache), saved " << coldMs - creationMs << " ms against a cold start of " << coldMs << " ms\n";
+        }
+        stats["lastCreationMs"] = creationMs;
+        stats["lastWarmStart"] = warmStart;
+
+        std::ofstream out(statsPath);
+        if (out.is_open()) out << stats.dump(4) << "\n";
+    }
+
+//------------------------------DESTROY------------------------------
+    PipelineCache::~PipelineCache() {
+        try {
+            save();
+            reportSavings();
+        } catch (const std::exception& e) {
+            std::cerr << "Failed to save pipeline cache: " << e.what() << "\n";
+        }
+
+        if (vk_pipelineCache != VK_NULL_HANDLE) vkDestroyPipelineCache(vk_logicalDevice, vk_pipelineCache, nullptr);
+    }
+}
@@ -0,0 +1,35 @@
+#pragma once
+
+#include "../includes/graphics.hpp"
+#include <nlohmann/json.hpp>
+#include <stdexcept>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <cstring>
+#include <string>
+#include <vector>
+
+namespace Graphics {
+
+    class PipelineCache {
+
+        public:
+            PipelineCache(VkDevice device, const VkPhysicalDeviceProperties& properties, const std::string& filename);
+            ~PipelineCache();
+            void save();
+            inline void addCreationTime(double ms) { creationMs += ms; }
+            inline VkPipelineCache getCache() const { return vk_pipelineCache; }
+
+        private:
+            VkDevice vk_logicalDevice;
+            VkPipelineCache vk_pipelineCache = VK_NULL_HANDLE;
+            std::filesystem::path cachePath;
+            std::filesystem::path statsPath;
+            bool warmStart = false;
+            double creationMs = 0.0;
+
+            bool validateHeader(const std::vector<char>& data, const VkPhysicalDeviceProperties& properties);
+            void reportSavings();
+    };
+}
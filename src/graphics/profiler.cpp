@@ -0,0 +1,179 @@
+#include "profiler.hpp"
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+
+namespace Graphics {
+
+    namespace {
+        using Clock = std::chrono::steady_clock;
+
+        int64_t steadyNs() {
+            return std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now().time_since_epoch()).count();
+        }
+
+        // Profiler ticks taken with the steady clock around them, the midpoint pins both clocks to the same moment
+        struct ClockSample {
+            uint64_t ticks;
+            int64_t ns;
+        };
+
+        ClockSample sampleClocks() {
+            const int64_t before = steadyNs();
+            const uint64_t ticks = Profiler::now();
+            const int64_t after = steadyNs();
+            return {ticks, before + (after - before) / 2};
+        }
+
+        struct Registry {
+            std::mutex mutex;
+            std::vector<std::unique_ptr<ProfileRing>> rings;
+            std::unique_ptr<ProfileRing> gpuRing;
+            ClockSample origin = sampleClocks();
+            bool gpuCalibrated = false;
+        };
+
+        // Leaked on purpose, threads may still record while static destructors run at exit
+        Registry& registry() {
+            static Registry* instance = new Registry();
+            return *instance;
+        }
+    }
+
+    std::atomic<bool> Profiler::enabled = false;
+    thread_local ProfileRing* Profiler::threadRing = nullptr;
+
+//------------------------------RING------------------------------
+    void ProfileRing::copy(std::vector<ProfileEvent>& events) const {
+        const uint64_t first = head.load(std::memory_order_acquire);
+        const uint64_t begin = first > CAPACITY ? first - CAPACITY : 0;
+        std::vector<ProfileEvent> copied;
+        copied.reserve(first - begin);
+        for (uint64_t index = begin; index < first; index++) {
+            const Slot& slot = slots[index & (CAPACITY - 1)];
+            copied.push_back({slot.name.load(std::memory_order_relaxed), slot.start.load(std::memory_order_relaxed), slot.end.load(std::memory_order_relaxed)});
+        }
+
+        // Whatever the writer got to in the meantime, including the slot it may be halfway through, is torn
+        std::atomic_thread_fence(std::memory_order_acquire);
+        const uint64_t last = head.load(std::memory_order_relaxed);
+        const uint64_t valid = last + 1 > CAPACITY ? last + 1 - CAPACITY : 0;
+        for (uint64_t index = std::max(begin, valid); index < first; index++) {
+            const ProfileEvent& event = copied[index - begin];
+            if (event.name && event.end >= event.start) events.push_back(event);
+        }
+    }
+
+//------------------------------THREADS------------------------------
+    void Profiler::setEnabled(bool enabled) {
+        registry();
+        Profiler::enabled.store(enabled, std::memory_order_relaxed);
+    }
+
+    ProfileRing* Profiler::registerThread(const char* name) {
+        Registry& state = registry();
+        std::lock_guard<std::mutex> lock(state.mutex);
+        const uint32_t index = static_cast<uint32_t>(state.rings.size());
+        state.rings.push_back(std::make_unique<ProfileRing>(name ? name : "thread " + std::to_string(index), index, false));
+        threadRing = state.rings.back().get();
+        return threadRing;
+    }
+
+    void Profiler::setThreadName(const char* name) {
+        if (!threadRing) {
+            registerThread(name);
+            return;
+        }
+        Registry& state = registry();
+        std::lock_guard<std::mutex> lock(state.mutex);
+        threadRing->threadName = name;
+    }
+
+//------------------------------GPU------------------------------
+    void Profiler::recordGpu(const char* name, int64_t startNs, int64_t endNs) {
+        Registry& state = registry();
+        if (!state.gpuRing) {
+            std::lock_guard<std::mutex> lock(state.mutex);
+            state.gpuRing = std::make_unique<ProfileRing>("graphics queue", 0, true);
+        }
+        state.gpuRing->push(name, static_cast<uint64_t>(startNs), static_cast<uint64_t>(endNs));
+    }
+
+    void Profiler::setGpuCalibrated(bool calibrated) {
+        Registry& state = registry();
+        std::lock_guard<std::mutex> lock(state.mutex);
+        state.gpuCalibrated = calibrated;
+    }
+
+//------------------------------CHROME TRACE------------------------------
+    nlohmann::json Profiler::buildChromeTrace() {
+        Registry& state = registry();
+        std::lock_guard<std::mutex> lock(state.mutex);
+
+        // The tick rate comes from two samples as far apart as the trace is long. A trace taken right at startup
+        // would divide by almost nothing, so it waits until the samples are at least a few milliseconds apart
+        ClockSample sample = sampleClocks();
+        while (sample.ns - state.origin.ns < CALIBRATION_NS) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            sample = sampleClocks();
+        }
+        const double ticksPerNs = static_cast<double>(sample.ticks - state.origin.ticks) / static_cast<double>(sample.ns - state.origin.ns);
+        // Relative to the origin, so events recorded before it come out negative rather than wrapped
+        auto cpuUs = [&](uint64_t ticks) {
+            return static_cast<double>(static_cast<int64_t>(ticks - state.origin.ticks)) / ticksPerNs / 1000.0;
+        };
+        auto gpuUs = [&](uint64_t ns) {
+            return static_cast<double>(static_cast<int64_t>(ns) - state.origin.ns) / 1000.0;
+        };
+
+        nlohmann::json events = nlohmann::json::array();
+        auto metadata = [&events](const char* name, uint32_t pid, uint32_t tid, const std::string& value) {
+            events.push_back({{"name", name}, {"ph", "M"}, {"pid", pid}, {"tid", tid}, {"args", {{"name", value}}}});
+        };
+        auto addRing = [&](const ProfileRing& ring, uint32_t pid) {
+            metadata("thread_name", pid, ring.threadIndex, ring.threadName);
+            std::vector<ProfileEvent> ringEvents;
+            ring.copy(ringEvents);
+            for (const auto& event : ringEvents) {
+                const double start = ring.gpu ? gpuUs(event.start) : cpuUs(event.start);
+                const double end = ring.gpu ? gpuUs(event.end) : cpuUs(event.end);
+                events.push_back({{"name", event.name}, {"ph", "X"}, {"pid", pid}, {"tid", ring.threadIndex}, {"ts", start}, {"dur", end - start}});
+            }
+        };
+
+        metadata("process_name", CPU_PID, 0, "CPU");
+        for (const auto& ring : state.rings) addRing(*ring, CPU_PID);
+        if (state.gpuRing) {
+            metadata("process_name", GPU_PID, 0, "GPU");
+            addRing(*state.gpuRing, GPU_PID);
+        }
+
+        nlohmann::json trace;
+        trace["traceEvents"] = std::move(events);
+        trace["displayTimeUnit"] = "ns";
+#ifdef URAN_PROFILER_TSC
+        trace["otherData"]["clock"] = "tsc";
+        trace["otherData"]["ticksPerNs"] = ticksPerNs;
+#else
+        trace["otherData"]["clock"] = "steady";
+#endif
+        // Uncalibrated GPU zones are lined up with the CPU at each frame's submit, gaps between queue and CPU are lost
+        trace["otherData"]["gpuCalibrated"] = state.gpuCalibrated;
+        return trace;
+    }
+
+    void Profiler::writeChromeTrace(const std::string& filename) {
+        const nlohmann::json trace = buildChromeTrace();
+        const std::filesystem::path path(filename);
+        if (path.has_parent_path()) std::filesystem::create_directories(path.parent_path());
+        std::ofstream file(path);
+        if (!file) throw std::runtime_error("failed to write profiler trace!");
+        file << trace.dump();
+        std::cout << "Profiler: " << trace["traceEvents"].size() << " events written to " << filename << std::endl;
+    }
+}
\ No newline at end of file
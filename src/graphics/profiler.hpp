@@ -0,0 +1,132 @@
+#pragma once
+
+#include <nlohmann/json.hpp>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#ifdef _MSC_VER
+#include <intrin.h>
+#else
+#include <x86intrin.h>
+#endif
+#define URAN_PROFILER_TSC 1
+#endif
+
+namespace Graphics {
+
+    // A finished zone. Names are never copied, zones only take string literals
+    struct ProfileEvent {
+        const char* name;
+        uint64_t start;
+        uint64_t end;
+    };
+
+    // Events of one thread. Only the owning thread writes, with plain stores and no lock; a reader copies the ring and
+    // throws away whatever the writer may have lapped while it was copying
+    class ProfileRing {
+
+        public:
+            static constexpr uint64_t CAPACITY = 1 << 14;
+
+            ProfileRing(std::string threadName, uint32_t threadIndex, bool gpu) : threadName(std::move(threadName)), threadIndex(threadIndex), gpu(gpu) {}
+
+            inline void push(const char* name, uint64_t start, uint64_t end) {
+                const uint64_t index = head.load(std::memory_order_relaxed);
+                Slot& slot = slots[index & (CAPACITY - 1)];
+                slot.name.store(name, std::memory_order_relaxed);
+                slot.start.store(start, std::memory_order_relaxed);
+                slot.end.store(end, std::memory_order_relaxed);
+                head.store(index + 1, std::memory_order_release);
+            }
+            void copy(std::vector<ProfileEvent>& events) const;
+
+            std::string threadName;
+            const uint32_t threadIndex;
+            // GPU rings hold steady clock nanoseconds, CPU rings raw profiler ticks
+            const bool gpu;
+
+        private:
+            struct Slot {
+                std::atomic<const char*> name = nullptr;
+                std::atomic<uint64_t> start = 0;
+                std::atomic<uint64_t> end = 0;
+            };
+
+            std::atomic<uint64_t> head = 0;
+            std::array<Slot, CAPACITY> slots{};
+    };
+
+    // Process wide, so zones can be dropped anywhere without passing anything around. Every thread gets its own ring on
+    // its first zone, rings live until exit so a trace still shows threads that are gone. With the profiler off a zone
+    // is one relaxed load; on it is two TSC reads and four stores into the thread's ring
+    class Profiler {
+
+        public:
+            static void setEnabled(bool enabled);
+            static inline bool isEnabled() { return enabled.load(std::memory_order_relaxed); }
+
+            // Ticks of the TSC where there is one, steady clock nanoseconds elsewhere. Converted once, on export
+            static inline uint64_t now() {
+#ifdef URAN_PROFILER_TSC
+                return __rdtsc();
+#else
+                return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count());
+#endif
+            }
+
+            static inline void record(const char* name, uint64_t start, uint64_t end) {
+                ProfileRing* ring = threadRing;
+                if (!ring) ring = registerThread(nullptr);
+                ring->push(name, start, end);
+            }
+            // Names the calling thread in traces, threads that never call it are numbered
+            static void setThreadName(const char* name);
+            // A GPU zone already in steady clock nanoseconds. Single writer: only the thread collecting GPU results
+            static void recordGpu(const char* name, int64_t startNs, int64_t endNs);
+            static void setGpuCalibrated(bool calibrated);
+
+            // Chrome trace event format, which Perfetto and chrome://tracing both open
+            static nlohmann::json buildChromeTrace();
+            static void writeChromeTrace(const std::string& filename);
+
+        private:
+            static constexpr uint32_t CPU_PID = 1;
+            static constexpr uint32_t GPU_PID = 2;
+            // Least time (ns) between the two clock samples the tick rate is derived from
+            static constexpr int64_t CALIBRATION_NS = 20'000'000;
+
+            static std::atomic<bool> enabled;
+            static thread_local ProfileRing* threadRing;
+
+            static ProfileRing* registerThread(const char* name);
+    };
+
+    class ProfileZone {
+
+        public:
+            explicit ProfileZone(const char* name) : name(Profiler::isEnabled() ? name : nullptr), start(this->name ? Profiler::now() : 0) {}
+            ~ProfileZone() { if (name) Profiler::record(name, start, Profiler::now()); }
+            ProfileZone(const ProfileZone&) = delete;
+            ProfileZone& operator=(const ProfileZone&) = delete;
+
+        private:
+            const char* name;
+            uint64_t start;
+    };
+}
+
+// URAN_NO_PROFILER compiles every zone out, otherwise they stay in and the profiler is switched at runtime
+#ifdef URAN_NO_PROFILER
+#define PROFILE_ZONE(name)
+#define PROFILE_THREAD(name)
+#else
+#define URAN_PROFILE_CONCAT_INNER(a, b) a##b
+#define URAN_PROFILE_CONCAT(a, b) URAN_PROFILE_CONCAT_INNER(a, b)
+#define PROFILE_ZONE(name) ::Graphics::ProfileZone URAN_PROFILE_CONCAT(profileZone, __LINE__)(name)
+#define PROFILE_THREAD(name) ::Graphics::Profiler::setThreadName(name)
+#endif
\ No newline at end of file
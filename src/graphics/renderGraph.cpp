@@ -0,0 +1,445 @@
+#include "renderGraph.hpp"
+namespace Graphics {
+
+//------------------------------PASS DECLARATION------------------------------
+    RenderGraphPass& RenderGraphPass::writeColor(RenderResource resource, VkAttachmentLoadOp loadOp, VkClearColorValue clearValue) {
+        VkClearValue clear{};
+        clear.color = clearValue;
+        accesses.push_back({resource, AccessType::Color, loadOp, clear, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT});
+        return *this;
+    }
+
+    RenderGraphPass& RenderGraphPass::writeDepth(RenderResource resource, VkAttachmentLoadOp loadOp, VkClearDepthStencilValue clearValue) {
+        VkClearValue clear{};
+        clear.depthStencil = clearValue;
+        accesses.push_back({resource, AccessType::Depth, loadOp, clear, VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT});
+        return *this;
+    }
+
+    RenderGraphPass& RenderGraphPass::readTexture(RenderResource resource, VkPipelineStageFlags stages) {
+        accesses.push_back({resource, AccessType::Sampled, VK_ATTACHMENT_LOAD_OP_DONT_CARE, {}, stages});
+        return *this;
+    }
+
+    RenderGraphPass& RenderGraphPass::setRecord(RecordFunction function) {
+        record = std::move(function);
+        return *this;
+    }
+
+//------------------------------GRAPH DECLARATION------------------------------
+    RenderGraph::RenderGraph(VkDevice device, Allocator& allocator, DeletionQueue& deletionQueue, uint32_t frameSlots) : vk_logicalDevice(device), allocator(allocator), deletionQueue(deletionQueue), frameSlots(frameSlots) {}
+
+    RenderResource RenderGraph::importImage(const std::string& name, VkFormat format, VkPipelineStageFlags firstStages, VkImageLayout finalLayout, VkPipelineStageFlags finalStages, VkAccessFlags finalAccess) {
+        if (compiled) throw std::runtime_error("render graph resources have to be declared before compile!");
+
+        Resource resource;
+        resource.name = name;
+        resource.format = format;
+        resource.imported = true;
+        resource.firstStages = firstStages;
+        resource.finalLayout = finalLayout;
+        resource.finalStages = finalStages;
+        resource.finalAccess = finalAccess;
+        resources.push_back(resource);
+        return static_cast<RenderResource>(resources.size() - 1);
+    }
+
+    RenderResource RenderGraph::createTransientImage(const std::string& name, VkFormat format, VkImageUsageFlags extraUsage) {
+        if (compiled) throw std::runtime_error("render graph resources have to be declared before compile!");
+
+        Resource resource;
+        resource.name = name;
+        resource.format = format;
+        resource.imported = false;
+        resource.usage = extraUsage;
+        resources.push_back(resource);
+        return static_cast<RenderResource>(resources.size() - 1);
+    }
+
+    RenderGraphPass& RenderGraph::addPass(const std::string& name) {
+        if (compiled) throw std::runtime_error("render graph passes have to be declared before compile!");
+
+        passes.push_back(RenderGraphPass(name));
+        return passes.back();
+    }
+
+//------------------------------COMPILE------------------------------
+    void RenderGraph::compile() {
+        if (compiled) throw std::runtime_error("render graph is already compiled!");
+
+        // Walk back from the imported images: a pass is live when a later pass, or the outside world, needs what it
+        // writes. A write that doesn't load makes earlier contents of that image irrelevant
+        std::vector<bool> needed(resources.size());
+        for (size_t i = 0; i < resources.size(); i++) needed[i] = resources[i].imported;
+
+        for (auto pass = passes.rbegin(); pass != passes.rend(); ++pass) {
+            bool live = false;
+            for (const auto& access : pass->accesses) {
+                if (access.type != RenderGraphPass::AccessType::Sampled && needed[access.resource]) live = true;
+            }
+
+            pass->culled = !live;
+            if (!live) continue;
+
+            for (const auto& access : pass->accesses) {
+                if (access.type != RenderGraphPass::AccessType::Sampled && access.loadOp != VK_ATTACHMENT_LOAD_OP_LOAD && !resources[access.resource].imported) needed[access.resource] = false;
+            }
+            for (const auto& access : pass->accesses) {
+                if (access.type == RenderGraphPass::AccessType::Sampled || access.loadOp == VK_ATTACHMENT_LOAD_OP_LOAD) needed[access.resource] = true;
+            }
+        }
+
+        for (auto& pass : passes) {
+            if (!pass.culled) livePasses.push_back(&pass);
+        }
+
+        // Lifetimes and usage of every image over the live passes
+        for (uint32_t i = 0; i < livePasses.size(); i++) {
+            for (const auto& access : livePasses[i]->accesses) {
+                Resource& resource = resources[access.resource];
+
+                if (resource.firstPass > i && access.type == RenderGraphPass::AccessType::Sampled) throw std::runtime_error("render graph image " + resource.name + " is sampled before anything wrote it!");
+
+                resource.firstPass = std::min(resource.firstPass, i);
+                resource.lastPass = i;
+                if (access.type == RenderGraphPass::AccessType::Color) resource.usage |= VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT;
+                if (access.type == RenderGraphPass::AccessType::Depth) resource.usage |= VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT;
+                if (access.type == RenderGraphPass::AccessType::Sampled) resource.usage |= VK_IMAGE_USAGE_SAMPLED_BIT;
+            }
+        }
+
+        // An attachment that lives and dies inside one render pass never has to leave tile memory
+        for (auto& resource : resources) {
+            const VkImageUsageFlags attachmentUsage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT;
+            resource.tileOnly = !resource.imported && resource.firstPass == resource.lastPass && !(resource.usage & ~attachmentUsage);
+            if (resource.tileOnly) resource.usage |= VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT;
+        }
+
+        std::vector<ResourceState> states(resources.size());
+        for (size_t i = 0; i < resources.size(); i++) {
+            if (resources[i].imported) states[i].stages = resources[i].firstStages;
+        }
+
+        ResourceState retired;
+        for (uint32_t i = 0; i < livePasses.size(); i++) {
+            createRenderPass(*livePasses[i], i, states, retired);
+
+            // The memory of images that just died may be handed to an image that starts later
+            for (size_t r = 0; r < resources.size(); r++) {
+                if (resources[r].imported || resources[r].lastPass != i || resources[r].firstPass > i) continue;
+                retired.stages |= states[r].stages;
+                retired.access |= states[r].access;
+            }
+        }
+
+        stats.passes = static_cast<uint32_t>(livePasses.size());
+        stats.culledPasses = static_cast<uint32_t>(passes.size() - livePasses.size());
+        compiled = true;
+    }
+
+//------------------------------CREATE RENDER PASS------------------------------
+    void RenderGraph::createRenderPass(RenderGraphPass& pass, uint32_t passIndex, std::vector<ResourceState>& states, ResourceState& retired) {
+        std::vector<VkAttachmentDescription> descriptions;
+        std::vector<VkAttachmentReference> colorRefs;
+        VkAttachmentReference depthRef{};
+        bool hasDepth = false;
+
+        VkSubpassDependency incoming{};
+        incoming.srcSubpass = VK_SUBPASS_EXTERNAL;
+        incoming.dstSubpass = 0;
+
+        VkSubpassDependency outgoing{};
+        outgoing.srcSubpass = 0;
+        outgoing.dstSubpass = VK_SUBPASS_EXTERNAL;
+
+        bool startsTransient = false;
+        for (const auto& access : pass.accesses) {
+            const Resource& resource = resources[access.resource];
+            ResourceState& state = states[access.resource];
+            const VkAccessFlags writes = accessFor(access) & (VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT);
+
+            incoming.srcStageMask |= state.stages;
+            incoming.srcAccessMask |= state.access;
+            incoming.dstStageMask |= stagesFor(access);
+            incoming.dstAccessMask |= accessFor(access);
+            if (!resource.imported && resource.firstPass == passIndex) startsTransient = true;
+
+            // Whoever wrote a sampled image already left it in SHADER_READ_ONLY_OPTIMAL, only later writers wait on the read
+            if (access.type == RenderGraphPass::AccessType::Sampled) {
+                state.stages |= access.stages;
+                continue;
+            }
+
+            const VkImageLayout layout = layoutFor(access.type);
+            const RenderGraphPass::Access* next = nextUse(access.resource, passIndex);
+
+            VkAttachmentDescription description{};
+            description.format = resource.format;
+            description.samples = VK_SAMPLE_COUNT_1_BIT;
+            description.loadOp = state.layout == VK_IMAGE_LAYOUT_UNDEFINED && access.loadOp == VK_ATTACHMENT_LOAD_OP_LOAD ? VK_ATTACHMENT_LOAD_OP_DONT_CARE : access.loadOp;
+            description.storeOp = next || resource.imported ? VK_ATTACHMENT_STORE_OP_STORE : VK_ATTACHMENT_STORE_OP_DONT_CARE;
+            description.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+            description.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+            description.initialLayout = state.layout;
+            description.finalLayout = next ? layoutFor(next->type) : resource.imported ? resource.finalLayout : layout;
+
+            VkAttachmentReference reference{};
+            reference.attachment = static_cast<uint32_t>(descriptions.size());
+            reference.layout = layout;
+            if (access.type == RenderGraphPass::AccessType::Depth) {
+                depthRef = reference;
+                hasDepth = true;
+            } else colorRefs.push_back(reference);
+
+            descriptions.push_back(description);
+            pass.attachments.push_back(access.resource);
+            pass.clearValues.push_back(access.clearValue);
+
+            // The next user is known, so the end of this pass hands the image over directly and nobody has to wait on it later
+            if (next || resource.imported) {
+                outgoing.srcStageMask |= stagesFor(access);
+                outgoing.srcAccessMask |= writes;
+                outgoing.dstStageMask |= next ? stagesFor(*next) : resource.finalStages;
+                outgoing.dstAccessMask |= next ? accessFor(*next) : resource.finalAccess;
+                state = {description.finalLayout, 0, 0};
+            } else {
+                state = {layout, stagesFor(access), writes};
+            }
+        }
+
+        // A transient starting here may sit in the memory of one that died earlier
+        if (startsTransient) {
+            incoming.srcStageMask |= retired.stages;
+            incoming.srcAccessMask |= retired.access;
+        }
+
+        VkSubpassDescription subpass{};
+        subpass.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
+        subpass.colorAttachmentCount = static_cast<uint32_t>(colorRefs.size());
+        subpass.pColorAttachments = colorRefs.data();
+        subpass.pDepthStencilAttachment = hasDepth ? &depthRef : nullptr;
+
+        // Without a source there is no hazard, and the implicit dependencies already cover handing images to BOTTOM_OF_PIPE
+        std::vector<VkSubpassDependency> dependencies;
+        if (incoming.srcStageMask) dependencies.push_back(incoming);
+        if (outgoing.dstStageMask & ~VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT || outgoing.dstAccessMask) dependencies.push_back(outgoing);
+
+        VkRenderPassCreateInfo renderPassInfo{};
+        renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
+        renderPassInfo.attachmentCount = static_cast<uint32_t>(descriptions.size());
+        renderPassInfo.pAttachments = descriptions.data();
+        renderPassInfo.subpassCount = 1;
+        renderPassInfo.pSubpasses = &subpass;
+        renderPassInfo.dependencyCount = static_cast<uint32_t>(dependencies.size());
+        renderPassInfo.pDependencies = dependencies.data();
+
+        if (vkCreateRenderPass(vk_logicalDevice, &renderPassInfo, nullptr, &pass.vk_renderPass) != VK_SUCCESS) throw std::runtime_error("failed to create render pass " + pass.name + "!");
+        stats.dependencies += static_cast<uint32_t>(dependencies.size());
+    }
+
+    const RenderGraphPass::Access* RenderGraph::nextUse(RenderResource resource, uint32_t afterPass) const {
+        for (uint32_t i = afterPass + 1; i < livePasses.size(); i++) {
+            for (const auto& access : livePasses[i]->accesses) {
+                if (access.resource == resource) return &access;
+            }
+        }
+        return nullptr;
+    }
+
+//------------------------------RESIZE------------------------------
+    void RenderGraph::resize(VkExtent2D newExtent) {
+        if (!compiled) throw std::runtime_error("render graph has to be compiled before it is sized!");
+
+        // Retired in the order they have to die: framebuffers, then views and images, then the memory under them
+        for (auto& pass : passes) pass.framebuffers.clear();
+        slotImages.clear();
+        memory.clear();
+
+        extent = newExtent;
+        slotImages.resize(frameSlots);
+        for (auto& images : slotImages) images.resize(resources.size());
+        stats.transientBytes = 0;
+        stats.unaliasedBytes = 0;
+        stats.lazilyAllocated = false;
+
+        // In order of first use, so an alias group only has to remember when its newest member dies
+        std::vector<RenderResource> order;
+        for (RenderResource r = 0; r < resources.size(); r++) {
+            if (!resources[r].imported && resources[r].firstPass <= resources[r].lastPass) order.push_back(r);
+        }
+        std::stable_sort(order.begin(), order.end(), [this](RenderResource a, RenderResource b) { return resources[a].firstPass < resources[b].firstPass; });
+        stats.transientImages = static_cast<uint32_t>(order.size());
+
+        struct AliasGroup {
+            uint32_t lastPass;
+            bool lazy;
+            VkMemoryRequirements requirements;
+            std::vector<RenderResource> members;
+        };
+
+        for (uint32_t slot = 0; slot < frameSlots; slot++) {
+            std::vector<AliasGroup> groups;
+
+            for (RenderResource r : order) {
+                const Resource& resource = resources[r];
+
+                VkImageCreateInfo imageInfo{};
+                imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+                imageInfo.imageType = VK_IMAGE_TYPE_2D;
+                imageInfo.format = resource.format;
+                imageInfo.extent = {extent.width, extent.height, 1};
+                imageInfo.mipLevels = 1;
+                imageInfo.arrayLayers = 1;
+                imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+                imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+                imageInfo.usage = resource.usage;
+                imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+                imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+
+                VkImage image;
+                if (vkCreateImage(vk_logicalDevice, &imageInfo, nullptr, &image) != VK_SUCCESS) throw std::runtime_error("failed to create render graph image " + resource.name + "!");
+                slotImages[slot][r].image = ImageHandle(vk_logicalDevice, image, &deletionQueue);
+
+                VkMemoryRequirements requirements;
+                vkGetImageMemoryRequirements(vk_logicalDevice, image, &requirements);
+                const bool lazy = resource.tileOnly && allocator.supportsMemoryType(requirements.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT | VK_MEMORY_PROPERTY_LAZILY_ALLOCATED_BIT);
+                if (slot == 0) stats.unaliasedBytes += requirements.size;
+
+                auto group = std::find_if(groups.begin(), groups.end(), [&](const AliasGroup& candidate) {
+                    return candidate.lastPass < resource.firstPass && candidate.lazy == lazy && (candidate.requirements.memoryTypeBits & requirements.memoryTypeBits);
+                });
+
+                if (group == groups.end()) {
+                    groups.push_back({resource.lastPass, lazy, requirements, {r}});
+                    continue;
+                }
+
+                group->lastPass = resource.lastPass;
+                group->requirements.size = std::max(group->requirements.size, requirements.size);
+                group->requirements.alignment = std::max(group->requirements.alignment, requirements.alignment);
+                group->requirements.memoryTypeBits &= requirements.memoryTypeBits;
+                group->members.push_back(r);
+            }
+
+            for (const auto& group : groups) {
+                const VkMemoryPropertyFlags properties = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT | (group.lazy ? VK_MEMORY_PROPERTY_LAZILY_ALLOCATED_BIT : 0);
+                const Allocation allocation = allocator.allocateImageMemory(group.requirements, properties);
+                memory.emplace_back(&allocator, allocation, &deletionQueue);
+
+                for (RenderResource r : group.members) {
+                    TransientImage& image = slotImages[slot][r];
+                    vkBindImageMemory(vk_logicalDevice, image.image.get(), allocation.memory, allocation.offset);
+
+                    VkImageViewCreateInfo viewInfo{};
+                    viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+                    viewInfo.image = image.image.get();
+                    viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+                    viewInfo.format = resources[r].format;
+                    viewInfo.subresourceRange.aspectMask = isDepthFormat(resources[r].format) ? VK_IMAGE_ASPECT_DEPTH_BIT : VK_IMAGE_ASPECT_COLOR_BIT;
+                    viewInfo.subresourceRange.baseMipLevel = 0;
+                    viewInfo.subresourceRange.levelCount = 1;
+                    viewInfo.subresourceRange.baseArrayLayer = 0;
+                    viewInfo.subresourceRange.layerCount = 1;
+
+                    VkImageView view;
+                    if (vkCreateImageView(vk_logicalDevice, &viewInfo, nullptr, &view) != VK_SUCCESS) throw std::runtime_error("failed to create render graph image view " + resources[r].name + "!");
+                    image.view = ImageViewHandle(vk_logicalDevice, view, &deletionQueue);
+                }
+
+                if (slot == 0) {
+                    stats.transientBytes += group.requirements.size;
+                    stats.lazilyAllocated = stats.lazilyAllocated || group.lazy;
+                }
+            }
+        }
+    }
+
+//------------------------------EXECUTE------------------------------
+    void RenderGraph::setImportedView(RenderResource resource, VkImageView view) {
+        resources[resource].importedView = view;
+    }
+
+    void RenderGraph::execute(VkCommandBuffer commandBuffer, uint32_t frameSlot) {
+        for (RenderGraphPass* pass : livePasses) {
+            RenderPassTarget target{pass->vk_renderPass, getFramebuffer(*pass, frameSlot), extent};
+
+            VkRenderPassBeginInfo renderPassInfo{};
+            renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+            renderPassInfo.renderPass = target.renderPass;
+            renderPassInfo.framebuffer = target.framebuffer;
+            renderPassInfo.renderArea.offset = {0, 0};
+            renderPassInfo.renderArea.extent = extent;
+            renderPassInfo.clearValueCount = static_cast<uint32_t>(pass->clearValues.size());
+            renderPassInfo.pClearValues = pass->clearValues.data();
+
+            vkCmdBeginRenderPass(commandBuffer, &renderPassInfo, pass->secondaryContents ? VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS : VK_SUBPASS_CONTENTS_INLINE);
+            if (pass->record) pass->record(commandBuffer, target);
+            vkCmdEndRenderPass(commandBuffer);
+        }
+    }
+
+    VkFramebuffer RenderGraph::getFramebuffer(RenderGraphPass& pass, uint32_t frameSlot) {
+        std::vector<VkImageView> views;
+        for (RenderResource r : pass.attachments) {
+            VkImageView view = resources[r].imported ? resources[r].importedView : slotImages[frameSlot][r].view.get();
+            if (view == VK_NULL_HANDLE) throw std::runtime_error("render graph image " + resources[r].name + " has no view!");
+            views.push_back(view);
+        }
+
+        // Imported views change every frame (swapchain images), so one framebuffer is kept per combination seen
+        auto cached = pass.framebuffers.find(views);
+        if (cached != pass.framebuffers.end()) return cached->second.get();
+
+        VkFramebufferCreateInfo framebufferInfo{};
+        framebufferInfo.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
+        framebufferInfo.renderPass = pass.vk_renderPass;
+        framebufferInfo.attachmentCount = static_cast<uint32_t>(views.size());
+        framebufferInfo.pAttachments = views.data();
+        framebufferInfo.width = extent.width;
+        framebufferInfo.height = extent.height;
+        framebufferInfo.layers = 1;
+
+        VkFramebuffer framebuffer;
+        if (vkCreateFramebuffer(vk_logicalDevice, &framebufferInfo, nullptr, &framebuffer) != VK_SUCCESS) throw std::runtime_error("failed to create framebuffer!");
+        pass.framebuffers.emplace(std::move(views), FramebufferHandle(vk_logicalDevice, framebuffer, &deletionQueue));
+        return framebuffer;
+    }
+
+//------------------------------ACCESS HELPERS------------------------------
+    VkImageLayout RenderGraph::layoutFor(RenderGraphPass::AccessType type) {
+        switch (type) {
+            case RenderGraphPass::AccessType::Color: return VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+            case RenderGraphPass::AccessType::Depth: return VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+            case RenderGraphPass::AccessType::Sampled: return VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+        }
+        return VK_IMAGE_LAYOUT_UNDEFINED;
+    }
+
+    VkPipelineStageFlags RenderGraph::stagesFor(const RenderGraphPass::Access& access) {
+        return access.stages;
+    }
+
+    VkAccessFlags RenderGraph::accessFor(const RenderGraphPass::Access& access) {
+        const bool load = access.loadOp == VK_ATTACHMENT_LOAD_OP_LOAD;
+        switch (access.type) {
+            case RenderGraphPass::AccessType::Color: return VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | (load ? VK_ACCESS_COLOR_ATTACHMENT_READ_BIT : 0);
+            case RenderGraphPass::AccessType::Depth: return VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+            case RenderGraphPass::AccessType::Sampled: return VK_ACCESS_SHADER_READ_BIT;
+        }
+        return 0;
+    }
+
+    bool RenderGraph::isDepthFormat(VkFormat format) {
+        return format == VK_FORMAT_D16_UNORM || format == VK_FORMAT_X8_D24_UNORM_PACK32 || format == VK_FORMAT_D32_SFLOAT ||
+               format == VK_FORMAT_D16_UNORM_S8_UINT || format == VK_FORMAT_D24_UNORM_S8_UINT || format == VK_FORMAT_D32_SFLOAT_S8_UINT;
+    }
+
+//------------------------------DESTROY------------------------------
+    RenderGraph::~RenderGraph() {
+        // Framebuffers, images and memory retire on their own, the owner flushes the queue once the device is idle
+        for (auto& pass : passes) {
+            pass.framebuffers.clear();
+            if (pass.vk_renderPass != VK_NULL_HANDLE) vkDestroyRenderPass(vk_logicalDevice, pass.vk_renderPass, nullptr);
+        }
+    }
+}
\ No newline at end of file
@@ -0,0 +1,162 @@
+#pragma once
+
+#include "../includes/graphics.hpp"
+#include "allocator.hpp"
+#include "deletionQueue.hpp"
+#include "vulkanHandle.hpp"
+#include <stdexcept>
+#include <algorithm>
+#include <deque>
+#include <functional>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace Graphics {
+
+    using RenderResource = uint32_t;
+
+    // Where a pass renders to, handed to its record function inside the render pass the graph has begun
+    struct RenderPassTarget {
+        VkRenderPass renderPass = VK_NULL_HANDLE;
+        VkFramebuffer framebuffer = VK_NULL_HANDLE;
+        VkExtent2D extent{};
+    };
+
+    struct RenderGraphStats {
+        uint32_t passes = 0;
+        uint32_t culledPasses = 0;
+        uint32_t dependencies = 0;
+        uint32_t transientImages = 0;
+        // Per frame slot: what the transients occupy after aliasing, and what they would need without it
+        VkDeviceSize transientBytes = 0;
+        VkDeviceSize unaliasedBytes = 0;
+        bool lazilyAllocated = false;
+    };
+
+    // One render pass of the graph. Passes only declare which images they touch and how, the graph derives the
+    // layouts, load/store ops and dependencies from the order the passes were added in
+    class RenderGraphPass {
+
+        public:
+            using RecordFunction = std::function<void(VkCommandBuffer, const RenderPassTarget&)>;
+
+            RenderGraphPass& writeColor(RenderResource resource, VkAttachmentLoadOp loadOp, VkClearColorValue clearValue = {});
+            RenderGraphPass& writeDepth(RenderResource resource, VkAttachmentLoadOp loadOp, VkClearDepthStencilValue clearValue = {1.0f, 0});
+            RenderGraphPass& readTexture(RenderResource resource, VkPipelineStageFlags stages = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT);
+            RenderGraphPass& setRecord(RecordFunction function);
+            // Only changes how the render pass is begun, so it may be switched after the graph was compiled
+            inline RenderGraphPass& setSecondaryContents(bool secondary) { secondaryContents = secondary; return *this; }
+            inline VkRenderPass getRenderPass() const { return vk_renderPass; }
+            inline const std::string& getName() const { return name; }
+            inline bool isCulled() const { return culled; }
+
+        private:
+            friend class RenderGraph;
+
+            enum class AccessType {
+                Color,
+                Depth,
+                Sampled
+            };
+
+            struct Access {
+                RenderResource resource;
+                AccessType type;
+                VkAttachmentLoadOp loadOp;
+                VkClearValue clearValue;
+                VkPipelineStageFlags stages;
+            };
+
+            std::string name;
+            std::vector<Access> accesses;
+            bool secondaryContents = false;
+            RecordFunction record;
+            bool culled = false;
+            VkRenderPass vk_renderPass = VK_NULL_HANDLE;
+            std::vector<RenderResource> attachments;
+            std::vector<VkClearValue> clearValues;
+            std::map<std::vector<VkImageView>, FramebufferHandle> framebuffers;
+
+            RenderGraphPass(const std::string& name) : name(name) {}
+    };
+
+    // Builds the frame out of RenderGraphPasses. compile() drops passes that don't contribute to an imported image,
+    // folds every layout transition into the render passes and only emits the subpass dependencies a hazard needs.
+    // Transient images get their memory in resize(): images whose lifetimes don't overlap alias one allocation, and
+    // images that never leave a single pass use LAZILY_ALLOCATED memory where the device has it
+    class RenderGraph {
+
+        public:
+            // Images, views, memory and framebuffers the graph lets go of are retired into deletionQueue
+            RenderGraph(VkDevice device, Allocator& allocator, DeletionQueue& deletionQueue, uint32_t frameSlots);
+            ~RenderGraph();
+            RenderGraph(const RenderGraph&) = delete;
+            RenderGraph& operator=(const RenderGraph&) = delete;
+
+            // An image owned outside the graph whose view is set every frame. firstStages is where whatever produced it
+            // (e.g. the acquire semaphore wait) lands, after the last pass it is left in finalLayout for finalStages/finalAccess
+            RenderResource importImage(const std::string& name, VkFormat format, VkPipelineStageFlags firstStages, VkImageLayout finalLayout, VkPipelineStageFlags finalStages = VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, VkAccessFlags finalAccess = 0);
+            // Sized to the graph extent, its usage is derived from the passes using it plus extraUsage
+            RenderResource createTransientImage(const std::string& name, VkFormat format, VkImageUsageFlags extraUsage = 0);
+            RenderGraphPass& addPass(const std::string& name);
+            void compile();
+            // (Re)creates the transient images of every frame slot. The previous images and framebuffers are retired, frames
+            // in flight may still be using them
+            void resize(VkExtent2D extent);
+            void setImportedView(RenderResource resource, VkImageView view);
+            void execute(VkCommandBuffer commandBuffer, uint32_t frameSlot);
+            inline const RenderGraphStats& getStats() const { return stats; }
+
+        private:
+            struct Resource {
+                std::string name;
+                VkFormat format;
+                bool imported;
+                VkImageUsageFlags usage = 0;
+                VkPipelineStageFlags firstStages = 0;
+                VkImageLayout finalLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+                VkPipelineStageFlags finalStages = 0;
+                VkAccessFlags finalAccess = 0;
+                VkImageView importedView = VK_NULL_HANDLE;
+                // Lifetime in live pass indices, a resource nobody uses keeps firstPass > lastPass
+                uint32_t firstPass = UINT32_MAX;
+                uint32_t lastPass = 0;
+                bool tileOnly = false;
+            };
+
+            struct ResourceState {
+                VkImageLayout layout = VK_IMAGE_LAYOUT_UNDEFINED;
+                // Uses and writes no dependency has covered yet
+                VkPipelineStageFlags stages = 0;
+                VkAccessFlags access = 0;
+            };
+
+            // The view is declared last so it is retired before its image
+            struct TransientImage {
+                ImageHandle image;
+                ImageViewHandle view;
+            };
+
+            VkDevice vk_logicalDevice;
+            Allocator& allocator;
+            DeletionQueue& deletionQueue;
+            uint32_t frameSlots;
+            std::vector<Resource> resources;
+            std::deque<RenderGraphPass> passes;
+            std::vector<RenderGraphPass*> livePasses;
+            std::vector<std::vector<TransientImage>> slotImages;
+            std::vector<MemoryHandle> memory;
+            VkExtent2D extent{};
+            bool compiled = false;
+            RenderGraphStats stats;
+
+            void createRenderPass(RenderGraphPass& pass, uint32_t passIndex, std::vector<ResourceState>& states, ResourceState& retired);
+            const RenderGraphPass::Access* nextUse(RenderResource resource, uint32_t afterPass) const;
+            VkFramebuffer getFramebuffer(RenderGraphPass& pass, uint32_t frameSlot);
+            static VkImageLayout layoutFor(RenderGraphPass::AccessType type);
+            static VkPipelineStageFlags stagesFor(const RenderGraphPass::Access& access);
+            static VkAccessFlags accessFor(const RenderGraphPass::Access& access);
+            static bool isDepthFormat(VkFormat format);
+    };
+}
\ No newline at end of file
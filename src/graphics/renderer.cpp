@@ -1,73 +1,717 @@
 #include "renderer.hpp"
+#include "shaders/vertexShader.vert.hpp"
+#include "shaders/fragmentShader.frag.hpp"
 namespace Graphics {
 
-    Renderer::Renderer(VkDevice device, VkExtent2D swapChainExtent, VkFormat swapChainImageFormat, std::vector<VkImageView> swapChainImageViews, VkCommandPool commandPool) : vk_logicalDevice(device) {
+    using Clock = std::chrono::steady_clock;
 
-//------------------------------CREATE SHADER MODULE------------------------------
-        auto vk_vertShaderCode = readShaderFile("../shaders/vert.spv");
-        auto vk_fragShaderCode = readShaderFile("../shaders/frag.spv");
-        vk_vertShaderModule = createShaderModule(vk_vertShaderCode, device, swapChainExtent);
-        vk_fragShaderModule = createShaderModule(vk_fragShaderCode, device, swapChainExtent);
+    static double elapsedMs(Clock::time_point start, Clock::time_point end) {
+        return std::chrono::duration<double, std::milli>(end - start).count();
+    }
+
+    Renderer::Renderer(VkDevice device, VkExtent2D swapChainExtent, VkFormat swapChainImageFormat, std::vector<VkImageView> swapChainImageViews, uint32_t graphicsQueueFamily, PipelineCache& pipelineCache, Allocator& allocator, Uploader& uploader, JobSystem& jobSystem, uint32_t framesInFlight, const VkPhysicalDeviceLimits& limits, bool offscreen, bool updateAfterBind) : vk_logicalDevice(device), vk_pipelineCache(pipelineCache.getCache()), allocator(allocator), uploader(uploader), jobSystem(jobSystem), maxFramesInFlight(std::clamp(framesInFlight, MIN_FRAMES_IN_FLIGHT, MAX_FRAMES_IN_FLIGHT)) {
+
+//------------------------------BUILD RENDER GRAPH------------------------------
+        // The scene pass clears the backbuffer and a depth image that never leaves the pass, so the graph can keep it
+        // in lazily allocated memory. Layout transitions and dependencies come out of compile()
+        renderGraph = std::make_unique<RenderGraph>(vk_logicalDevice, allocator, deletionQueue, maxFramesInFlight);
+        // Offscreen targets are never presented, leave them ready to be copied out instead
+        backbuffer = renderGraph->importImage("backbuffer", swapChainImageFormat, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, offscreen ? VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL : VK_IMAGE_LAYOUT_PRESENT_SRC_KHR);
+        // D16 is the one depth format every device has to support as an attachment
+        RenderResource depth = renderGraph->createTransientImage("depth", VK_FORMAT_D16_UNORM);
+
+        scenePass = &renderGraph->addPass("scene")
+            .writeColor(backbuffer, VK_ATTACHMENT_LOAD_OP_CLEAR, clearColor.color)
+            .writeDepth(depth, VK_ATTACHMENT_LOAD_OP_CLEAR)
+            .setRecord([this](VkCommandBuffer commandBuffer, const RenderPassTarget& target) { recordScene(commandBuffer, target); });
+
+        renderGraph->compile();
+        vk_renderPass = scenePass->getRenderPass();
+        this->swapChainImageViews = swapChainImageViews;
+        renderGraph->resize(swapChainExtent);
+    
+//------------------------------CREATE BINDLESS TABLE------------------------------
+        // Every buffer the shaders read is registered here once, draws find them through handles in the push constants
+        bindlessTable = std::make_unique<BindlessTable>(vk_logicalDevice, limits, updateAfterBind);
+
+//------------------------------CREATE PIPELINE LAYOUT------------------------------
+        VkPipelineLayoutCreateInfo createPipelineLayoutInfo{};
+        createPipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+        createPipelineLayoutInfo.setLayoutCount = 1;
+        VkDescriptorSetLayout bindlessSetLayout = bindlessTable->getSetLayout();
+        createPipelineLayoutInfo.pSetLayouts = &bindlessSetLayout;
+        VkPushConstantRange pushConstantRange{};
+        pushConstantRange.stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
+        pushConstantRange.offset = 0;
+        pushConstantRange.size = sizeof(DrawConstants);
+
+        createPipelineLayoutInfo.pushConstantRangeCount = 1;
+        createPipelineLayoutInfo.pPushConstantRanges = &pushConstantRange;
+
+        if (vkCreatePipelineLayout(vk_logicalDevice, &createPipelineLayoutInfo, nullptr, &vk_pipelineLayout) != VK_SUCCESS) throw std::runtime_error("failed to create pipeline layout!");
+    
+//------------------------------UPLOAD GEOMETRY------------------------------
+        // Copied on the transfer queue, the first frame acquires the buffers and waits on the upload before drawing.
+        // The instance buffer follows with buildScene
+        const std::vector<Vertex> vertices = {
+            {{ 0.0f, -0.5f}, {1.0f, 0.0f, 0.0f}},
+            {{ 0.5f,  0.5f}, {0.0f, 1.0f, 0.0f}},
+            {{-0.5f,  0.5f}, {0.0f, 0.0f, 1.0f}}
+        };
+        const std::vector<uint16_t> indices = {0, 1, 2};
+
+        vertexBuffer = BufferHandle(&allocator, uploader.uploadBuffer(vertices.data(), sizeof(Vertex) * vertices.size(), VK_BUFFER_USAGE_VERTEX_BUFFER_BIT), &deletionQueue);
+        indexBuffer = BufferHandle(&allocator, uploader.uploadBuffer(indices.data(), sizeof(uint16_t) * indices.size(), VK_BUFFER_USAGE_INDEX_BUFFER_BIT), &deletionQueue);
+        indexCount = static_cast<uint32_t>(indices.size());
+        for (const auto& vertex : vertices) meshRadius = std::max(meshRadius, std::hypot(vertex.position[0], vertex.position[1]));
+        uploader.submit();
+
+//------------------------------CREATE COMMAND ALLOCATOR------------------------------
+        // Primaries come out of per-slot pools that are reset whole once the slot's fence has signaled
+        commandAllocator = std::make_unique<CommandAllocator>(device, graphicsQueueFamily, maxFramesInFlight);
+    
+//------------------------------CREATE SYNC OBJECTS------------------------------
+        VkFenceCreateInfo fenceInfo{};
+        fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+        fenceInfo.flags = VK_FENCE_CREATE_SIGNALED_BIT;
+
+        vk_inFlightFences.resize(maxFramesInFlight);
+
+        for (uint32_t i = 0; i < maxFramesInFlight; i++) {
+            imageAvailableSemaphores.push_back(createSemaphore());
+            if (vkCreateFence(device, &fenceInfo, nullptr, &vk_inFlightFences[i]) != VK_SUCCESS) throw std::runtime_error("failed to create fence!");
+        }
+        createRenderFinishedSemaphores(swapChainImageViews.size());
+
+//------------------------------CREATE GRAPHICS PIPELINE------------------------------
+        // SPIR-V is compiled, optimized and embedded at build time, see the Shaders target in CMakeLists.txt. On a cold
+        // cache the pipeline is the slowest part of startup, so it is built on the job system while the caller goes on
+        // with the scene and assets. Nothing after this point may throw, the job holds on to this
+        PipelineCache* cache = &pipelineCache;
+        jobSystem.run([this, cache]() {
+            pipelineBuildSpan.start = Clock::now();
+            graphicsPipeline = PipelineHandle(vk_logicalDevice, createGraphicsPipeline(Shaders::vertexShader_vert, Shaders::fragmentShader_frag), &deletionQueue);
+            pipelineBuildSpan.end = Clock::now();
+            cache->addCreationTime(elapsedMs(pipelineBuildSpan.start, pipelineBuildSpan.end));
+        }, &pipelineBuilt);
+    }
+
+    void Renderer::waitForPipeline() {
+        if (pipelineReady) return;
+        jobSystem.wait(pipelineBuilt);
+        pipelineReady = true;
+    }
+
+//------------------------------CREATE RENDER FINISHED SEMAPHORES FUNC------------------------------
+    void Renderer::createRenderFinishedSemaphores(size_t imageCount) {
+        for (size_t i = 0; i < imageCount; i++) renderFinishedSemaphores.push_back(createSemaphore());
+    }
+
+    SemaphoreHandle Renderer::createSemaphore() {
+        VkSemaphoreCreateInfo semaphoreInfo{};
+        semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+
+        VkSemaphore semaphore;
+        if (vkCreateSemaphore(vk_logicalDevice, &semaphoreInfo, nullptr, &semaphore) != VK_SUCCESS) throw std::runtime_error("failed to create semaphores!");
+        return SemaphoreHandle(vk_logicalDevice, semaphore, &deletionQueue);
+    }
+
+//------------------------------RECREATE SWAP CHAIN RESOURCES------------------------------
+    void Renderer::recreateSwapChainResources(VkExtent2D swapChainExtent, const std::vector<VkImageView>& swapChainImageViews, VkSwapchainKHR retiredSwapChain, std::vector<VkImageView> retiredImageViews) {
+        // Frames up to the previous one may still reference the old objects, they are retired instead of waiting for the
+        // device to go idle. The graph retires its framebuffers first, so they die before the old views
+        VkDevice device = vk_logicalDevice;
+        renderGraph->resize(swapChainExtent);
+        renderFinishedSemaphores.clear();
+        deletionQueue.retire([device, retiredImageViews = std::move(retiredImageViews), retiredSwapChain]() {
+            for (auto imageView : retiredImageViews) vkDestroyImageView(device, imageView, nullptr);
+            if (retiredSwapChain != VK_NULL_HANDLE) vkDestroySwapchainKHR(device, retiredSwapChain, nullptr);
+        });
+
+        this->swapChainImageViews = swapChainImageViews;
+        createRenderFinishedSemaphores(swapChainImageViews.size());
+    }
+
+//------------------------------CREATE DRAW FRAME FUNC------------------------------
+    bool Renderer::drawFrame(VkSwapchainKHR swapChain, VkQueue graphicsQueue, VkQueue presentQueue) {
+        // Only the slot about to be reused is waited on, so up to maxFramesInFlight frames can be queued on the GPU
+        VkSemaphore imageAvailableSemaphore = imageAvailableSemaphores[currentFrame].get();
+        VkFence inFlightFence = vk_inFlightFences[currentFrame];
+
+        PROFILE_ZONE("drawFrame");
+        auto waitStart = Clock::now();
+        waitForFrameSlot();
+        beginFrame();
+
+        auto acquireStart = Clock::now();
+        uint32_t imageIndex;
+        VkResult acquireResult;
+        {
+            PROFILE_ZONE("acquire");
+            acquireResult = vkAcquireNextImageKHR(vk_logicalDevice, swapChain, UINT64_MAX, imageAvailableSemaphore, VK_NULL_HANDLE, &imageIndex);
+        }
+
+        // Nothing was acquired, so the slot stays untouched and its fence signaled for the next attempt
+        if (acquireResult == VK_ERROR_OUT_OF_DATE_KHR) return true;
+        if (acquireResult != VK_SUCCESS && acquireResult != VK_SUBOPTIMAL_KHR) throw std::runtime_error("failed to acquire swap chain image!");
+        if (vk_timelineSemaphore == VK_NULL_HANDLE) vkResetFences(vk_logicalDevice, 1, &inFlightFence);
+
+        auto recordStart = Clock::now();
+        VkCommandBuffer commandBuffer = commandAllocator->allocate(currentFrame);
+        recordCommandBuffer(commandBuffer, imageIndex);
+
+        auto submitStart = Clock::now();
+        submitFrame(graphicsQueue, commandBuffer, imageAvailableSemaphore, renderFinishedSemaphores[imageIndex].get(), inFlightFence);
+
+        auto presentStart = Clock::now();
+
+        VkPresentInfoKHR presentInfo{};
+        presentInfo.sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
+
+        presentInfo.waitSemaphoreCount = 1;
+        presentInfo.pWaitSemaphores = &renderFinishedSemaphores[imageIndex].get();
+
+        VkSwapchainKHR swapChains[] = {swapChain};
+        presentInfo.swapchainCount = 1;
+        presentInfo.pSwapchains = swapChains;
+
+        presentInfo.pImageIndices = &imageIndex;
+
+        // Ids only have to grow per swapchain, the frame number does that across recreations too
+        const uint64_t presentId = frameNumber + 1;
+        VkPresentIdKHR presentIdInfo{};
+        presentIdInfo.sType = VK_STRUCTURE_TYPE_PRESENT_ID_KHR;
+        presentIdInfo.swapchainCount = 1;
+        presentIdInfo.pPresentIds = &presentId;
+        if (presentIdEnabled) presentInfo.pNext = &presentIdInfo;
+
+        VkResult presentResult;
+        {
+            PROFILE_ZONE("present");
+            presentResult = vkQueuePresentKHR(presentQueue, &presentInfo);
+        }
+        if (presentResult != VK_SUCCESS && presentResult != VK_SUBOPTIMAL_KHR && presentResult != VK_ERROR_OUT_OF_DATE_KHR) throw std::runtime_error("failed to present swap chain image!");
+        if (presentResult != VK_ERROR_OUT_OF_DATE_KHR) presentedFrames++;
+        auto presentEnd = Clock::now();
+
+        lastFrameTimings.waitMs = elapsedMs(waitStart, acquireStart);
+        lastFrameTimings.acquireMs = elapsedMs(acquireStart, recordStart);
+        lastFrameTimings.recordMs = elapsedMs(recordStart, submitStart);
+        lastFrameTimings.submitMs = elapsedMs(submitStart, presentStart);
+        lastFrameTimings.presentMs = elapsedMs(presentStart, presentEnd);
+        lastFrameTimings.presentId = presentIdEnabled ? presentId : 0;
+        lastFrameTimings.submitTime = submitStart;
+        lastFrameTimings.presentTime = presentEnd;
+
+        currentFrame = (currentFrame + 1) % maxFramesInFlight;
+        frameNumber++;
+
+        return acquireResult == VK_SUBOPTIMAL_KHR || presentResult != VK_SUCCESS;
+    }
+
+//------------------------------DRAW OFFSCREEN FRAME FUNC------------------------------
+    void Renderer::drawOffscreenFrame(VkQueue graphicsQueue) {
+        // There is no swapchain to acquire from, every frame slot owns the target with the same index
+        VkFence inFlightFence = vk_inFlightFences[currentFrame];
+        uint32_t imageIndex = currentFrame % static_cast<uint32_t>(swapChainImageViews.size());
+
+        PROFILE_ZONE("drawOffscreenFrame");
+        auto waitStart = Clock::now();
+        waitForFrameSlot();
+        if (vk_timelineSemaphore == VK_NULL_HANDLE) vkResetFences(vk_logicalDevice, 1, &inFlightFence);
+        beginFrame();
+
+        auto recordStart = Clock::now();
+        VkCommandBuffer commandBuffer = commandAllocator->allocate(currentFrame);
+        recordCommandBuffer(commandBuffer, imageIndex);
+
+        auto submitStart = Clock::now();
+        submitFrame(graphicsQueue, commandBuffer, VK_NULL_HANDLE, VK_NULL_HANDLE, inFlightFence);
+        auto submitEnd = Clock::now();
+
+        lastFrameTimings.waitMs = elapsedMs(waitStart, recordStart);
+        lastFrameTimings.acquireMs = 0.0;
+        lastFrameTimings.recordMs = elapsedMs(recordStart, submitStart);
+        lastFrameTimings.submitMs = elapsedMs(submitStart, submitEnd);
+        lastFrameTimings.presentMs = 0.0;
+        lastFrameTimings.presentId = 0;
+        lastFrameTimings.submitTime = submitStart;
+        lastFrameTimings.presentTime = submitEnd;
+
+        currentFrame = (currentFrame + 1) % maxFramesInFlight;
+        frameNumber++;
+        presentedFrames++;
+    }
+
+//------------------------------SUBMIT FRAME------------------------------
+    void Renderer::submitFrame(VkQueue graphicsQueue, VkCommandBuffer commandBuffer, VkSemaphore imageAvailableSemaphore, VkSemaphore renderFinishedSemaphore, VkFence inFlightFence) {
+        PROFILE_ZONE("submit");
+        std::vector<VkSemaphore> waitSemaphores;
+        std::vector<VkPipelineStageFlags> waitStages;
+
+        if (imageAvailableSemaphore != VK_NULL_HANDLE) {
+            waitSemaphores.push_back(imageAvailableSemaphore);
+            waitStages.push_back(VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT);
+        }
+
+        if (gpuCuller && vk_computeQueue != VK_NULL_HANDLE) {
+            // The cull batch goes first and takes over the upload waits. Waiting on it makes the draws wait on the uploads
+            // as well, so the acquire barriers and mip blits recorded on the graphics side stay ordered after the transfer releases
+            VkSemaphore computeFinishedSemaphore = computeFinishedSemaphores[currentFrame].get();
+            std::vector<VkPipelineStageFlags> computeWaitStages(uploadSemaphores.size(), VK_PIPELINE_STAGE_ALL_COMMANDS_BIT);
+
+            VkSubmitInfo computeSubmitInfo{};
+            computeSubmitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+            computeSubmitInfo.waitSemaphoreCount = static_cast<uint32_t>(uploadSemaphores.size());
+            computeSubmitInfo.pWaitSemaphores = uploadSemaphores.data();
+            computeSubmitInfo.pWaitDstStageMask = computeWaitStages.data();
+            computeSubmitInfo.commandBufferCount = 1;
+            computeSubmitInfo.pCommandBuffers = &vk_computeCommandBuffer;
+            computeSubmitInfo.signalSemaphoreCount = 1;
+            computeSubmitInfo.pSignalSemaphores = &computeFinishedSemaphore;
+
+            if (vkQueueSubmit(vk_computeQueue, 1, &computeSubmitInfo, VK_NULL_HANDLE) != VK_SUCCESS) throw std::runtime_error("failed to submit cull command buffer!");
+
+            waitSemaphores.push_back(computeFinishedSemaphore);
+            waitStages.push_back(VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT | Uploader::CONSUMER_STAGES);
+        } else {
+            for (auto semaphore : uploadSemaphores) {
+                waitSemaphores.push_back(semaphore);
+                waitStages.push_back(Uploader::CONSUMER_STAGES);
+            }
+        }
+
+        VkSubmitInfo submitInfo{};
+        submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+        submitInfo.waitSemaphoreCount = static_cast<uint32_t>(waitSemaphores.size());
+        submitInfo.pWaitSemaphores = waitSemaphores.data();
+        submitInfo.pWaitDstStageMask = waitStages.data();
+        submitInfo.commandBufferCount = 1;
+        submitInfo.pCommandBuffers = &commandBuffer;
+
+        std::vector<VkSemaphore> signalSemaphores;
+        std::vector<uint64_t> signalValues;
+        if (renderFinishedSemaphore != VK_NULL_HANDLE) {
+            signalSemaphores.push_back(renderFinishedSemaphore);
+            signalValues.push_back(0);
+        }
+
+        // Binary semaphores ignore their value, the timeline one moves to frame + 1 once this frame is done
+        VkTimelineSemaphoreSubmitInfo timelineInfo{};
+        timelineInfo.sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO;
+        if (vk_timelineSemaphore != VK_NULL_HANDLE) {
+            signalSemaphores.push_back(vk_timelineSemaphore);
+            signalValues.push_back(frameNumber + 1);
+            timelineInfo.signalSemaphoreValueCount = static_cast<uint32_t>(signalValues.size());
+            timelineInfo.pSignalSemaphoreValues = signalValues.data();
+            submitInfo.pNext = &timelineInfo;
+            inFlightFence = VK_NULL_HANDLE;
+        }
+
+        submitInfo.signalSemaphoreCount = static_cast<uint32_t>(signalSemaphores.size());
+        submitInfo.pSignalSemaphores = signalSemaphores.data();
+
+        if (gpuProfiler) gpuProfiler->frameSubmitted(Clock::now());
+        if (vkQueueSubmit(graphicsQueue, 1, &submitInfo, inFlightFence) != VK_SUCCESS) {
+            throw std::runtime_error("failed to submit draw command buffer!");
+        }
+
+        // Upload semaphores are single-use, destroy them once this frame has consumed the wait
+        VkDevice device = vk_logicalDevice;
+        for (auto semaphore : uploadSemaphores) {
+            deletionQueue.push(frameNumber, [device, semaphore]() { vkDestroySemaphore(device, semaphore, nullptr); });
+        }
+        uploadSemaphores.clear();
+    }
+
+//------------------------------BEGIN FRAME------------------------------
+    void Renderer::beginFrame() {
+        PROFILE_ZONE("beginFrame");
+        deletionQueue.setRecordingFrame(frameNumber);
+        // The slot's fence has been waited on, every buffer recorded into its pools is done
+        commandAllocator->reset(currentFrame);
+        if (computeCommandAllocator) computeCommandAllocator->reset(currentFrame);
+        if (commandRecorder) commandRecorder->beginFrame(currentFrame);
+        waitForPipeline();
+        readGpuTimestamps();
+        if (gpuProfiler) gpuProfiler->collect(currentFrame);
+
+        CullStats cullStats;
+        if (gpuCuller && gpuCuller->readStats(currentFrame, cullStats)) {
+            lastFrameTimings.visibleInstances = cullStats.visible;
+            lastFrameTimings.culledInstances = cullStats.culled;
+        } else {
+            lastFrameTimings.visibleInstances = lastFrameTimings.culledInstances = -1;
+        }
+
+        if (vk_timelineSemaphore != VK_NULL_HANDLE) {
+            // The counter says exactly how far the GPU got, which may be further than the slot that was waited on
+            uint64_t completedFrames = 0;
+            vk_getSemaphoreCounterValue(vk_logicalDevice, vk_timelineSemaphore, &completedFrames);
+            if (completedFrames) deletionQueue.flush(completedFrames - 1);
+        }
+        // The fence just waited on belonged to frame (frameNumber - maxFramesInFlight), so it and every earlier frame are done
+        else if (frameNumber >= maxFramesInFlight) deletionQueue.flush(frameNumber - maxFramesInFlight);
+
+        // Frame boundary: nothing is being recorded, so a rebuilt pipeline can be swapped in without waiting on the GPU.
+        // The old one retires on assignment
+        VkPipeline reloadedPipeline;
+        if (shaderHotReloader && shaderHotReloader->takePipeline(reloadedPipeline)) graphicsPipeline = PipelineHandle(vk_logicalDevice, reloadedPipeline, &deletionQueue);
+    }
+
+//------------------------------FRAME SYNC------------------------------
+    void Renderer::enableTimelineSemaphore() {
+        if (frameNumber) throw std::runtime_error("timeline semaphore has to be enabled before the first frame!");
+
+        vk_waitSemaphores = reinterpret_cast<PFN_vkWaitSemaphores>(vkGetDeviceProcAddr(vk_logicalDevice, "vkWaitSemaphores"));
+        vk_getSemaphoreCounterValue = reinterpret_cast<PFN_vkGetSemaphoreCounterValue>(vkGetDeviceProcAddr(vk_logicalDevice, "vkGetSemaphoreCounterValue"));
+        if (!vk_waitSemaphores || !vk_getSemaphoreCounterValue) throw std::runtime_error("failed to load timeline semaphore functions!");
+
+        VkSemaphoreTypeCreateInfo semaphoreTypeInfo{};
+        semaphoreTypeInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO;
+        semaphoreTypeInfo.semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE;
+        semaphoreTypeInfo.initialValue = 0;
+
+        VkSemaphoreCreateInfo semaphoreInfo{};
+        semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+        semaphoreInfo.pNext = &semaphoreTypeInfo;
+
+        if (vkCreateSemaphore(vk_logicalDevice, &semaphoreInfo, nullptr, &vk_timelineSemaphore) != VK_SUCCESS) throw std::runtime_error("failed to create timeline semaphore!");
+    }
+
+    void Renderer::waitForFrame(uint64_t frame) {
+        if (frame >= frameNumber) throw std::runtime_error("cannot wait for a frame that was never submitted!");
+
+        if (vk_timelineSemaphore != VK_NULL_HANDLE) {
+            const uint64_t value = frame + 1;
+
+            VkSemaphoreWaitInfo waitInfo{};
+            waitInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO;
+            waitInfo.semaphoreCount = 1;
+            waitInfo.pSemaphores = &vk_timelineSemaphore;
+            waitInfo.pValues = &value;
+
+            if (vk_waitSemaphores(vk_logicalDevice, &waitInfo, UINT64_MAX) != VK_SUCCESS) throw std::runtime_error("failed to wait for timeline semaphore!");
+            return;
+        }
+
+        // The slot fence belongs to the newest frame submitted in it, frames finish in order so that covers this one too
+        vkWaitForFences(vk_logicalDevice, 1, &vk_inFlightFences[frame % maxFramesInFlight], VK_TRUE, UINT64_MAX);
+    }
+
+    void Renderer::waitForFrameSlot() {
+        PROFILE_ZONE("waitForFrameSlot");
+        // Only the slot about to be reused is waited on: the frame that last used it is maxFramesInFlight frames back
+        if (vk_timelineSemaphore == VK_NULL_HANDLE) vkWaitForFences(vk_logicalDevice, 1, &vk_inFlightFences[currentFrame], VK_TRUE, UINT64_MAX);
+        else if (frameNumber >= maxFramesInFlight) waitForFrame(frameNumber - maxFramesInFlight);
+    }
+
+//------------------------------SHADER HOT RELOAD------------------------------
+    void Renderer::enableShaderHotReload(const std::string& compiler, const std::string& shaderSourceDir) {
+        shaderHotReloader = std::make_unique<ShaderHotReloader>(
+            vk_logicalDevice, compiler,
+            shaderSourceDir + "/vertexShader.vert",
+            shaderSourceDir + "/fragmentShader.frag",
+            [this](std::span<const uint32_t> vertCode, std::span<const uint32_t> fragCode) { return createGraphicsPipeline(vertCode, fragCode); }
+        );
+    }
+
+//------------------------------GPU TIMESTAMPS------------------------------
+    void Renderer::enableGpuTimestamps(float period) {
+        VkQueryPoolCreateInfo queryPoolInfo{};
+        queryPoolInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+        queryPoolInfo.queryType = VK_QUERY_TYPE_TIMESTAMP;
+        queryPoolInfo.queryCount = 2 * maxFramesInFlight;
+
+        if (vkCreateQueryPool(vk_logicalDevice, &queryPoolInfo, nullptr, &vk_timestampQueryPool) != VK_SUCCESS) throw std::runtime_error("failed to create timestamp query pool!");
+
+        timestampPeriod = period;
+        timestampsWritten.assign(maxFramesInFlight, false);
+    }
+
+    void Renderer::readGpuTimestamps() {
+        lastFrameTimings.gpuMs = -1.0;
+        if (vk_timestampQueryPool == VK_NULL_HANDLE || !timestampsWritten[currentFrame]) return;
+
+        // The slot fence has signaled, so both queries are available and no WAIT flag is needed
+        uint64_t timestamps[2];
+        if (vkGetQueryPoolResults(vk_logicalDevice, vk_timestampQueryPool, 2 * currentFrame, 2, sizeof(timestamps), timestamps, sizeof(uint64_t), VK_QUERY_RESULT_64_BIT) == VK_SUCCESS) {
+            lastFrameTimings.gpuMs = static_cast<double>(timestamps[1] - timestamps[0]) * timestampPeriod / 1e6;
+        }
+    }
+
+//------------------------------RECORD COMMAND BUFFER------------------------------
+    void Renderer::recordCommandBuffer(VkCommandBuffer commandBuffer, uint32_t imageIndex) {
+        PROFILE_ZONE("recordCommandBuffer");
+        VkCommandBufferBeginInfo beginInfo{};
+        beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+        beginInfo.flags = 0;
+        beginInfo.pInheritanceInfo = nullptr;
+        
+        if (vkBeginCommandBuffer(commandBuffer, &beginInfo) != VK_SUCCESS) throw std::runtime_error("failed to begin recording command buffer!");
+
+        // Zones sit between render passes, secondary command buffers leave no room for timestamps inside the scene pass
+        uint32_t frameZone = GpuProfiler::NO_ZONE;
+        uint32_t zone = GpuProfiler::NO_ZONE;
+        if (gpuProfiler) {
+            gpuProfiler->beginFrame(commandBuffer, currentFrame);
+            frameZone = gpuProfiler->beginZone(commandBuffer, "frame");
+            zone = gpuProfiler->beginZone(commandBuffer, "uploadAcquire");
+        }
+
+        uploader.recordAcquire(commandBuffer, uploadSemaphores);
+        if (gpuProfiler) gpuProfiler->endZone(commandBuffer, zone);
+
+        if (gpuCuller && vk_computeQueue != VK_NULL_HANDLE) recordComputeCommandBuffer();
+        else if (gpuCuller) {
+            if (gpuProfiler) zone = gpuProfiler->beginZone(commandBuffer, "culling");
+            gpuCuller->record(commandBuffer, currentFrame, getFrustumPlanes());
+            if (gpuProfiler) gpuProfiler->endZone(commandBuffer, zone);
+        }
+
+        // gpuMs brackets the render graph alone, so inline and async culling report the same span. Culling itself is
+        // the GPU profiler's "culling" zone
+        if (vk_timestampQueryPool != VK_NULL_HANDLE) {
+            vkCmdResetQueryPool(commandBuffer, vk_timestampQueryPool, 2 * currentFrame, 2);
+            vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, vk_timestampQueryPool, 2 * currentFrame);
+        }
+
+        if (gpuProfiler) zone = gpuProfiler->beginZone(commandBuffer, "scene");
+        renderGraph->setImportedView(backbuffer, swapChainImageViews[imageIndex]);
+        renderGraph->execute(commandBuffer, currentFrame);
+        if (gpuProfiler) gpuProfiler->endZone(commandBuffer, zone);
+
+        if (vk_timestampQueryPool != VK_NULL_HANDLE) {
+            vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, vk_timestampQueryPool, 2 * currentFrame + 1);
+            timestampsWritten[currentFrame] = true;
+        }
+        if (gpuProfiler) gpuProfiler->endZone(commandBuffer, frameZone);
+
+        if (vkEndCommandBuffer(commandBuffer) != VK_SUCCESS) throw std::runtime_error("failed to record command buffer!");
+    }
+
+//------------------------------RECORD SCENE------------------------------
+    // Runs inside the scene pass the render graph has begun
+    void Renderer::recordScene(VkCommandBuffer commandBuffer, const RenderPassTarget& target) {
+        if (!commandRecorder) {
+            recordDraws(commandBuffer, target.extent, 0, static_cast<uint32_t>(drawList.size()));
+            return;
+        }
+
+        VkCommandBufferInheritanceInfo inheritanceInfo{};
+        inheritanceInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO;
+        inheritanceInfo.renderPass = target.renderPass;
+        inheritanceInfo.subpass = 0;
+        inheritanceInfo.framebuffer = target.framebuffer;
+
+        const VkExtent2D extent = target.extent;
+        const auto& secondaryBuffers = commandRecorder->record(currentFrame, inheritanceInfo, static_cast<uint32_t>(drawList.size()),
+            [this, extent](VkCommandBuffer secondary, uint32_t firstItem, uint32_t lastItem) { recordDraws(secondary, extent, firstItem, lastItem); });
+
+        if (!secondaryBuffers.empty()) vkCmdExecuteCommands(commandBuffer, static_cast<uint32_t>(secondaryBuffers.size()), secondaryBuffers.data());
+    }
+
+//------------------------------RECORD COMPUTE COMMAND BUFFER------------------------------
+    void Renderer::recordComputeCommandBuffer() {
+        // The graphics submission of this slot waited on the previous cull batch, so its fence covers the compute pools too
+        VkCommandBuffer commandBuffer = vk_computeCommandBuffer = computeCommandAllocator->allocate(currentFrame);
+
+        VkCommandBufferBeginInfo beginInfo{};
+        beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+        beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+
+        if (vkBeginCommandBuffer(commandBuffer, &beginInfo) != VK_SUCCESS) throw std::runtime_error("failed to begin recording cull command buffer!");
+        gpuCuller->record(commandBuffer, currentFrame, getFrustumPlanes());
+        if (vkEndCommandBuffer(commandBuffer) != VK_SUCCESS) throw std::runtime_error("failed to record cull command buffer!");
+    }
+
+//------------------------------FRUSTUM------------------------------
+    FrustumPlanes Renderer::getFrustumPlanes() const {
+        // Clip space spans [-1, 1], so the camera sees 1 / zoom world units to each side of its position
+        const float halfExtent = 1.0f / camera.zoom;
+        const float x = camera.position[0];
+        const float y = camera.position[1];
+
+        return {{
+            {{ 1.0f,  0.0f, 0.0f, -(x - halfExtent)}},
+            {{-1.0f,  0.0f, 0.0f,   x + halfExtent }},
+            {{ 0.0f,  1.0f, 0.0f, -(y - halfExtent)}},
+            {{ 0.0f, -1.0f, 0.0f,   y + halfExtent }}
+        }};
+    }
+
+//------------------------------RECORD DRAWS------------------------------
+    // Called on worker threads in parallel mode, so it may only read renderer state
+    void Renderer::recordDraws(VkCommandBuffer commandBuffer, VkExtent2D extent, uint32_t firstItem, uint32_t lastItem) {
+        if (firstItem == lastItem) return;
+        PROFILE_ZONE("recordDraws");
+
+        vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, graphicsPipeline.get());
+
+        VkViewport viewport{};
+        viewport.x = 0.0f;
+        viewport.y = 0.0f;
+        viewport.width = static_cast<float>(extent.width);
+        viewport.height = static_cast<float>(extent.height);
+        viewport.minDepth = 0.0f;
+        viewport.maxDepth = 1.0f;
+        vkCmdSetViewport(commandBuffer, 0, 1, &viewport);
+
+        VkRect2D scissor{};
+        scissor.offset = {0, 0};
+        scissor.extent = extent;
+        vkCmdSetScissor(commandBuffer, 0, 1, &scissor);
+
+        VkDeviceSize vertexOffset = 0;
+        vkCmdBindVertexBuffers(commandBuffer, 0, 1, &vertexBuffer.get().buffer, &vertexOffset);
+        vkCmdBindIndexBuffer(commandBuffer, indexBuffer.get().buffer, 0, VK_INDEX_TYPE_UINT16);
+        bindlessTable->bind(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, vk_pipelineLayout);
+
+        DrawConstants constants;
+        constants.camera = camera;
+        constants.instanceBuffer = instanceHandle;
+        constants.drawnInstanceBuffer = drawnInstanceHandles[currentFrame % drawnInstanceHandles.size()];
+        vkCmdPushConstants(commandBuffer, vk_pipelineLayout, VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(DrawConstants), &constants);
+
+        // The culling pass wrote the visible count into the draw command, the CPU never sees it before drawing
+        if (gpuCuller) {
+            vkCmdDrawIndexedIndirect(commandBuffer, gpuCuller->getIndirectBuffer(currentFrame), 0, 1, sizeof(VkDrawIndexedIndirectCommand));
+            return;
+        }
+
+        // gl_InstanceIndex starts at firstInstance, so every draw reads its own range of the instance buffer
+        for (uint32_t i = firstItem; i < lastItem; i++) {
+            vkCmdDrawIndexed(commandBuffer, indexCount, drawList[i].instanceCount, 0, 0, drawList[i].firstInstance);
+        }
+    }
+
+//------------------------------BUILD SCENE------------------------------
+    void Renderer::buildScene(uint32_t instanceCount, uint32_t drawCount, bool gpuCulling) {
+        // Every draw covers at least one instance, so a large drawCount alone still yields that many draws
+        drawCount = std::max(1u, drawCount);
+        instanceCount = std::max(instanceCount, drawCount);
+
+        // The culler and the buffers the handles point at are replaced below, which is only allowed once no frame is using them
+        if (instanceBuffer) {
+            vkDeviceWaitIdle(vk_logicalDevice);
+            bindlessTable->release(BindlessKind::StorageBuffer, instanceHandle);
+            for (uint32_t handle : drawnInstanceHandles) bindlessTable->release(BindlessKind::StorageBuffer, handle);
+            drawnInstanceHandles.clear();
+            gpuCuller.reset();
+            instanceBuffer.reset();
+            identityBuffer.reset();
+        }
+
+        // Lays the instances out on a square grid covering the whole target
+        const uint32_t columns = static_cast<uint32_t>(std::ceil(std::sqrt(static_cast<double>(instanceCount))));
+        const float cellSize = 2.0f / static_cast<float>(columns);
+
+        // Filled in parallel, stress scenes run into hundreds of thousands of instances
+        std::vector<InstanceData> instances(instanceCount);
+        JobCounter layoutDone;
+        jobSystem.parallelFor(instanceCount, 4096, [&instances, columns, cellSize](uint32_t first, uint32_t last) {
+            for (uint32_t i = first; i < last; i++) {
+                InstanceData& instance = instances[i];
+                instance.offset[0] = -1.0f + (static_cast<float>(i % columns) + 0.5f) * cellSize;
+                instance.offset[1] = -1.0f + (static_cast<float>(i / columns) + 0.5f) * cellSize;
+                instance.scale = 0.9f * cellSize;
+                instance.rotation = static_cast<float>(i % 360) * 3.14159265f / 180.0f;
+
+                // Cheap integer hash so neighbouring instances get visibly different tints
+                uint32_t hash = i * 2654435761u;
+                instance.color[0] = 0.5f + 0.5f * static_cast<float>((hash >> 8) & 0xFF) / 255.0f;
+                instance.color[1] = 0.5f + 0.5f * static_cast<float>((hash >> 16) & 0xFF) / 255.0f;
+                instance.color[2] = 0.5f + 0.5f * static_cast<float>((hash >> 24) & 0xFF) / 255.0f;
+                instance.color[3] = 1.0f;
+            }
+        }, layoutDone);
+        jobSystem.wait(layoutDone);
+
+        // A lone instance keeps the original full-screen, untinted triangle
+        if (instanceCount == 1) instances[0] = {{0.0f, 0.0f}, 1.0f, 0.0f, {1.0f, 1.0f, 1.0f, 1.0f}};
+
+        // An async cull reads the instances on the compute queue while the vertex shader reads them on the graphics queue
+        std::vector<uint32_t> instanceSharing;
+        if (gpuCulling && vk_computeQueue != VK_NULL_HANDLE) instanceSharing = computeSharingFamilies;
+        instanceBuffer = BufferHandle(&allocator, uploader.uploadBuffer(instances.data(), sizeof(InstanceData) * instances.size(), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, instanceSharing), &deletionQueue);
+
+        if (gpuCulling) {
+            gpuCuller = std::make_unique<GpuCuller>(vk_logicalDevice, allocator, vk_pipelineCache, maxFramesInFlight, instanceBuffer.get().buffer, instanceCount, indexCount, meshRadius, instanceSharing);
+            drawCount = 1;
+        } else {
+            // Without culling every instance is drawn through an identity index list, so one vertex shader serves both paths
+            std::vector<uint32_t> identity(instanceCount);
+            for (uint32_t i = 0; i < instanceCount; i++) identity[i] = i;
+            identityBuffer = BufferHandle(&allocator, uploader.uploadBuffer(identity.data(), sizeof(uint32_t) * identity.size(), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT), &deletionQueue);
+        }
+        uploader.submit();
+
+        // The culling output is per frame slot, without culling every slot shares the identity list
+        instanceHandle = bindlessTable->registerBuffer(instanceBuffer.get().buffer);
+        if (gpuCuller) {
+            for (uint32_t slot = 0; slot < maxFramesInFlight; slot++) drawnInstanceHandles.push_back(bindlessTable->registerBuffer(gpuCuller->getVisibleBuffer(slot)));
+        } else drawnInstanceHandles.assign(1, bindlessTable->registerBuffer(identityBuffer.get().buffer));
+
+        // More draws than one only exist to give the parallel recorder something to split
+        drawList.resize(drawCount);
+        for (uint32_t i = 0; i < drawCount; i++) {
+            drawList[i].firstInstance = static_cast<uint32_t>(uint64_t(instanceCount) * i / drawCount);
+            drawList[i].instanceCount = static_cast<uint32_t>(uint64_t(instanceCount) * (i + 1) / drawCount) - drawList[i].firstInstance;
+        }
+        this->instanceCount = instanceCount;
+    }
+
+//------------------------------ASYNC COMPUTE------------------------------
+    bool Renderer::enableAsyncCompute(VkQueue computeQueue, uint32_t computeFamily, uint32_t graphicsFamily) {
+        if (computeFamily == graphicsFamily || vk_computeQueue != VK_NULL_HANDLE) return vk_computeQueue != VK_NULL_HANDLE;
+
+        computeCommandAllocator = std::make_unique<CommandAllocator>(vk_logicalDevice, computeFamily, maxFramesInFlight);
+
+        for (uint32_t i = 0; i < maxFramesInFlight; i++) computeFinishedSemaphores.push_back(createSemaphore());
+
+        vk_computeQueue = computeQueue;
+        computeSharingFamilies = {graphicsFamily, computeFamily};
+        return true;
+    }
+
+//------------------------------RECORD THREADS------------------------------
+    void Renderer::setRecordThreads(uint32_t queueFamilyIndex, uint32_t threadCount) {
+        // The slice pools may still own buffers of frames in flight
+        vkDeviceWaitIdle(vk_logicalDevice);
+
+        commandRecorder.reset();
+        if (threadCount) commandRecorder = std::make_unique<CommandRecorder>(vk_logicalDevice, jobSystem, queueFamilyIndex, maxFramesInFlight, threadCount);
+        scenePass->setSecondaryContents(threadCount != 0);
+    }
+
+//------------------------------CREATE GRAPHICS PIPELINE FUNC------------------------------
+    // Only reads state that is immutable after construction, so the hot-reload thread can call it too
+    VkPipeline Renderer::createGraphicsPipeline(std::span<const uint32_t> vertCode, std::span<const uint32_t> fragCode) {
+        VkShaderModule vertShaderModule = createShaderModule(vertCode, vk_logicalDevice);
+        VkShaderModule fragShaderModule = createShaderModule(fragCode, vk_logicalDevice);
 
         VkPipelineShaderStageCreateInfo  vertShaderStageInfo{};
         vertShaderStageInfo.sType  = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
         vertShaderStageInfo.stage = VK_SHADER_STAGE_VERTEX_BIT;
-        vertShaderStageInfo.module = vk_vertShaderModule;
+        vertShaderStageInfo.module = vertShaderModule;
         vertShaderStageInfo.pName  = "main";
 
         VkPipelineShaderStageCreateInfo  fragShaderStageInfo{};
         fragShaderStageInfo.sType  = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
         fragShaderStageInfo.stage = VK_SHADER_STAGE_FRAGMENT_BIT;
-        fragShaderStageInfo.module = vk_fragShaderModule;
+        fragShaderStageInfo.module = fragShaderModule;
         fragShaderStageInfo.pName  = "main";
         VkPipelineShaderStageCreateInfo vk_shaderStages[] =  {vertShaderStageInfo, fragShaderStageInfo};
 
-//------------------------------CREATE RENDER PASS------------------------------
-        VkAttachmentDescription colorAttachment{};
-        colorAttachment.format = swapChainImageFormat;
-        colorAttachment.samples = VK_SAMPLE_COUNT_1_BIT;
-        colorAttachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
-        colorAttachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
-        colorAttachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
-        colorAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
-        colorAttachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-        colorAttachment.finalLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
-
-        VkAttachmentReference colorAttachmentRef{};
-        colorAttachmentRef.attachment = 0;
-        colorAttachmentRef.layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
-
-        VkSubpassDescription subpass{};
-        subpass.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
-        subpass.colorAttachmentCount = 1;
-        subpass.pColorAttachments = &colorAttachmentRef;
-  
-        VkSubpassDependency dependency{};
-        dependency.srcSubpass = VK_SUBPASS_EXTERNAL;
-        dependency.dstSubpass = 0;
-        dependency.srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
-        dependency.srcAccessMask = 0;
-        dependency.dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
-        dependency.dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
-
-        VkRenderPassCreateInfo renderPassInfo{};
-        renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
-        renderPassInfo.attachmentCount = 1;
-        renderPassInfo.pAttachments = &colorAttachment;
-        renderPassInfo.subpassCount = 1;
-        renderPassInfo.pSubpasses = &subpass;
-        renderPassInfo.dependencyCount = 1;
-        renderPassInfo.pDependencies = &dependency;
-
-        if (vkCreateRenderPass(vk_logicalDevice, &renderPassInfo, nullptr, &vk_renderPass) != VK_SUCCESS) throw std::runtime_error("failed to create render pass!");
-    
-//------------------------------CREATE PIPELINE LAYOUT------------------------------
+        auto bindingDescription = Vertex::getBindingDescription();
+        auto attributeDescriptions = Vertex::getAttributeDescriptions();
+
         VkPipelineVertexInputStateCreateInfo vertexInputInfo{};
         vertexInputInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
-        vertexInputInfo.vertexBindingDescriptionCount = 0;
-        vertexInputInfo.pVertexBindingDescriptions = nullptr;
-        vertexInputInfo.vertexAttributeDescriptionCount = 0;
-        vertexInputInfo.pVertexAttributeDescriptions = nullptr;
+        vertexInputInfo.vertexBindingDescriptionCount = 1;
+        vertexInputInfo.pVertexBindingDescriptions = &bindingDescription;
+        vertexInputInfo.vertexAttributeDescriptionCount = static_cast<uint32_t>(attributeDescriptions.size());
+        vertexInputInfo.pVertexAttributeDescriptions = attributeDescriptions.data();
 
         VkPipelineInputAssemblyStateCreateInfo inputAssembly{};
         inputAssembly.sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
@@ -121,16 +765,15 @@ namespace Graphics {
         colorBlending.blendConstants[2] = 0.0f;
         colorBlending.blendConstants[3] = 0.0f;
 
-        VkPipelineLayoutCreateInfo createPipelineLayoutInfo{};
-        createPipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
-        createPipelineLayoutInfo.setLayoutCount = 0;
-        createPipelineLayoutInfo.pSetLayouts = nullptr;
-        createPipelineLayoutInfo.pushConstantRangeCount = 0;
-        createPipelineLayoutInfo.pPushConstantRanges = nullptr;
+        // Instances earlier in the draw order sit closer, so overlaps resolve the same whatever order culling emitted them in
+        VkPipelineDepthStencilStateCreateInfo depthStencil{};
+        depthStencil.sType = VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO;
+        depthStencil.depthTestEnable = VK_TRUE;
+        depthStencil.depthWriteEnable = VK_TRUE;
+        depthStencil.depthCompareOp = VK_COMPARE_OP_LESS_OR_EQUAL;
+        depthStencil.depthBoundsTestEnable = VK_FALSE;
+        depthStencil.stencilTestEnable = VK_FALSE;
 
-        if (vkCreatePipelineLayout(vk_logicalDevice, &createPipelineLayoutInfo, nullptr, &vk_pipelineLayout) != VK_SUCCESS) throw std::runtime_error("failed to create pipeline layout!");
-    
-//------------------------------CREATE GRAPHICS PIPELINE------------------------------
         VkGraphicsPipelineCreateInfo  pipelineInfo{};
         pipelineInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
         pipelineInfo.stageCount = 2;
@@ -140,7 +783,7 @@ namespace Graphics {
         pipelineInfo.pViewportState = &viewportState;
         pipelineInfo.pRasterizationState = &rasterizer;
         pipelineInfo.pMultisampleState = &multisampling;
-        pipelineInfo.pDepthStencilState = nullptr;
+        pipelineInfo.pDepthStencilState = &depthStencil;
         pipelineInfo.pColorBlendState = &colorBlending;
         pipelineInfo.pDynamicState = &dynamicState;
         pipelineInfo.layout = vk_pipelineLayout;
@@ -149,190 +792,66 @@ namespace Graphics {
         pipelineInfo.basePipelineHandle = VK_NULL_HANDLE;
         pipelineInfo.basePipelineIndex = -1;
 
-        if (vkCreateGraphicsPipelines(vk_logicalDevice, VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &vk_graphicsPipeline) != VK_SUCCESS) throw std::runtime_error("failed to create graphics pipeline!");
-
-//------------------------------CREATE FRAMEBUFFERS------------------------------
-        vk_swapChainFramebuffers.resize(swapChainImageViews.size());
-
-        for (size_t i = 0; i < swapChainImageViews.size(); i++) {
-            VkImageView attachments[] = {
-                swapChainImageViews[i]
-            };
-        
-            VkFramebufferCreateInfo framebufferInfo{};
-            framebufferInfo.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
-            framebufferInfo.renderPass = vk_renderPass;
-            framebufferInfo.attachmentCount = 1;
-            framebufferInfo.pAttachments = &swapChainImageViews[i];
-            framebufferInfo.width = swapChainExtent.width;
-            framebufferInfo.height = swapChainExtent.height;
-            framebufferInfo.layers = 1;
-
-            if (vkCreateFramebuffer(vk_logicalDevice, &framebufferInfo, nullptr, &vk_swapChainFramebuffers[i]) != VK_SUCCESS) throw std::runtime_error("failed to create framebuffer!");
-        }
-
-//------------------------------ALLOCATE COMMAND BUFFER------------------------------
-        VkCommandBufferAllocateInfo allocInfo{};
-        allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
-        allocInfo.commandPool = commandPool;
-        allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
-        allocInfo.commandBufferCount = 1;
-
-        if (vkAllocateCommandBuffers(device, &allocInfo, &vk_commandBuffer) != VK_SUCCESS) throw std::runtime_error("failed to allocate command buffers!");
-    
-//------------------------------CREATE SYNC OBJECTS------------------------------
-        VkSemaphoreCreateInfo semaphoreInfo{};
-        semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
-
-        VkFenceCreateInfo fenceInfo{};
-        fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
-        fenceInfo.flags = VK_FENCE_CREATE_SIGNALED_BIT;
-
-        vk_renderFinishedSemaphores.resize(swapChainImageViews.size());
-
-        if (vkCreateSemaphore(device, &semaphoreInfo, nullptr, &vk_imageAvailableSemaphore) != VK_SUCCESS) throw std::runtime_error("failed to create semaphores!");
-        for (size_t i = 0; i < swapChainImageViews.size(); i++) {
-            if (vkCreateSemaphore(device, &semaphoreInfo, nullptr, &vk_renderFinishedSemaphores[i]) != VK_SUCCESS) throw std::runtime_error("failed to create semaphores!");
-        }
-        if (vkCreateFence(device, &fenceInfo, nullptr, &vk_inFlightFence) != VK_SUCCESS) throw std::runtime_error("failed to create fence!");
-    }
-
-//------------------------------CREATE DRAW FRAME FUNC------------------------------
-    void Renderer::drawFrame(VkSwapchainKHR swapChain, VkExtent2D swapChainExtent, VkQueue graphicsQueue, VkQueue presentQueue) {
-        vkWaitForFences(vk_logicalDevice, 1, &vk_inFlightFence, VK_TRUE, UINT64_MAX);
-        vkResetFences(vk_logicalDevice, 1, &vk_inFlightFence);
-
-        uint32_t imageIndex;
-        vkAcquireNextImageKHR(vk_logicalDevice, swapChain, UINT64_MAX, vk_imageAvailableSemaphore, VK_NULL_HANDLE, &imageIndex);
-
-        vkResetCommandBuffer(vk_commandBuffer, 0);
-        recordCommandBuffer(vk_commandBuffer, imageIndex, swapChainExtent);
-
-        VkSubmitInfo submitInfo{};
-        submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
-
-        VkSemaphore waitSemaphores[] = {vk_imageAvailableSemaphore};
-        VkPipelineStageFlags waitStages[] = {VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT};
-        submitInfo.waitSemaphoreCount = 1;
-        submitInfo.pWaitSemaphores = waitSemaphores;
-        submitInfo.pWaitDstStageMask = waitStages;
+        VkPipeline pipeline;
+        VkResult result = vkCreateGraphicsPipelines(vk_logicalDevice, vk_pipelineCache, 1, &pipelineInfo, nullptr, &pipeline);
 
-        submitInfo.commandBufferCount = 1;
-        submitInfo.pCommandBuffers = &vk_commandBuffer;
-
-        VkSemaphore signalSemaphores[] = {vk_renderFinishedSemaphores[imageIndex]};
-        submitInfo.signalSemaphoreCount = 1;
-        submitInfo.pSignalSemaphores = signalSemaphores;
-
-        assert(vk_renderFinishedSemaphores[imageIndex] != VK_NULL_HANDLE);
-        if (vkQueueSubmit(graphicsQueue, 1, &submitInfo, vk_inFlightFence) != VK_SUCCESS) {
-            throw std::runtime_error("failed to submit draw command buffer!");
-        }
-
-        VkPresentInfoKHR presentInfo{};
-        presentInfo.sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
-
-        presentInfo.waitSemaphoreCount = 1;
-        presentInfo.pWaitSemaphores = &signalSemaphores[0];
-
-        VkSwapchainKHR swapChains[] = {swapChain};
-        presentInfo.swapchainCount = 1;
-        presentInfo.pSwapchains = swapChains;
-
-        presentInfo.pImageIndices = &imageIndex;
+        // Modules are only needed while the pipeline is being built
+        vkDestroyShaderModule(vk_logicalDevice, fragShaderModule, nullptr);
+        vkDestroyShaderModule(vk_logicalDevice, vertShaderModule, nullptr);
 
-        vkQueuePresentKHR(presentQueue, &presentInfo);
+        if (result != VK_SUCCESS) throw std::runtime_error("failed to create graphics pipeline!");
+        return pipeline;
     }
 
-//------------------------------RECORD COMMAND BUFFER------------------------------
-    void Renderer::recordCommandBuffer(VkCommandBuffer commandBuffer, uint32_t imageIndex, VkExtent2D swapChainExtent) {
-        VkCommandBufferBeginInfo beginInfo{};
-        beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
-        beginInfo.flags = 0;
-        beginInfo.pInheritanceInfo = nullptr;
-        
-        if (vkBeginCommandBuffer(commandBuffer, &beginInfo) != VK_SUCCESS) throw std::runtime_error("failed to begin recording command buffer!");
-
-        VkRenderPassBeginInfo renderPassInfo{};
-        renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
-        renderPassInfo.renderPass = vk_renderPass;
-        renderPassInfo.framebuffer = vk_swapChainFramebuffers[imageIndex];
-        renderPassInfo.renderArea.offset = {0, 0};
-        renderPassInfo.renderArea.extent = swapChainExtent;
-        renderPassInfo.clearValueCount = 1;
-        renderPassInfo.pClearValues = &clearColor;
-
-        vkCmdBeginRenderPass(commandBuffer, &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
-        vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, vk_graphicsPipeline);
-
-        VkViewport viewport{};
-        viewport.x = 0.0f;
-        viewport.y = 0.0f;
-        viewport.width = static_cast<float>(swapChainExtent.width);
-        viewport.height = static_cast<float>(swapChainExtent.height);
-        viewport.minDepth = 0.0f;
-        viewport.maxDepth = 1.0f;
-        vkCmdSetViewport(commandBuffer, 0, 1, &viewport);
-
-        VkRect2D scissor{};
-        scissor.offset = {0, 0};
-        scissor.extent = swapChainExtent;
-        vkCmdSetScissor(commandBuffer, 0, 1, &scissor);
-
-        vkCmdDraw(commandBuffer, 3, 1, 0, 0);
-        vkCmdEndRenderPass(commandBuffer);
-
-        if (vkEndCommandBuffer(commandBuffer) != VK_SUCCESS) throw std::runtime_error("failed to record command buffer!");
-    }
 
 //------------------------------CREATE SHADER MODULE FUNC------------------------------
-    VkShaderModule Renderer::createShaderModule(const std::vector<char>& code, VkDevice device, VkExtent2D swapChainExtent) {
+    VkShaderModule Renderer::createShaderModule(std::span<const uint32_t> code, VkDevice device) {
         VkShaderModule shaderModule;
 
         VkShaderModuleCreateInfo shaderModuleInfo{};
         shaderModuleInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
-        shaderModuleInfo.codeSize = code.size();
-        shaderModuleInfo.pCode = reinterpret_cast<const uint32_t*>(code.data());
+        shaderModuleInfo.codeSize = code.size_bytes();
+        shaderModuleInfo.pCode = code.data();
         
         if (vkCreateShaderModule(device, &shaderModuleInfo, nullptr, &shaderModule) != VK_SUCCESS) throw std::runtime_error("faile to create shader module!");
         return shaderModule;
     }
 
-    std::vector<char> Renderer::readShaderFile(const std::string& filename) {
-        std::ifstream file(filename, std::ios::ate | std::ios::binary);
-
-        if (!file.is_open()) {
-            throw std::runtime_error("Failed to open shader file: " + filename);
-        }
-
-        size_t fileSize = static_cast<size_t>(file.tellg());
-        std::vector<char> buffer(fileSize);
-
-        file.seekg(0);
-        file.read(buffer.data(), fileSize);
-
-        file.close();
-        return buffer;
-    }
-
 //------------------------------DESTROY------------------------------
     Renderer::~Renderer() {
-
-        if (vk_fragShaderModule != VK_NULL_HANDLE) vkDestroyShaderModule(vk_logicalDevice, vk_fragShaderModule, nullptr);
-        if (vk_vertShaderModule != VK_NULL_HANDLE) vkDestroyShaderModule(vk_logicalDevice, vk_vertShaderModule, nullptr);
+        // A failed build was already reported by whoever waited first, only the job itself has to be out of the way
+        try {
+            waitForPipeline();
+        } catch (const std::exception&) {}
+
+        // Stop the watcher first, it may be building a pipeline against the layout and render pass below
+        shaderHotReloader.reset();
+        commandRecorder.reset();
+        commandAllocator.reset();
+        computeCommandAllocator.reset();
+
+        // The device is idle by now: every handle retires into the queue, which is flushed right after
+        vertexBuffer.reset();
+        indexBuffer.reset();
+        gpuCuller.reset();
+        instanceBuffer.reset();
+        identityBuffer.reset();
+        graphicsPipeline.reset();
+        imageAvailableSemaphores.clear();
+        renderFinishedSemaphores.clear();
+        computeFinishedSemaphores.clear();
 
         vkDestroyPipelineLayout(vk_logicalDevice, vk_pipelineLayout, nullptr);
-        vkDestroyRenderPass(vk_logicalDevice, vk_renderPass, nullptr);
-        vkDestroyPipeline(vk_logicalDevice, vk_graphicsPipeline, nullptr);
-
-        for (auto framebuffer : vk_swapChainFramebuffers)
-            vkDestroyFramebuffer(vk_logicalDevice, framebuffer, nullptr);
+        bindlessTable.reset();
+        // Owns the render pass the pipeline was built against
+        renderGraph.reset();
+        deletionQueue.flushAll();
 
-        vkDestroySemaphore(vk_logicalDevice, vk_imageAvailableSemaphore, nullptr);
+        for (auto fence : vk_inFlightFences)
+            if (fence != VK_NULL_HANDLE) vkDestroyFence(vk_logicalDevice, fence, nullptr);
 
-        for (auto sem : vk_renderFinishedSemaphores)
-            if (sem != VK_NULL_HANDLE) vkDestroySemaphore(vk_logicalDevice, sem, nullptr);
+        if (vk_timelineSemaphore != VK_NULL_HANDLE) vkDestroySemaphore(vk_logicalDevice, vk_timelineSemaphore, nullptr);
 
-        vkDestroyFence(vk_logicalDevice, vk_inFlightFence, nullptr);
+        if (vk_timestampQueryPool != VK_NULL_HANDLE) vkDestroyQueryPool(vk_logicalDevice, vk_timestampQueryPool, nullptr);
     }
 }
\ No newline at end of file
@@ -1,41 +1,212 @@
 #pragma once
 
 #include "../includes/graphics.hpp"
-#include <fstream>
+#include "pipelineCache.hpp"
+#include "deletionQueue.hpp"
+#include "vulkanHandle.hpp"
+#include "shaderHotReload.hpp"
+#include "allocator.hpp"
+#include "uploader.hpp"
+#include "vertex.hpp"
+#include "commandAllocator.hpp"
+#include "commandRecorder.hpp"
+#include "gpuCulling.hpp"
+#include "renderGraph.hpp"
+#include "bindlessTable.hpp"
+#include "jobSystem.hpp"
+#include "startupTrace.hpp"
+#include "gpuProfiler.hpp"
 #include <cassert>
 #include <iostream>
 #include <vector>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <span>
+#include <memory>
+#include <atomic>
 
 namespace Graphics {
 
+    // CPU phases of the last drawFrame call. gpuMs belongs to the frame that previously used the same
+    // frame slot because its timestamps can only be read back once that slot's fence has signaled
+    struct FrameTimings {
+        double waitMs = 0.0;
+        double acquireMs = 0.0;
+        double recordMs = 0.0;
+        double submitMs = 0.0;
+        double presentMs = 0.0;
+        double gpuMs = -1.0;
+        // GPU culling results of that same earlier frame, -1 while culling is off or not read back yet
+        int64_t visibleInstances = -1;
+        int64_t culledInstances = -1;
+        // Present id the frame was tagged with, 0 for offscreen frames or without present ids. The time points are when
+        // the frame went to the graphics queue and when vkQueuePresentKHR returned, for the latency tracking
+        uint64_t presentId = 0;
+        std::chrono::steady_clock::time_point submitTime;
+        std::chrono::steady_clock::time_point presentTime;
+    };
+
+    // Maps world space to clip space as (position - camera.position) * camera.zoom, pushed to the vertex shader
+    struct Camera2D {
+        float position[2] = {0.0f, 0.0f};
+        float zoom = 1.0f;
+        float padding = 0.0f;
+    };
+
+    // Push constants of vertexShader.vert: the camera plus the bindless handles of the buffers the draw reads
+    struct DrawConstants {
+        Camera2D camera;
+        uint32_t instanceBuffer = 0;
+        uint32_t drawnInstanceBuffer = 0;
+    };
+
+    // Per-instance data read by vertexShader.vert from the instance SSBO, laid out for std430
+    struct InstanceData {
+        float offset[2];
+        float scale;
+        float rotation;
+        float color[4];
+    };
+
+    // One instanced draw of the shared mesh over a contiguous range of the instance buffer
+    struct DrawItem {
+        uint32_t firstInstance;
+        uint32_t instanceCount;
+    };
+
     class Renderer {
 
         public:
-            Renderer(VkDevice device, VkExtent2D swapChainExtent, VkFormat swapChainImageFormat, std::vector<VkImageView> swapChainImageViews, VkCommandPool commandPool);
+            static constexpr uint32_t MIN_FRAMES_IN_FLIGHT = 2;
+            static constexpr uint32_t MAX_FRAMES_IN_FLIGHT = 4;
+
+            Renderer(VkDevice device, VkExtent2D swapChainExtent, VkFormat swapChainImageFormat, std::vector<VkImageView> swapChainImageViews, uint32_t graphicsQueueFamily, PipelineCache& pipelineCache, Allocator& allocator, Uploader& uploader, JobSystem& jobSystem, uint32_t framesInFlight, const VkPhysicalDeviceLimits& limits, bool offscreen = false, bool updateAfterBind = false);
             ~Renderer();
-            void drawFrame(VkSwapchainKHR swapChain, VkExtent2D swapChainExtent, VkQueue graphicsQueue, VkQueue presentQueue);
+            // Returns true when acquire or present reported the swapchain as out of date or suboptimal
+            bool drawFrame(VkSwapchainKHR swapChain, VkQueue graphicsQueue, VkQueue presentQueue);
+            // Swaps in the views of a recreated swapchain, the retired handles are destroyed once in-flight frames finish
+            void recreateSwapChainResources(VkExtent2D swapChainExtent, const std::vector<VkImageView>& swapChainImageViews, VkSwapchainKHR retiredSwapChain, std::vector<VkImageView> retiredImageViews);
+            void drawOffscreenFrame(VkQueue graphicsQueue);
+            void enableGpuTimestamps(float timestampPeriod);
+            // Wraps the graphics queue work of every frame in GPU zones. Async culling runs on its own queue and isn't covered
+            inline void setGpuProfiler(GpuProfiler* profiler) { gpuProfiler = profiler; }
+            void enableShaderHotReload(const std::string& compiler, const std::string& shaderSourceDir);
+            // 0 threads records inline on the calling thread, otherwise the draw list is cut into that many slices recorded
+            // as jobs. Changing it waits for the device to go idle
+            void setRecordThreads(uint32_t queueFamilyIndex, uint32_t threadCount);
+            // Instances are laid out on a grid and split evenly over drawCount draws, waits for the device if a scene exists.
+            // With gpuCulling a compute pass picks the visible instances every frame and they are drawn with one indirect draw
+            void buildScene(uint32_t instanceCount, uint32_t drawCount = 1, bool gpuCulling = false);
+            // Moves the culling pass onto its own compute queue so it overlaps the raster work of earlier frames, the
+            // draws wait on it through a semaphore. Has to be called before buildScene, returns false and keeps culling on
+            // the graphics queue when both families are the same
+            bool enableAsyncCompute(VkQueue computeQueue, uint32_t computeFamily, uint32_t graphicsFamily);
+            inline bool getAsyncCompute() const { return vk_computeQueue != VK_NULL_HANDLE; }
+            // Tracks frame completion with one timeline semaphore that the last submission of every frame signals with
+            // frame + 1, replacing the per-slot fence wait and reset. Needs a device with timeline semaphores enabled and
+            // has to be called before the first frame
+            void enableTimelineSemaphore();
+            inline bool getTimelineSemaphore() const { return vk_timelineSemaphore != VK_NULL_HANDLE; }
+            // Tags every present with frame + 1 through VK_KHR_present_id, the device needs the extension enabled
+            inline void enablePresentId() { presentIdEnabled = true; }
+            // Blocks until frame (numbered from 0 in submission order) has finished on the GPU. With the timeline
+            // semaphore any thread may wait, the fence path is limited to the thread that draws
+            void waitForFrame(uint64_t frame);
+            inline uint64_t getFrameNumber() const { return frameNumber; }
+            // Frames the presentation engine accepted, offscreen every submitted frame counts
+            inline uint64_t getPresentedFrames() const { return presentedFrames; }
+            inline uint32_t getFramesInFlight() const { return maxFramesInFlight; }
+            // When the graphics pipeline was built on the job system, waits for it first
+            inline const TraceSpan& getPipelineBuildSpan() { waitForPipeline(); return pipelineBuildSpan; }
+            inline void setCamera(const Camera2D& newCamera) { camera = newCamera; }
+            inline const FrameTimings& getLastFrameTimings() const { return lastFrameTimings; }
+            inline uint32_t getInstanceCount() const { return instanceCount; }
+            inline const RenderGraphStats& getRenderGraphStats() const { return renderGraph->getStats(); }
+            inline BindlessStats getBindlessStats() const { return bindlessTable->getStats(); }
+            // Handle shaders sample the image with. Without update-after-bind only while no frame is in flight
+            inline uint32_t registerTexture(VkImageView view) { return bindlessTable->registerImage(view); }
 
         private:
             VkDevice vk_logicalDevice;
-            VkPipeline vk_graphicsPipeline;
+            VkPipelineCache vk_pipelineCache;
+            // Declared ahead of every handle that retires into it, so it is still there when they are destroyed
+            DeletionQueue deletionQueue;
+            PipelineHandle graphicsPipeline;
+            // The constructor leaves the graphics pipeline building on the job system, the first frame waits for it
+            JobCounter pipelineBuilt;
+            bool pipelineReady = false;
+            TraceSpan pipelineBuildSpan;
+            // Owned by the render graph, kept for the pipeline and the hot-reload thread
             VkRenderPass vk_renderPass;
             VkPipelineLayout vk_pipelineLayout;
-            VkShaderModule vk_vertShaderModule;
-            VkShaderModule vk_fragShaderModule;
-            VkCommandBuffer vk_commandBuffer;
-            VkSemaphore vk_imageAvailableSemaphore;
-            VkSemaphore vk_renderFinishedSemaphore;
-            VkFence vk_inFlightFence;
-            std::vector<VkSemaphore> vk_renderFinishedSemaphores;
-            std::vector<VkFramebuffer> vk_swapChainFramebuffers;
+            std::unique_ptr<BindlessTable> bindlessTable;
+            uint32_t instanceHandle = 0;
+            // One per frame slot with GPU culling, a single shared identity list otherwise
+            std::vector<uint32_t> drawnInstanceHandles;
+            Allocator& allocator;
+            Uploader& uploader;
+            JobSystem& jobSystem;
+            BufferHandle vertexBuffer;
+            BufferHandle indexBuffer;
+            uint32_t indexCount = 0;
+            BufferHandle instanceBuffer;
+            BufferHandle identityBuffer;
+            uint32_t instanceCount = 0;
+            float meshRadius = 0.0f;
+            Camera2D camera;
+            std::unique_ptr<GpuCuller> gpuCuller;
+            VkQueue vk_computeQueue = VK_NULL_HANDLE;
+            std::unique_ptr<CommandAllocator> computeCommandAllocator;
+            // Allocated while recording the current frame, submitted by submitFrame
+            VkCommandBuffer vk_computeCommandBuffer = VK_NULL_HANDLE;
+            std::vector<SemaphoreHandle> computeFinishedSemaphores;
+            std::vector<uint32_t> computeSharingFamilies;
+            std::vector<VkSemaphore> uploadSemaphores;
+            std::vector<DrawItem> drawList;
+            std::unique_ptr<CommandRecorder> commandRecorder;
+            uint32_t maxFramesInFlight;
+            uint32_t currentFrame = 0;
+            std::atomic<uint64_t> frameNumber = 0;
+            uint64_t presentedFrames = 0;
+            bool presentIdEnabled = false;
+            std::unique_ptr<ShaderHotReloader> shaderHotReloader;
+            std::unique_ptr<CommandAllocator> commandAllocator;
+            std::vector<SemaphoreHandle> imageAvailableSemaphores;
+            std::vector<VkFence> vk_inFlightFences;
+            VkSemaphore vk_timelineSemaphore = VK_NULL_HANDLE;
+            PFN_vkWaitSemaphores vk_waitSemaphores = nullptr;
+            PFN_vkGetSemaphoreCounterValue vk_getSemaphoreCounterValue = nullptr;
+            VkQueryPool vk_timestampQueryPool = VK_NULL_HANDLE;
+            std::vector<bool> timestampsWritten;
+            float timestampPeriod = 0.0f;
+            GpuProfiler* gpuProfiler = nullptr;
+            FrameTimings lastFrameTimings;
+            std::vector<SemaphoreHandle> renderFinishedSemaphores;
+            std::unique_ptr<RenderGraph> renderGraph;
+            RenderResource backbuffer = 0;
+            RenderGraphPass* scenePass = nullptr;
+            std::vector<VkImageView> swapChainImageViews;
             std::vector<VkDynamicState> vk_dynamicStates = {
                 VK_DYNAMIC_STATE_VIEWPORT,
                 VK_DYNAMIC_STATE_SCISSOR
             };
             VkClearValue clearColor = {{{0.0f, 0.0f, 0.0f, 1.0f}}};
-            std::vector<char> readShaderFile(const std::string& filename);
 
-            void recordCommandBuffer(VkCommandBuffer commandBuffer, uint32_t imageIndex, VkExtent2D swapChainExtent);
-            VkShaderModule createShaderModule(const std::vector<char>& code, VkDevice device, VkExtent2D swapChainExtent);
+            void createRenderFinishedSemaphores(size_t imageCount);
+            void recordCommandBuffer(VkCommandBuffer commandBuffer, uint32_t imageIndex);
+            void recordScene(VkCommandBuffer commandBuffer, const RenderPassTarget& target);
+            void recordComputeCommandBuffer();
+            FrustumPlanes getFrustumPlanes() const;
+            void recordDraws(VkCommandBuffer commandBuffer, VkExtent2D extent, uint32_t firstItem, uint32_t lastItem);
+            void submitFrame(VkQueue graphicsQueue, VkCommandBuffer commandBuffer, VkSemaphore imageAvailableSemaphore, VkSemaphore renderFinishedSemaphore, VkFence inFlightFence);
+            void readGpuTimestamps();
+            void waitForFrameSlot();
+            void beginFrame();
+            void waitForPipeline();
+            VkPipeline createGraphicsPipeline(std::span<const uint32_t> vertCode, std::span<const uint32_t> fragCode);
+            VkShaderModule createShaderModule(std::span<const uint32_t> code, VkDevice device);
+            // Retired through the deletion queue like every other handle of the renderer
+            SemaphoreHandle createSemaphore();
     };
 }
\ No newline at end of file
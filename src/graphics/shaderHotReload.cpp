@@ -0,0 +1,105 @@
+#include "shaderHotReload.hpp"
+#include "profiler.hpp"
+namespace Graphics {
+
+    ShaderHotReloader::ShaderHotReloader(VkDevice device, const std::string& compiler, const std::string& vertSource, const std::string& fragSource, PipelineBuilder builder)
+        : vk_logicalDevice(device), compiler(compiler), builder(std::move(builder)) {
+        vertShader.source = vertSource;
+        fragShader.source = fragSource;
+
+        // The embedded SPIR-V already matches the sources as they are now, only later edits trigger a rebuild
+        hasChanged(vertShader);
+        hasChanged(fragShader);
+
+        watcher = std::thread(&ShaderHotReloader::watch, this);
+    }
+
+//------------------------------WATCH------------------------------
+    void ShaderHotReloader::watch() {
+        PROFILE_THREAD("shader watcher");
+        std::unique_lock<std::mutex> lock(mutex);
+
+        while (!stopSignal.wait_for(lock, std::chrono::milliseconds(250), [this] { return stopRequested; })) {
+            lock.unlock();
+
+            bool vertChanged = hasChanged(vertShader);
+            bool fragChanged = hasChanged(fragShader);
+
+            if (vertChanged || fragChanged) {
+                std::vector<uint32_t> vertCode, fragCode;
+                VkPipeline pipeline = VK_NULL_HANDLE;
+
+                if (compile(vertShader.source, vertCode) && compile(fragShader.source, fragCode)) {
+                    try {
+                        pipeline = builder(vertCode, fragCode);
+                        std::cout << "Shader hot-reload: rebuilt pipeline\n";
+                    } catch (const std::exception& e) {
+                        std::cerr << "Shader hot-reload: " << e.what() << "\n";
+                    }
+                }
+
+                if (pipeline != VK_NULL_HANDLE) {
+                    std::lock_guard<std::mutex> pendingLock(mutex);
+                    // A newer build supersedes one the render thread hasn't picked up yet, which was never used
+                    if (vk_pendingPipeline != VK_NULL_HANDLE) vkDestroyPipeline(vk_logicalDevice, vk_pendingPipeline, nullptr);
+                    vk_pendingPipeline = pipeline;
+                }
+            }
+
+            lock.lock();
+        }
+    }
+
+//------------------------------HAS CHANGED------------------------------
+    bool ShaderHotReloader::hasChanged(WatchedShader& shader) {
+        std::error_code error;
+        auto lastWrite = std::filesystem::last_write_time(shader.source, error);
+        if (error || lastWrite == shader.lastWrite) return false;
+
+        shader.lastWrite = lastWrite;
+        return true;
+    }
+
+//------------------------------COMPILE------------------------------
+    bool ShaderHotReloader::compile(const std::filesystem::path& source, std::vector<uint32_t>& code) {
+        std::filesystem::path output = std::filesystem::temp_directory_path() / (source.filename().string() + ".hotreload.spv");
+        std::string command = "\"" + compiler + "\" \"" + source.string() + "\" -o \"" + output.string() + "\"";
+
+        if (std::system(command.c_str()) != 0) {
+            std::cerr << "Shader hot-reload: failed to compile " << source.string() << ", keeping the current pipeline\n";
+            return false;
+        }
+
+        std::ifstream file(output, std::ios::ate | std::ios::binary);
+        if (!file.is_open()) return false;
+
+        size_t fileSize = static_cast<size_t>(file.tellg());
+        code.resize(fileSize / sizeof(uint32_t));
+        file.seekg(0);
+        file.read(reinterpret_cast<char*>(code.data()), code.size() * sizeof(uint32_t));
+        return !code.empty();
+    }
+
+//------------------------------TAKE PIPELINE------------------------------
+    bool ShaderHotReloader::takePipeline(VkPipeline& pipeline) {
+        // Called every frame by the render thread, skip the check rather than wait if the watcher holds the lock
+        std::unique_lock<std::mutex> lock(mutex, std::try_to_lock);
+        if (!lock.owns_lock() || vk_pendingPipeline == VK_NULL_HANDLE) return false;
+
+        pipeline = vk_pendingPipeline;
+        vk_pendingPipeline = VK_NULL_HANDLE;
+        return true;
+    }
+
+//------------------------------DESTROY------------------------------
+    ShaderHotReloader::~ShaderHotReloader() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopRequested = true;
+        }
+        stopSignal.notify_all();
+        if (watcher.joinable()) watcher.join();
+
+        if (vk_pendingPipeline != VK_NULL_HANDLE) vkDestroyPipeline(vk_logicalDevice, vk_pendingPipeline, nullptr);
+    }
+}
@@ -0,0 +1,53 @@
+#pragma once
+
+#include "../includes/graphics.hpp"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <mutex>
+#include <span>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace Graphics {
+
+    // Watches the vertex/fragment sources of a pipeline on a background thread. Changed sources are compiled with
+    // glslc and handed to the pipeline builder on that same thread; the render thread only ever picks up the result
+    class ShaderHotReloader {
+
+        public:
+            using PipelineBuilder = std::function<VkPipeline(std::span<const uint32_t> vertCode, std::span<const uint32_t> fragCode)>;
+
+            ShaderHotReloader(VkDevice device, const std::string& compiler, const std::string& vertSource, const std::string& fragSource, PipelineBuilder builder);
+            ~ShaderHotReloader();
+            bool takePipeline(VkPipeline& pipeline);
+
+        private:
+            struct WatchedShader {
+                std::filesystem::path source;
+                std::filesystem::file_time_type lastWrite;
+            };
+
+            VkDevice vk_logicalDevice;
+            std::string compiler;
+            WatchedShader vertShader;
+            WatchedShader fragShader;
+            PipelineBuilder builder;
+
+            std::thread watcher;
+            std::mutex mutex;
+            std::condition_variable stopSignal;
+            bool stopRequested = false;
+            VkPipeline vk_pendingPipeline = VK_NULL_HANDLE;
+
+            void watch();
+            bool hasChanged(WatchedShader& shader);
+            bool compile(const std::filesystem::path& source, std::vector<uint32_t>& code);
+    };
+}
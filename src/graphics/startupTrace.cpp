@@ -0,0 +1,55 @@
+#include "startupTrace.hpp"
+#include <algorithm>
+
+namespace Graphics {
+
+    static double elapsedMs(std::chrono::steady_clock::time_point start, std::chrono::steady_clock::time_point end) {
+        return std::chrono::duration<double, std::milli>(end - start).count();
+    }
+
+//------------------------------RECORD------------------------------
+    void StartupTrace::record(const std::string& name, Clock::time_point start) {
+        record(name, {start, Clock::now()});
+    }
+
+    void StartupTrace::record(const std::string& name, const TraceSpan& span, bool worker) {
+        std::lock_guard<std::mutex> lock(mutex);
+        phases.push_back({name, span, worker});
+    }
+
+//------------------------------REPORT------------------------------
+    nlohmann::json StartupTrace::buildReport() const {
+        std::vector<Phase> sorted;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            sorted = phases;
+        }
+        std::stable_sort(sorted.begin(), sorted.end(), [](const Phase& a, const Phase& b) { return a.span.start < b.span.start; });
+
+        nlohmann::json report;
+        report["phases"] = nlohmann::json::array();
+        Clock::time_point end = origin;
+        for (const auto& phase : sorted) {
+            report["phases"].push_back({
+                {"name", phase.name},
+                {"startMs", elapsedMs(origin, phase.span.start)},
+                {"durationMs", elapsedMs(phase.span.start, phase.span.end)},
+                {"thread", phase.worker ? "worker" : "main"}
+            });
+            end = std::max(end, phase.span.end);
+        }
+        report["totalMs"] = elapsedMs(origin, end);
+        return report;
+    }
+
+    void StartupTrace::writeReport(const std::string& filename, const nlohmann::json& context) const {
+        nlohmann::json report = context;
+        report.update(buildReport());
+
+        std::ofstream file(filename);
+        if (!file.is_open()) throw std::runtime_error("failed to open startup trace: " + filename);
+        file << report.dump(4) << "\n";
+
+        std::cout << "Startup: first frame after " << report["totalMs"].get<double>() << " ms -> " << filename << "\n";
+    }
+}
\ No newline at end of file
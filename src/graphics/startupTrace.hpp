@@ -0,0 +1,46 @@
+#pragma once
+
+#include <nlohmann/json.hpp>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace Graphics {
+
+    struct TraceSpan {
+        std::chrono::steady_clock::time_point start;
+        std::chrono::steady_clock::time_point end;
+    };
+
+    // Phases of a launch up to the first presented frame, as offsets from when the trace was created. Phases may nest
+    // or overlap each other on worker threads, the report lists them in the order they started
+    class StartupTrace {
+
+        public:
+            using Clock = std::chrono::steady_clock;
+
+            StartupTrace() : origin(Clock::now()) {}
+
+            // A phase of the calling thread that started at start and ends now
+            void record(const std::string& name, Clock::time_point start);
+            // Thread safe, worker marks phases that ran on the job system
+            void record(const std::string& name, const TraceSpan& span, bool worker = false);
+            nlohmann::json buildReport() const;
+            void writeReport(const std::string& filename, const nlohmann::json& context) const;
+
+        private:
+            struct Phase {
+                std::string name;
+                TraceSpan span;
+                bool worker;
+            };
+
+            Clock::time_point origin;
+            mutable std::mutex mutex;
+            std::vector<Phase> phases;
+    };
+}
\ No newline at end of file
@@ -0,0 +1,210 @@
+#include "texture.hpp"
+#include "profiler.hpp"
+#include <algorithm>
+#include <bit>
+#include <cstring>
+
+namespace Graphics {
+
+    namespace {
+        constexpr uint8_t KTX2_IDENTIFIER[12] = {0xAB, 'K', 'T', 'X', ' ', '2', '0', 0xBB, '\r', '\n', 0x1A, '\n'};
+        constexpr size_t KTX2_HEADER_SIZE = 80;
+        constexpr size_t KTX2_LEVEL_SIZE = 24;
+
+        struct FormatBlock {
+            uint32_t width;
+            uint32_t height;
+            uint32_t bytes;
+        };
+
+        template<typename T>
+        T readValue(std::span<const std::byte> data, size_t offset) {
+            T value;
+            std::memcpy(&value, data.data() + offset, sizeof(T));
+            return value;
+        }
+
+        // Formats the loader knows the texel block of, everything else is rejected when parsing
+        bool formatBlock(VkFormat format, FormatBlock& block) {
+            switch (format) {
+                case VK_FORMAT_BC1_RGB_UNORM_BLOCK:
+                case VK_FORMAT_BC1_RGB_SRGB_BLOCK:
+                case VK_FORMAT_BC1_RGBA_UNORM_BLOCK:
+                case VK_FORMAT_BC1_RGBA_SRGB_BLOCK:
+                case VK_FORMAT_BC4_UNORM_BLOCK:
+                case VK_FORMAT_BC4_SNORM_BLOCK:
+                    block = {4, 4, 8};
+                    return true;
+                case VK_FORMAT_BC2_UNORM_BLOCK:
+                case VK_FORMAT_BC2_SRGB_BLOCK:
+                case VK_FORMAT_BC3_UNORM_BLOCK:
+                case VK_FORMAT_BC3_SRGB_BLOCK:
+                case VK_FORMAT_BC5_UNORM_BLOCK:
+                case VK_FORMAT_BC5_SNORM_BLOCK:
+                case VK_FORMAT_BC6H_UFLOAT_BLOCK:
+                case VK_FORMAT_BC6H_SFLOAT_BLOCK:
+                case VK_FORMAT_BC7_UNORM_BLOCK:
+                case VK_FORMAT_BC7_SRGB_BLOCK:
+                    block = {4, 4, 16};
+                    return true;
+                case VK_FORMAT_R8_UNORM:
+                case VK_FORMAT_R8_SNORM:
+                    block = {1, 1, 1};
+                    return true;
+                case VK_FORMAT_R8G8_UNORM:
+                case VK_FORMAT_R8G8_SNORM:
+                    block = {1, 1, 2};
+                    return true;
+                case VK_FORMAT_R8G8B8A8_UNORM:
+                case VK_FORMAT_R8G8B8A8_SRGB:
+                case VK_FORMAT_B8G8R8A8_UNORM:
+                case VK_FORMAT_B8G8R8A8_SRGB:
+                    block = {1, 1, 4};
+                    return true;
+                case VK_FORMAT_R16G16B16A16_SFLOAT:
+                    block = {1, 1, 8};
+                    return true;
+                case VK_FORMAT_R32G32B32A32_SFLOAT:
+                    block = {1, 1, 16};
+                    return true;
+                default:
+                    return false;
+            }
+        }
+
+        uint64_t levelBytes(const FormatBlock& block, VkExtent2D extent, uint32_t level) {
+            const uint64_t width = std::max(1u, extent.width >> level);
+            const uint64_t height = std::max(1u, extent.height >> level);
+            return (width + block.width - 1) / block.width * ((height + block.height - 1) / block.height) * block.bytes;
+        }
+    }
+
+//------------------------------PARSE KTX2------------------------------
+    KtxImage parseKtx2(std::span<const std::byte> file) {
+        if (file.size() < KTX2_HEADER_SIZE || std::memcmp(file.data(), KTX2_IDENTIFIER, sizeof(KTX2_IDENTIFIER)) != 0) throw std::runtime_error("file is not a ktx2 texture!");
+
+        KtxImage image;
+        image.format = static_cast<VkFormat>(readValue<uint32_t>(file, 12));
+        image.extent = {readValue<uint32_t>(file, 20), readValue<uint32_t>(file, 24)};
+        const uint32_t depth = readValue<uint32_t>(file, 28);
+        const uint32_t layerCount = readValue<uint32_t>(file, 32);
+        const uint32_t faceCount = readValue<uint32_t>(file, 36);
+        const uint32_t levelCount = std::max(1u, readValue<uint32_t>(file, 40));
+        const uint32_t supercompression = readValue<uint32_t>(file, 44);
+
+        // Format 0 is Basis Universal, which needs a transcoder this loader doesn't have
+        FormatBlock block;
+        if (image.format == VK_FORMAT_UNDEFINED || supercompression != 0) throw std::runtime_error("supercompressed ktx2 textures are not supported!");
+        if (!formatBlock(image.format, block)) throw std::runtime_error("unsupported ktx2 texture format!");
+        if (!image.extent.width || !image.extent.height || depth > 1 || layerCount > 1 || faceCount != 1) throw std::runtime_error("only 2D ktx2 textures are supported!");
+        if (levelCount > 32 || KTX2_HEADER_SIZE + levelCount * KTX2_LEVEL_SIZE > file.size()) throw std::runtime_error("ktx2 level index is out of bounds!");
+
+        for (uint32_t level = 0; level < levelCount; level++) {
+            const uint64_t offset = readValue<uint64_t>(file, KTX2_HEADER_SIZE + level * KTX2_LEVEL_SIZE);
+            const uint64_t size = readValue<uint64_t>(file, KTX2_HEADER_SIZE + level * KTX2_LEVEL_SIZE + 8);
+            if (offset > file.size() || size > file.size() - offset) throw std::runtime_error("ktx2 level is out of bounds!");
+            if (size < levelBytes(block, image.extent, level)) throw std::runtime_error("ktx2 level is smaller than its extent!");
+            image.levels.push_back(file.subspan(offset, size));
+        }
+        return image;
+    }
+
+//------------------------------LOADER------------------------------
+    TextureLoader::TextureLoader(VkPhysicalDevice physicalDevice, VkDevice device, Allocator& allocator, Uploader& uploader, JobSystem& jobSystem, bool textureCompressionBC) : vk_physicalDevice(physicalDevice), vk_logicalDevice(device), allocator(allocator), uploader(uploader), jobSystem(jobSystem), textureCompressionBC(textureCompressionBC) {}
+
+    bool TextureLoader::supports(VkFormat format, VkFormatFeatureFlags features) const {
+        VkFormatProperties properties;
+        vkGetPhysicalDeviceFormatProperties(vk_physicalDevice, format, &properties);
+        return (properties.optimalTilingFeatures & features) == features;
+    }
+
+//------------------------------LOAD------------------------------
+    uint32_t TextureLoader::load(std::span<const std::byte> ktx2) {
+        PROFILE_ZONE("loadTexture");
+        const KtxImage ktx = parseKtx2(ktx2);
+
+        FormatBlock block;
+        formatBlock(ktx.format, block);
+        const bool blockCompressed = block.width > 1;
+
+        ImageUpload upload;
+        upload.format = ktx.format;
+        upload.extent = ktx.extent;
+        upload.levels = ktx.levels;
+
+        // Decoded levels have to outlive uploadImage, which copies them into staging
+        std::vector<std::vector<std::byte>> decodedLevels;
+        if (!supports(ktx.format, VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT) || (blockCompressed && !textureCompressionBC)) {
+            const VkFormat decodedFormat = blockDecodedFormat(ktx.format);
+            if (decodedFormat == VK_FORMAT_UNDEFINED || !supports(decodedFormat, VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT)) throw std::runtime_error("texture format is not supported by the device!");
+
+            const uint32_t texelBytes = blockDecodedTexelBytes(ktx.format);
+            decodedLevels.resize(ktx.levels.size());
+
+            JobCounter decoded;
+            for (uint32_t level = 0; level < ktx.levels.size(); level++) {
+                const uint32_t width = std::max(1u, ktx.extent.width >> level);
+                const uint32_t height = std::max(1u, ktx.extent.height >> level);
+                decodedLevels[level].resize(static_cast<size_t>(width) * height * texelBytes);
+
+                jobSystem.parallelFor((height + 3) / 4, DECODE_GRAIN, [&ktx, &decodedLevels, level, width, height](uint32_t first, uint32_t last) {
+                    decodeBlockRows(ktx.format, width, height, ktx.levels[level].data(), decodedLevels[level].data(), first, last);
+                }, decoded);
+            }
+            jobSystem.wait(decoded);
+
+            upload.format = decodedFormat;
+            for (uint32_t level = 0; level < decodedLevels.size(); level++) upload.levels[level] = decodedLevels[level];
+            block = {1, 1, texelBytes};
+            stats.decoded++;
+        }
+        upload.blockWidth = block.width;
+        upload.blockHeight = block.height;
+        upload.blockBytes = block.bytes;
+
+        // Blitting needs an uncompressed format, which also covers everything that was just decoded
+        const uint32_t fullChain = static_cast<uint32_t>(std::bit_width(std::max(ktx.extent.width, ktx.extent.height)));
+        const VkFormatFeatureFlags blitFeatures = VK_FORMAT_FEATURE_BLIT_SRC_BIT | VK_FORMAT_FEATURE_BLIT_DST_BIT | VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT;
+        upload.mipLevels = static_cast<uint32_t>(upload.levels.size());
+        if (upload.levels.size() == 1 && fullChain > 1 && supports(upload.format, blitFeatures)) {
+            upload.mipLevels = fullChain;
+            stats.generatedMips++;
+        }
+
+        Texture texture;
+        texture.image = uploader.uploadImage(upload);
+        texture.format = upload.format;
+        texture.extent = upload.extent;
+        texture.mipLevels = upload.mipLevels;
+
+        VkImageViewCreateInfo viewInfo{};
+        viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+        viewInfo.image = texture.image.image;
+        viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+        viewInfo.format = texture.format;
+        viewInfo.subresourceRange = {VK_IMAGE_ASPECT_COLOR_BIT, 0, texture.mipLevels, 0, 1};
+
+        if (vkCreateImageView(vk_logicalDevice, &viewInfo, nullptr, &texture.view) != VK_SUCCESS) {
+            allocator.destroyImage(texture.image);
+            throw std::runtime_error("failed to create texture image view!");
+        }
+
+        stats.textures++;
+        if (blockCompressed && decodedLevels.empty()) stats.compressed++;
+        for (uint32_t level = 0; level < texture.mipLevels; level++) {
+            stats.imageBytes += levelBytes(block, texture.extent, level);
+            stats.rgba8Bytes += levelBytes({1, 1, 4}, texture.extent, level);
+        }
+
+        textures.push_back(texture);
+        return static_cast<uint32_t>(textures.size() - 1);
+    }
+
+//------------------------------DESTROY------------------------------
+    TextureLoader::~TextureLoader() {
+        for (auto& texture : textures) {
+            vkDestroyImageView(vk_logicalDevice, texture.view, nullptr);
+            allocator.destroyImage(texture.image);
+        }
+    }
+}
\ No newline at end of file
@@ -0,0 +1,81 @@
+#pragma once
+
+#include "../includes/graphics.hpp"
+#include "allocator.hpp"
+#include "uploader.hpp"
+#include "jobSystem.hpp"
+#include "blockDecoder.hpp"
+#include <cstddef>
+#include <span>
+#include <stdexcept>
+#include <vector>
+
+namespace Graphics {
+
+    // Level data of a 2D KTX2 file, pointing into the file it was parsed from. A file with a single level (or a level
+    // count of 0, which KTX2 uses to ask for generated mips) has no chain of its own
+    struct KtxImage {
+        VkFormat format = VK_FORMAT_UNDEFINED;
+        VkExtent2D extent{};
+        std::vector<std::span<const std::byte>> levels;
+    };
+
+    // Only plain 2D textures: one layer, one face, no supercompression
+    KtxImage parseKtx2(std::span<const std::byte> file);
+
+    struct Texture {
+        ImageAllocation image;
+        VkImageView view = VK_NULL_HANDLE;
+        VkFormat format = VK_FORMAT_UNDEFINED;
+        VkExtent2D extent{};
+        uint32_t mipLevels = 1;
+    };
+
+    struct TextureStats {
+        uint32_t textures = 0;
+        // Uploaded block-compressed, as opposed to decoded on the CPU for a GPU without the format
+        uint32_t compressed = 0;
+        uint32_t decoded = 0;
+        uint32_t generatedMips = 0;
+        uint64_t imageBytes = 0;
+        // What the same images would take as uncompressed RGBA8
+        uint64_t rgba8Bytes = 0;
+    };
+
+    // Turns KTX2 files into sampled images. Formats the GPU samples are uploaded as they are, block-compressed ones it
+    // lacks are decoded to the nearest uncompressed format on the job system first. A file without a mip chain gets
+    // one generated by the uploader, provided the format can be blitted with linear filtering; block-compressed images
+    // can't be blit destinations, so they keep the levels of the file
+    class TextureLoader {
+
+        public:
+            // textureCompressionBC tells whether the device was created with the feature, the format queries alone
+            // don't say so
+            TextureLoader(VkPhysicalDevice physicalDevice, VkDevice device, Allocator& allocator, Uploader& uploader, JobSystem& jobSystem, bool textureCompressionBC);
+            // Images may still be read by submitted frames, the device has to be idle
+            ~TextureLoader();
+            TextureLoader(const TextureLoader&) = delete;
+            TextureLoader& operator=(const TextureLoader&) = delete;
+
+            // The returned index stays valid for the lifetime of the loader, the image is usable once the uploader's
+            // batch is submitted and picked up by recordAcquire
+            uint32_t load(std::span<const std::byte> ktx2);
+            inline const Texture& getTexture(uint32_t index) const { return textures[index]; }
+            inline const TextureStats& getStats() const { return stats; }
+
+        private:
+            // Block rows a decode job handles
+            static constexpr uint32_t DECODE_GRAIN = 16;
+
+            VkPhysicalDevice vk_physicalDevice;
+            VkDevice vk_logicalDevice;
+            Allocator& allocator;
+            Uploader& uploader;
+            JobSystem& jobSystem;
+            bool textureCompressionBC;
+            std::vector<Texture> textures;
+            TextureStats stats;
+
+            bool supports(VkFormat format, VkFormatFeatureFlags features) const;
+    };
+}
\ No newline at end of file
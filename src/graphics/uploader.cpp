@@ -0,0 +1,433 @@
+#include "uploader.hpp"
+#include "profiler.hpp"
+namespace Graphics {
+
+    static VkAccessFlags consumerAccessFor(VkBufferUsageFlags usage) {
+        VkAccessFlags access = 0;
+        if (usage & VK_BUFFER_USAGE_VERTEX_BUFFER_BIT) access |= VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT;
+        if (usage & VK_BUFFER_USAGE_INDEX_BUFFER_BIT) access |= VK_ACCESS_INDEX_READ_BIT;
+        if (usage & VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT) access |= VK_ACCESS_INDIRECT_COMMAND_READ_BIT;
+        if (usage & VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT) access |= VK_ACCESS_UNIFORM_READ_BIT;
+        if (usage & VK_BUFFER_USAGE_STORAGE_BUFFER_BIT) access |= VK_ACCESS_SHADER_READ_BIT;
+        return access;
+    }
+
+    Uploader::Uploader(VkDevice device, Allocator& allocator, VkQueue transferQueue, uint32_t transferFamily, uint32_t graphicsFamily, VkDeviceSize stagingSize) : vk_logicalDevice(device), allocator(allocator), vk_transferQueue(transferQueue), transferFamily(transferFamily), graphicsFamily(graphicsFamily), stagingSize(stagingSize) {
+
+//------------------------------CREATE COMMAND POOL------------------------------
+        VkCommandPoolCreateInfo poolInfo{};
+        poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+        poolInfo.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT | VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+        poolInfo.queueFamilyIndex = transferFamily;
+
+        if (vkCreateCommandPool(vk_logicalDevice, &poolInfo, nullptr, &vk_commandPool) != VK_SUCCESS) throw std::runtime_error("failed to create transfer command pool!");
+
+//------------------------------CREATE STAGING RING------------------------------
+        VkBufferCreateInfo bufferInfo{};
+        bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+        bufferInfo.size = stagingSize;
+        bufferInfo.usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
+        bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+        stagingBuffer = allocator.createBuffer(bufferInfo, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+    }
+
+//------------------------------UPLOAD BUFFER------------------------------
+    BufferAllocation Uploader::uploadBuffer(const void* data, VkDeviceSize size, VkBufferUsageFlags usage, const std::vector<uint32_t>& sharedFamilies) {
+        bool concurrent;
+        BufferAllocation buffer = createDestination(size, usage, sharedFamilies, concurrent);
+
+        // Data larger than the ring is copied in pieces, each piece may push the previous batch onto the queue
+        const char* source = static_cast<const char*>(data);
+        VkDeviceSize copied = 0;
+        while (copied < size) {
+            VkDeviceSize chunk = std::min(size - copied, stagingSize);
+            VkDeviceSize consumed;
+            VkDeviceSize stagingOffset = reserveStaging(chunk, consumed);
+
+            std::memcpy(static_cast<char*>(stagingBuffer.allocation.mapped) + stagingOffset, source + copied, chunk);
+            recordCopy(buffer, stagingOffset, copied, chunk, consumed);
+            copied += chunk;
+        }
+
+        releaseOwnership(buffer, usage, concurrent);
+        return buffer;
+    }
+
+//------------------------------UPLOAD IMAGE------------------------------
+    ImageAllocation Uploader::uploadImage(const ImageUpload& upload) {
+        const uint32_t uploadedLevels = static_cast<uint32_t>(upload.levels.size());
+        if (!uploadedLevels || uploadedLevels > upload.mipLevels) throw std::runtime_error("image upload needs between one and mipLevels levels!");
+        const bool generateChain = uploadedLevels < upload.mipLevels;
+
+        VkImageCreateInfo imageInfo{};
+        imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+        imageInfo.imageType = VK_IMAGE_TYPE_2D;
+        imageInfo.format = upload.format;
+        imageInfo.extent = {upload.extent.width, upload.extent.height, 1};
+        imageInfo.mipLevels = upload.mipLevels;
+        imageInfo.arrayLayers = 1;
+        imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+        imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+        imageInfo.usage = VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT | (generateChain ? VK_IMAGE_USAGE_TRANSFER_SRC_BIT : 0);
+        imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+        imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+
+        ImageAllocation image = allocator.createImage(imageInfo, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+
+        VkImageMemoryBarrier barrier{};
+        barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+        barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        barrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+        barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+        barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.image = image.image;
+        barrier.subresourceRange = {VK_IMAGE_ASPECT_COLOR_BIT, 0, upload.mipLevels, 0, 1};
+
+        if (!recordingActive) beginBatch();
+        vkCmdPipelineBarrier(recording.commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+
+        // STAGING_ALIGNMENT is a multiple of every block size, so each band starts at a valid bufferOffset. A level larger
+        // than the ring goes over in bands of whole block rows
+        for (uint32_t level = 0; level < uploadedLevels; level++) {
+            const uint32_t width = std::max(1u, upload.extent.width >> level);
+            const uint32_t height = std::max(1u, upload.extent.height >> level);
+            const uint32_t blockRows = (height + upload.blockHeight - 1) / upload.blockHeight;
+            const VkDeviceSize rowBytes = static_cast<VkDeviceSize>((width + upload.blockWidth - 1) / upload.blockWidth) * upload.blockBytes;
+            if (upload.levels[level].size() < rowBytes * blockRows) throw std::runtime_error("image level is smaller than its extent!");
+
+            const uint32_t rowsPerBand = static_cast<uint32_t>(std::min<VkDeviceSize>(blockRows, stagingSize / rowBytes));
+            if (!rowsPerBand) throw std::runtime_error("image row is larger than the staging ring!");
+
+            for (uint32_t row = 0; row < blockRows; row += rowsPerBand) {
+                const uint32_t rows = std::min(rowsPerBand, blockRows - row);
+                VkDeviceSize consumed;
+                VkDeviceSize stagingOffset = reserveStaging(rows * rowBytes, consumed);
+                std::memcpy(static_cast<char*>(stagingBuffer.allocation.mapped) + stagingOffset, upload.levels[level].data() + row * rowBytes, rows * rowBytes);
+
+                if (!recordingActive) beginBatch();
+                recording.stagingBytes += consumed;
+
+                VkBufferImageCopy region{};
+                region.bufferOffset = stagingOffset;
+                region.imageSubresource = {VK_IMAGE_ASPECT_COLOR_BIT, level, 0, 1};
+                region.imageOffset = {0, static_cast<int32_t>(row * upload.blockHeight), 0};
+                region.imageExtent = {width, std::min(height - row * upload.blockHeight, rows * upload.blockHeight), 1};
+                vkCmdCopyBufferToImage(recording.commandBuffer, stagingBuffer.buffer, image.image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region);
+            }
+        }
+
+        // The layout change to shader reads happens on the graphics side, after the mips it generates there
+        PendingImage pending{image.image, upload.extent, upload.mipLevels, uploadedLevels, barrier};
+        pending.acquire.srcAccessMask = 0;
+        pending.acquire.dstAccessMask = generateChain ? VK_ACCESS_TRANSFER_READ_BIT | VK_ACCESS_TRANSFER_WRITE_BIT : VK_ACCESS_SHADER_READ_BIT;
+        pending.acquire.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+        pending.acquire.newLayout = generateChain ? VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL : VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+        if (transferFamily != graphicsFamily) {
+            pending.acquire.srcQueueFamilyIndex = transferFamily;
+            pending.acquire.dstQueueFamilyIndex = graphicsFamily;
+        }
+        recording.images.push_back(pending);
+        return image;
+    }
+
+    std::optional<StagedUpload> Uploader::tryReserveUpload(VkDeviceSize size, VkBufferUsageFlags usage, const std::vector<uint32_t>& sharedFamilies) {
+        if (size > stagingSize) return std::nullopt;
+
+        retireBatches(false);
+        VkDeviceSize stagingOffset;
+        VkDeviceSize consumed;
+        if (!fitStaging(size, stagingOffset, consumed)) return std::nullopt;
+
+        bool concurrent;
+        StagedUpload upload;
+        upload.buffer = createDestination(size, usage, sharedFamilies, concurrent);
+        upload.staging = static_cast<char*>(stagingBuffer.allocation.mapped) + stagingOffset;
+        upload.size = size;
+
+        stagingHead = stagingOffset + size;
+        stagingUsed += consumed;
+        pendingWrites.fetch_add(1, std::memory_order_relaxed);
+
+        recordCopy(upload.buffer, stagingOffset, 0, size, consumed);
+        releaseOwnership(upload.buffer, usage, concurrent);
+        return upload;
+    }
+
+    BufferAllocation Uploader::createDestination(VkDeviceSize size, VkBufferUsageFlags usage, const std::vector<uint32_t>& sharedFamilies, bool& concurrent) {
+        std::vector<uint32_t> families = {transferFamily, graphicsFamily};
+        families.insert(families.end(), sharedFamilies.begin(), sharedFamilies.end());
+        std::sort(families.begin(), families.end());
+        families.erase(std::unique(families.begin(), families.end()), families.end());
+        concurrent = !sharedFamilies.empty() && families.size() > 1;
+
+        VkBufferCreateInfo bufferInfo{};
+        bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+        bufferInfo.size = size;
+        bufferInfo.usage = usage | VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+        bufferInfo.sharingMode = concurrent ? VK_SHARING_MODE_CONCURRENT : VK_SHARING_MODE_EXCLUSIVE;
+        bufferInfo.queueFamilyIndexCount = concurrent ? static_cast<uint32_t>(families.size()) : 0;
+        bufferInfo.pQueueFamilyIndices = concurrent ? families.data() : nullptr;
+
+        return allocator.createBuffer(bufferInfo, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+    }
+
+    void Uploader::recordCopy(const BufferAllocation& buffer, VkDeviceSize stagingOffset, VkDeviceSize dstOffset, VkDeviceSize size, VkDeviceSize consumed) {
+        if (!recordingActive) beginBatch();
+        recording.stagingBytes += consumed;
+
+        VkBufferCopy region{};
+        region.srcOffset = stagingOffset;
+        region.dstOffset = dstOffset;
+        region.size = size;
+        vkCmdCopyBuffer(recording.commandBuffer, stagingBuffer.buffer, buffer.buffer, 1, &region);
+    }
+
+    void Uploader::releaseOwnership(const BufferAllocation& buffer, VkBufferUsageFlags usage, bool concurrent) {
+        // Same family or concurrent sharing: the batch semaphore alone orders the copy before the first use, no ownership changes hands
+        if (transferFamily == graphicsFamily || concurrent) return;
+
+        VkBufferMemoryBarrier barrier{};
+        barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+        barrier.srcQueueFamilyIndex = transferFamily;
+        barrier.dstQueueFamilyIndex = graphicsFamily;
+        barrier.buffer = buffer.buffer;
+        barrier.offset = 0;
+        barrier.size = VK_WHOLE_SIZE;
+        barrier.dstAccessMask = consumerAccessFor(usage);
+        recording.ownershipBarriers.push_back(barrier);
+    }
+
+//------------------------------SUBMIT------------------------------
+    void Uploader::submit() {
+        if (!recordingActive) return;
+        PROFILE_ZONE("uploadSubmit");
+
+        // Staging writes from tryReserveUpload land in this batch, the copies must not start before they are complete.
+        // Blocks instead of spinning, the writers are job workers that need the core more than this thread does
+        for (uint32_t pending = pendingWrites.load(std::memory_order_acquire); pending > 0; pending = pendingWrites.load(std::memory_order_acquire)) {
+            pendingWrites.wait(pending, std::memory_order_acquire);
+        }
+
+        std::vector<VkImageMemoryBarrier> imageReleases;
+        for (const auto& image : recording.images) {
+            if (image.acquire.srcQueueFamilyIndex == image.acquire.dstQueueFamilyIndex) continue;
+            VkImageMemoryBarrier release = image.acquire;
+            release.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+            release.dstAccessMask = 0;
+            imageReleases.push_back(release);
+        }
+
+        if (!recording.ownershipBarriers.empty() || !imageReleases.empty()) {
+            std::vector<VkBufferMemoryBarrier> releases = recording.ownershipBarriers;
+            for (auto& release : releases) {
+                release.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+                release.dstAccessMask = 0;
+            }
+            vkCmdPipelineBarrier(recording.commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0, 0, nullptr, static_cast<uint32_t>(releases.size()), releases.data(), static_cast<uint32_t>(imageReleases.size()), imageReleases.data());
+        }
+
+        if (vkEndCommandBuffer(recording.commandBuffer) != VK_SUCCESS) throw std::runtime_error("failed to record upload command buffer!");
+
+        VkSemaphoreCreateInfo semaphoreInfo{};
+        semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+
+        VkSemaphore semaphore;
+        if (vkCreateSemaphore(vk_logicalDevice, &semaphoreInfo, nullptr, &semaphore) != VK_SUCCESS) throw std::runtime_error("failed to create upload semaphore!");
+
+        VkSubmitInfo submitInfo{};
+        submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+        submitInfo.commandBufferCount = 1;
+        submitInfo.pCommandBuffers = &recording.commandBuffer;
+        submitInfo.signalSemaphoreCount = 1;
+        submitInfo.pSignalSemaphores = &semaphore;
+
+        if (vkQueueSubmit(vk_transferQueue, 1, &submitInfo, recording.fence) != VK_SUCCESS) {
+            vkDestroySemaphore(vk_logicalDevice, semaphore, nullptr);
+            throw std::runtime_error("failed to submit upload command buffer!");
+        }
+
+        for (auto& acquire : recording.ownershipBarriers) {
+            acquire.srcAccessMask = 0;
+            pendingAcquires.push_back(acquire);
+        }
+        pendingImages.insert(pendingImages.end(), recording.images.begin(), recording.images.end());
+        pendingSemaphores.push_back(semaphore);
+
+        recording.ownershipBarriers.clear();
+        recording.images.clear();
+        inFlight.push_back(std::move(recording));
+        recording = {};
+        recordingActive = false;
+    }
+
+//------------------------------RECORD ACQUIRE------------------------------
+    void Uploader::recordAcquire(VkCommandBuffer commandBuffer, std::vector<VkSemaphore>& waitSemaphores) {
+        PROFILE_ZONE("uploadAcquire");
+        retireBatches(false);
+
+        if (!pendingAcquires.empty()) {
+            vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, CONSUMER_STAGES, 0, 0, nullptr, static_cast<uint32_t>(pendingAcquires.size()), pendingAcquires.data(), 0, nullptr);
+            pendingAcquires.clear();
+        }
+
+        // The semaphore wait covers the transfer stage, which chains it to these barriers and the layout changes they make
+        if (!pendingImages.empty()) {
+            std::vector<VkImageMemoryBarrier> acquires;
+            for (const auto& image : pendingImages) acquires.push_back(image.acquire);
+            vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, CONSUMER_STAGES, 0, 0, nullptr, 0, nullptr, static_cast<uint32_t>(acquires.size()), acquires.data());
+
+            for (const auto& image : pendingImages) {
+                if (image.uploadedLevels < image.mipLevels) generateMips(commandBuffer, image);
+            }
+            pendingImages.clear();
+        }
+
+        waitSemaphores.insert(waitSemaphores.end(), pendingSemaphores.begin(), pendingSemaphores.end());
+        pendingSemaphores.clear();
+    }
+
+//------------------------------GENERATE MIPS------------------------------
+    // Transfer queues can't blit, so the chain is built in the frame's command buffer: each level is blitted from the one
+    // above it, which turns into a blit source first. Every level ends up readable by shaders
+    void Uploader::generateMips(VkCommandBuffer commandBuffer, const PendingImage& image) {
+        VkImageMemoryBarrier barrier{};
+        barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+        barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        barrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+        barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+        barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+        barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.image = image.image;
+        barrier.subresourceRange = {VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1};
+
+        for (uint32_t level = image.uploadedLevels; level < image.mipLevels; level++) {
+            barrier.subresourceRange.baseMipLevel = level - 1;
+            vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+
+            VkImageBlit blit{};
+            blit.srcSubresource = {VK_IMAGE_ASPECT_COLOR_BIT, level - 1, 0, 1};
+            blit.srcOffsets[1] = {static_cast<int32_t>(std::max(1u, image.extent.width >> (level - 1))), static_cast<int32_t>(std::max(1u, image.extent.height >> (level - 1))), 1};
+            blit.dstSubresource = {VK_IMAGE_ASPECT_COLOR_BIT, level, 0, 1};
+            blit.dstOffsets[1] = {static_cast<int32_t>(std::max(1u, image.extent.width >> level)), static_cast<int32_t>(std::max(1u, image.extent.height >> level)), 1};
+            vkCmdBlitImage(commandBuffer, image.image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, image.image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &blit, VK_FILTER_LINEAR);
+        }
+
+        // Uploaded levels above the first blit source are still transfer destinations, like the last generated level
+        std::vector<VkImageMemoryBarrier> finals;
+        barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+        barrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+        if (image.uploadedLevels > 1) {
+            barrier.subresourceRange = {VK_IMAGE_ASPECT_COLOR_BIT, 0, image.uploadedLevels - 1, 0, 1};
+            finals.push_back(barrier);
+        }
+
+        barrier.srcAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+        barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+        barrier.subresourceRange = {VK_IMAGE_ASPECT_COLOR_BIT, image.uploadedLevels - 1, image.mipLevels - image.uploadedLevels, 0, 1};
+        finals.push_back(barrier);
+
+        barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+        barrier.subresourceRange = {VK_IMAGE_ASPECT_COLOR_BIT, image.mipLevels - 1, 1, 0, 1};
+        finals.push_back(barrier);
+
+        vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, CONSUMER_STAGES, 0, 0, nullptr, 0, nullptr, static_cast<uint32_t>(finals.size()), finals.data());
+    }
+
+//------------------------------STAGING RING------------------------------
+    VkDeviceSize Uploader::reserveStaging(VkDeviceSize size, VkDeviceSize& consumed) {
+        if (size > stagingSize) throw std::runtime_error("upload chunk is larger than the staging ring!");
+
+        while (true) {
+            VkDeviceSize offset;
+            if (fitStaging(size, offset, consumed)) {
+                stagingHead = offset + size;
+                stagingUsed += consumed;
+                return offset;
+            }
+
+            // Ring is full, push what has been recorded so far and wait for the oldest batch to release its range
+            submit();
+            retireBatches(true);
+        }
+    }
+
+    bool Uploader::fitStaging(VkDeviceSize size, VkDeviceSize& offset, VkDeviceSize& consumed) const {
+        offset = (stagingHead + STAGING_ALIGNMENT - 1) & ~(STAGING_ALIGNMENT - 1);
+        VkDeviceSize skipped = offset - stagingHead;
+
+        // Not enough room before the end of the ring, skip the tail and wrap around to the start
+        if (offset + size > stagingSize) {
+            offset = 0;
+            skipped = stagingSize - stagingHead;
+        }
+
+        consumed = skipped + size;
+        return stagingUsed + consumed <= stagingSize;
+    }
+
+//------------------------------BATCHES------------------------------
+    void Uploader::beginBatch() {
+        if (!freeBatches.empty()) {
+            recording = std::move(freeBatches.back());
+            freeBatches.pop_back();
+        } else {
+            VkCommandBufferAllocateInfo allocInfo{};
+            allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+            allocInfo.commandPool = vk_commandPool;
+            allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+            allocInfo.commandBufferCount = 1;
+
+            if (vkAllocateCommandBuffers(vk_logicalDevice, &allocInfo, &recording.commandBuffer) != VK_SUCCESS) throw std::runtime_error("failed to allocate upload command buffer!");
+
+            VkFenceCreateInfo fenceInfo{};
+            fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+
+            if (vkCreateFence(vk_logicalDevice, &fenceInfo, nullptr, &recording.fence) != VK_SUCCESS) throw std::runtime_error("failed to create upload fence!");
+        }
+
+        recording.stagingBytes = 0;
+
+        VkCommandBufferBeginInfo beginInfo{};
+        beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+        beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+
+        if (vkBeginCommandBuffer(recording.commandBuffer, &beginInfo) != VK_SUCCESS) throw std::runtime_error("failed to begin recording upload command buffer!");
+        recordingActive = true;
+    }
+
+    void Uploader::retireBatches(bool waitForOldest) {
+        if (waitForOldest && !inFlight.empty()) vkWaitForFences(vk_logicalDevice, 1, &inFlight.front().fence, VK_TRUE, UINT64_MAX);
+
+        // Batches finish in submission order, so their staging ranges are released from the tail of the ring
+        while (!inFlight.empty() && vkGetFenceStatus(vk_logicalDevice, inFlight.front().fence) == VK_SUCCESS) {
+            Batch batch = std::move(inFlight.front());
+            inFlight.pop_front();
+
+            stagingUsed -= batch.stagingBytes;
+            vkResetFences(vk_logicalDevice, 1, &batch.fence);
+            freeBatches.push_back(std::move(batch));
+        }
+
+        if (!stagingUsed) stagingHead = 0;
+    }
+
+//------------------------------DESTROY------------------------------
+    Uploader::~Uploader() {
+        if (recordingActive) vkEndCommandBuffer(recording.commandBuffer);
+
+        for (auto& batch : inFlight) vkWaitForFences(vk_logicalDevice, 1, &batch.fence, VK_TRUE, UINT64_MAX);
+
+        for (auto& batch : inFlight) vkDestroyFence(vk_logicalDevice, batch.fence, nullptr);
+        for (auto& batch : freeBatches) vkDestroyFence(vk_logicalDevice, batch.fence, nullptr);
+        if (recording.fence != VK_NULL_HANDLE) vkDestroyFence(vk_logicalDevice, recording.fence, nullptr);
+
+        for (auto semaphore : pendingSemaphores) vkDestroySemaphore(vk_logicalDevice, semaphore, nullptr);
+
+        vkDestroyCommandPool(vk_logicalDevice, vk_commandPool, nullptr);
+        allocator.destroyBuffer(stagingBuffer);
+    }
+}
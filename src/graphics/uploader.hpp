@@ -0,0 +1,117 @@
+#pragma once
+
+#include "../includes/graphics.hpp"
+#include "allocator.hpp"
+#include <stdexcept>
+#include <algorithm>
+#include <cstring>
+#include <atomic>
+#include <deque>
+#include <optional>
+#include <span>
+#include <thread>
+#include <vector>
+
+namespace Graphics {
+
+    // Destination buffer plus the staging range its bytes have to be written to before the batch is submitted
+    struct StagedUpload {
+        BufferAllocation buffer;
+        void* staging = nullptr;
+        VkDeviceSize size = 0;
+    };
+
+    // Sampled image built from tightly packed levels, starting at level 0. Levels past the given ones are generated on
+    // the graphics queue by blitting down the chain, so the format has to support linear blits then
+    struct ImageUpload {
+        VkFormat format = VK_FORMAT_UNDEFINED;
+        VkExtent2D extent{};
+        uint32_t mipLevels = 1;
+        std::vector<std::span<const std::byte>> levels;
+        // Texel block of the format, 4x4 for block-compressed ones
+        uint32_t blockWidth = 1;
+        uint32_t blockHeight = 1;
+        uint32_t blockBytes = 4;
+    };
+
+    // Copies data into device-local buffers through a persistently mapped staging ring. Copies are recorded into
+    // batches that run on the transfer queue; the graphics side picks them up with recordAcquire, which records the
+    // queue-ownership acquire barriers and hands back the semaphores the next frame submission has to wait on
+    class Uploader {
+
+        public:
+            // Every stage an upload can be consumed in, used for the acquire barrier and the semaphore wait. Transfer is the
+            // mip generation recordAcquire does for images
+            static constexpr VkPipelineStageFlags CONSUMER_STAGES = VK_PIPELINE_STAGE_TRANSFER_BIT | VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_VERTEX_INPUT_BIT | VK_PIPELINE_STAGE_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+
+            Uploader(VkDevice device, Allocator& allocator, VkQueue transferQueue, uint32_t transferFamily, uint32_t graphicsFamily, VkDeviceSize stagingSize = 8ull * 1024 * 1024);
+            ~Uploader();
+            Uploader(const Uploader&) = delete;
+            Uploader& operator=(const Uploader&) = delete;
+
+            // Families in sharedFamilies read the buffer besides the graphics one, it is then shared concurrently with them
+            // and skips the ownership transfer, so only the semaphore from recordAcquire has to order its first use
+            BufferAllocation uploadBuffer(const void* data, VkDeviceSize size, VkBufferUsageFlags usage, const std::vector<uint32_t>& sharedFamilies = {});
+            // The image is in SHADER_READ_ONLY_OPTIMAL for the graphics family once the work from recordAcquire ran
+            ImageAllocation uploadImage(const ImageUpload& upload);
+            // Records the copy right away but leaves filling the staging range to the caller, which may do it on any thread
+            // and reports it with writeFinished. Returns nothing when the ring has no room without flushing, or the data
+            // doesn't fit in one piece
+            std::optional<StagedUpload> tryReserveUpload(VkDeviceSize size, VkBufferUsageFlags usage, const std::vector<uint32_t>& sharedFamilies = {});
+            // The last outstanding write wakes a submit blocked on the batch
+            inline void writeFinished() { if (pendingWrites.fetch_sub(1, std::memory_order_release) == 1) pendingWrites.notify_all(); }
+            inline VkDeviceSize getStagingSize() const { return stagingSize; }
+            // Waits for reserved staging writes of the batch before handing it to the queue
+            void submit();
+            // Semaphores appended to waitSemaphores are owned by the caller once the submission waiting on them has finished
+            void recordAcquire(VkCommandBuffer commandBuffer, std::vector<VkSemaphore>& waitSemaphores);
+
+        private:
+            // Image whose copies are recorded, handed to the graphics side with the batch
+            struct PendingImage {
+                VkImage image;
+                VkExtent2D extent;
+                uint32_t mipLevels;
+                uint32_t uploadedLevels;
+                VkImageMemoryBarrier acquire;
+            };
+
+            struct Batch {
+                VkCommandBuffer commandBuffer = VK_NULL_HANDLE;
+                VkFence fence = VK_NULL_HANDLE;
+                VkDeviceSize stagingBytes = 0;
+                std::vector<VkBufferMemoryBarrier> ownershipBarriers;
+                std::vector<PendingImage> images;
+            };
+
+            static constexpr VkDeviceSize STAGING_ALIGNMENT = 16;
+
+            VkDevice vk_logicalDevice;
+            Allocator& allocator;
+            VkQueue vk_transferQueue;
+            uint32_t transferFamily;
+            uint32_t graphicsFamily;
+            VkCommandPool vk_commandPool = VK_NULL_HANDLE;
+            BufferAllocation stagingBuffer;
+            VkDeviceSize stagingSize;
+            VkDeviceSize stagingHead = 0;
+            VkDeviceSize stagingUsed = 0;
+            Batch recording;
+            bool recordingActive = false;
+            std::deque<Batch> inFlight;
+            std::vector<Batch> freeBatches;
+            std::vector<VkBufferMemoryBarrier> pendingAcquires;
+            std::vector<PendingImage> pendingImages;
+            std::vector<VkSemaphore> pendingSemaphores;
+            std::atomic<uint32_t> pendingWrites = 0;
+
+            BufferAllocation createDestination(VkDeviceSize size, VkBufferUsageFlags usage, const std::vector<uint32_t>& sharedFamilies, bool& concurrent);
+            void recordCopy(const BufferAllocation& buffer, VkDeviceSize stagingOffset, VkDeviceSize dstOffset, VkDeviceSize size, VkDeviceSize consumed);
+            void releaseOwnership(const BufferAllocation& buffer, VkBufferUsageFlags usage, bool concurrent);
+            void generateMips(VkCommandBuffer commandBuffer, const PendingImage& image);
+            bool fitStaging(VkDeviceSize size, VkDeviceSize& offset, VkDeviceSize& consumed) const;
+            VkDeviceSize reserveStaging(VkDeviceSize size, VkDeviceSize& consumed);
+            void beginBatch();
+            void retireBatches(bool waitForOldest);
+    };
+}
@@ -0,0 +1,103 @@
+#pragma once
+
+#include "../includes/graphics.hpp"
+#include "allocator.hpp"
+#include "deletionQueue.hpp"
+#include <utility>
+
+namespace Graphics {
+
+    // Traits say what a handle holds, what it needs to destroy it and how. They are tags rather than
+    // specializations on the Vulkan type, non-dispatchable handles are all uint64_t on 32-bit targets
+    template<typename T, void (VKAPI_PTR* Destroy)(VkDevice, T, const VkAllocationCallbacks*)>
+    struct DeviceObjectTraits {
+        using Type = T;
+        using Owner = VkDevice;
+        static bool valid(T object) { return object != VK_NULL_HANDLE; }
+        static void destroy(VkDevice device, T object) { Destroy(device, object, nullptr); }
+    };
+
+    struct ImageTraits : DeviceObjectTraits<VkImage, vkDestroyImage> {};
+    struct ImageViewTraits : DeviceObjectTraits<VkImageView, vkDestroyImageView> {};
+    struct PipelineTraits : DeviceObjectTraits<VkPipeline, vkDestroyPipeline> {};
+    struct FramebufferTraits : DeviceObjectTraits<VkFramebuffer, vkDestroyFramebuffer> {};
+    struct SemaphoreTraits : DeviceObjectTraits<VkSemaphore, vkDestroySemaphore> {};
+
+    struct BufferAllocationTraits {
+        using Type = BufferAllocation;
+        using Owner = Allocator*;
+        static bool valid(const BufferAllocation& buffer) { return buffer.buffer != VK_NULL_HANDLE; }
+        static void destroy(Allocator* allocator, BufferAllocation& buffer) { allocator->destroyBuffer(buffer); }
+    };
+
+    struct ImageAllocationTraits {
+        using Type = ImageAllocation;
+        using Owner = Allocator*;
+        static bool valid(const ImageAllocation& image) { return image.image != VK_NULL_HANDLE; }
+        static void destroy(Allocator* allocator, ImageAllocation& image) { allocator->destroyImage(image); }
+    };
+
+    struct MemoryTraits {
+        using Type = Allocation;
+        using Owner = Allocator*;
+        static bool valid(const Allocation& allocation) { return allocation.memory != VK_NULL_HANDLE; }
+        static void destroy(Allocator* allocator, Allocation& allocation) { allocator->freeMemory(allocation); }
+    };
+
+    // Sole owner of one Vulkan object. Letting go of it (reset, reassignment, destruction) destroys the object right
+    // away, or with a deletion queue retires it with the frame being recorded, so it dies once that frame has finished
+    // on the GPU and nothing has to wait for the device to go idle
+    template<typename Traits>
+    class UniqueHandle {
+
+        public:
+            using Type = typename Traits::Type;
+            using Owner = typename Traits::Owner;
+
+            UniqueHandle() = default;
+            UniqueHandle(Owner owner, Type object, DeletionQueue* deletionQueue = nullptr) : owner(owner), object(object), deletionQueue(deletionQueue) {}
+            ~UniqueHandle() { reset(); }
+
+            UniqueHandle(UniqueHandle&& other) noexcept : owner(other.owner), object(std::exchange(other.object, Type{})), deletionQueue(other.deletionQueue) {}
+            UniqueHandle& operator=(UniqueHandle&& other) noexcept {
+                if (this != &other) {
+                    reset();
+                    owner = other.owner;
+                    object = std::exchange(other.object, Type{});
+                    deletionQueue = other.deletionQueue;
+                }
+                return *this;
+            }
+            UniqueHandle(const UniqueHandle&) = delete;
+            UniqueHandle& operator=(const UniqueHandle&) = delete;
+
+            // A reference, so arrays of one can be passed where Vulkan takes a pointer
+            inline const Type& get() const { return object; }
+            inline explicit operator bool() const { return Traits::valid(object); }
+
+            // Gives the object up without destroying it
+            inline Type release() { return std::exchange(object, Type{}); }
+
+            void reset() {
+                if (!Traits::valid(object)) return;
+                if (deletionQueue) {
+                    deletionQueue->retire([owner = owner, object = object]() mutable { Traits::destroy(owner, object); });
+                } else Traits::destroy(owner, object);
+                object = Type{};
+            }
+
+        private:
+            Owner owner{};
+            Type object{};
+            DeletionQueue* deletionQueue = nullptr;
+    };
+
+    using ImageHandle = UniqueHandle<ImageTraits>;
+    using ImageViewHandle = UniqueHandle<ImageViewTraits>;
+    using PipelineHandle = UniqueHandle<PipelineTraits>;
+    using FramebufferHandle = UniqueHandle<FramebufferTraits>;
+    using SemaphoreHandle = UniqueHandle<SemaphoreTraits>;
+    using BufferHandle = UniqueHandle<BufferAllocationTraits>;
+    using ImageAllocationHandle = UniqueHandle<ImageAllocationTraits>;
+    using MemoryHandle = UniqueHandle<MemoryTraits>;
+}
\ No newline at end of file
@@ -3,10 +3,21 @@
 #include <nlohmann/json.hpp>
 #include <fstream>
 #include <iostream>
+#include <chrono>
+#include <cmath>
+#include <string>
+#include <optional>
+#include <thread>
+#include <vector>
 
 #include "graphics/instance.hpp"
 #include "graphics/device.hpp"
 #include "graphics/renderer.hpp"
+#include "graphics/benchmark.hpp"
+#include "graphics/assetStreamer.hpp"
+#include "graphics/texture.hpp"
+#include "graphics/framePacer.hpp"
+#include "graphics/profiler.hpp"
 
 //------------------------------LOAD JSON------------------------------
 nlohmann::json loadJson() {
@@ -15,12 +26,140 @@ nlohmann::json loadJson() {
     if (!file.is_open()) {
         std::cerr << "Failed to open JSON config\n";
     }
-    
+
     nlohmann::json j;
     file >> j;
     return j;
 }
 
+//------------------------------APPLY COMMAND LINE------------------------------
+void applyCommandLine(nlohmann::json& json, int argc, char** argv) {
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+
+        if (arg == "--headless") json["mode"] = "headless";
+        else if (arg == "--headless-surface") json["mode"] = "headless-surface";
+        else if (arg == "--windowed") json["mode"] = "windowed";
+        else if (arg == "--frames" && i + 1 < argc) json["headless"]["frames"] = std::stoul(argv[++i]);
+        else if (arg == "--benchmark") json["benchmark"]["enabled"] = true;
+        else if (arg == "--benchmark-output" && i + 1 < argc) json["benchmark"]["output"] = argv[++i];
+        else if (arg == "--record-threads" && i + 1 < argc) json["renderer"]["recordThreads"] = std::stoul(argv[++i]);
+        else if (arg == "--draw-count" && i + 1 < argc) json["renderer"]["drawCount"] = std::stoul(argv[++i]);
+        else if (arg == "--instance-count" && i + 1 < argc) json["renderer"]["instanceCount"] = std::stoul(argv[++i]);
+        else if (arg == "--stress") {
+            json["renderer"]["instanceCount"] = json.at("stress").at("instanceCount");
+            json["renderer"]["camera"] = json.at("stress").at("camera");
+            json["benchmark"]["enabled"] = true;
+        }
+        else if (arg == "--gpu-culling") json["renderer"]["gpuCulling"] = true;
+        else if (arg == "--no-gpu-culling") json["renderer"]["gpuCulling"] = false;
+        else if (arg == "--timeline-semaphore") json["renderer"]["timelineSemaphore"] = true;
+        else if (arg == "--no-timeline-semaphore") json["renderer"]["timelineSemaphore"] = false;
+        else if (arg == "--update-after-bind") json["renderer"]["updateAfterBind"] = true;
+        else if (arg == "--no-update-after-bind") json["renderer"]["updateAfterBind"] = false;
+        else if (arg == "--async-compute") json["renderer"]["asyncCompute"] = true;
+        else if (arg == "--no-async-compute") json["renderer"]["asyncCompute"] = false;
+        else if (arg == "--present-profile" && i + 1 < argc) json["renderer"]["presentProfile"] = argv[++i];
+        else if (arg == "--job-threads" && i + 1 < argc) json["jobs"]["workerThreads"] = std::stoul(argv[++i]);
+        else if (arg == "--job-benchmark") json["benchmark"]["jobBenchmark"] = true;
+        else if (arg == "--asset-pack" && i + 1 < argc) json["assets"]["pack"] = argv[++i];
+        else if (arg == "--startup-trace" && i + 1 < argc) json["startup"]["trace"] = argv[++i];
+        else if (arg == "--no-device-cache") json["startup"]["deviceCache"] = "";
+        else if (arg == "--frame-pacing") json["pacing"]["enabled"] = true;
+        else if (arg == "--no-frame-pacing") json["pacing"]["enabled"] = false;
+        else if (arg == "--max-queued-frames" && i + 1 < argc) json["pacing"]["maxQueuedFrames"] = std::stoul(argv[++i]);
+        else if (arg == "--profile") {
+            json["profiler"]["enabled"] = true;
+            json["profiler"]["writeOnExit"] = true;
+        }
+        else if (arg == "--profile-output" && i + 1 < argc) json["profiler"]["output"] = argv[++i];
+        else if (arg == "--no-profiler") json["profiler"]["enabled"] = false;
+        else if (arg == "--record-sweep") {
+            json["benchmark"]["enabled"] = true;
+            json["benchmark"]["recordThreadSweep"] = true;
+        }
+        else throw std::runtime_error("unknown command line argument: " + arg);
+    }
+}
+
+//------------------------------RECORD THREAD SWEEP------------------------------
+// 1, 2, 4, ... threads up to the configured count, or every hardware thread when recording inline
+std::vector<uint32_t> recordSweepThreadCounts(uint32_t recordThreads) {
+    const uint32_t maxThreads = recordThreads ? recordThreads : std::max(1u, std::thread::hardware_concurrency());
+
+    std::vector<uint32_t> counts;
+    for (uint32_t threads = 1; threads < maxThreads; threads *= 2) counts.push_back(threads);
+    counts.push_back(maxThreads);
+    return counts;
+}
+
+//------------------------------RENDER GRAPH REPORT------------------------------
+// Byte counts are per frame slot, unaliasedBytes is what the transient images would take without sharing memory
+nlohmann::json renderGraphReport(const Graphics::RenderGraphStats& stats) {
+    nlohmann::json report;
+    report["passes"] = stats.passes;
+    report["culledPasses"] = stats.culledPasses;
+    report["dependencies"] = stats.dependencies;
+    report["transientImages"] = stats.transientImages;
+    report["transientBytes"] = stats.transientBytes;
+    report["unaliasedBytes"] = stats.unaliasedBytes;
+    report["lazilyAllocated"] = stats.lazilyAllocated;
+    return report;
+}
+
+//------------------------------BINDLESS REPORT------------------------------
+nlohmann::json bindlessReport(const Graphics::BindlessStats& stats) {
+    nlohmann::json report;
+    report["updateAfterBind"] = stats.updateAfterBind;
+    report["storageBuffers"] = {stats.storageBuffers, stats.storageBufferCapacity};
+    report["sampledImages"] = {stats.sampledImages, stats.sampledImageCapacity};
+    report["samplers"] = {stats.samplers, stats.samplerCapacity};
+    return report;
+}
+
+//------------------------------ASSET STREAM REPORT------------------------------
+nlohmann::json assetStreamReport(const Graphics::AssetStreamStats& stats) {
+    nlohmann::json report;
+    report["assets"] = {stats.resident, stats.requested};
+    report["bytes"] = {stats.bytesResident, stats.bytesRequested};
+    report["waves"] = stats.waves;
+    report["framesWhileStreaming"] = stats.framesWhileStreaming;
+    report["streamMs"] = stats.streamMs;
+    return report;
+}
+
+//------------------------------TEXTURE REPORT------------------------------
+nlohmann::json textureReport(const Graphics::TextureStats& stats) {
+    nlohmann::json report;
+    report["textures"] = stats.textures;
+    report["compressed"] = stats.compressed;
+    report["decoded"] = stats.decoded;
+    report["generatedMips"] = stats.generatedMips;
+    report["imageBytes"] = stats.imageBytes;
+    report["rgba8Bytes"] = stats.rgba8Bytes;
+    return report;
+}
+
+//------------------------------DEVICE SELECTION REPORT------------------------------
+nlohmann::json deviceSelectionReport(const Graphics::DeviceSelection& selection) {
+    nlohmann::json report;
+    report["candidates"] = selection.candidates;
+    report["suitable"] = selection.suitable;
+    report["score"] = selection.score;
+    report["cacheHit"] = selection.cacheHit;
+    return report;
+}
+
+//------------------------------DISPLAY REFRESH RATE------------------------------
+// Refresh rate of the monitor the window is on, the primary one for a windowed window. 60 Hz without a display
+double displayRefreshRate(GLFWwindow* window) {
+    if (!window) return 60.0;
+    GLFWmonitor* monitor = glfwGetWindowMonitor(window);
+    if (!monitor) monitor = glfwGetPrimaryMonitor();
+    const GLFWvidmode* videoMode = monitor ? glfwGetVideoMode(monitor) : nullptr;
+    return videoMode && videoMode->refreshRate > 0 ? static_cast<double>(videoMode->refreshRate) : 60.0;
+}
+
 //------------------------------INITIALIZE GLFW------------------------------
 GLFWwindow* initGLFW(const nlohmann::json& w) {
     if (!glfwInit()) {
@@ -30,7 +169,7 @@ GLFWwindow* initGLFW(const nlohmann::json& w) {
     const auto& json = w.at("window");
 
     glfwWindowHint(GLFW_CLIENT_API, GLFW_NO_API);
-    glfwWindowHint(GLFW_RESIZABLE, GLFW_FALSE);
+    glfwWindowHint(GLFW_RESIZABLE, GLFW_TRUE);
 
     return glfwCreateWindow(
         json.at("width").get<int>(),
@@ -41,33 +180,357 @@ GLFWwindow* initGLFW(const nlohmann::json& w) {
     );
 }
 
-int main() {
+int main(int argc, char** argv) {
     try {
+        // Every startup phase is measured from here to the first presented frame
+        Graphics::StartupTrace startupTrace;
+        auto phaseStart = std::chrono::steady_clock::now();
+
         nlohmann::json json = loadJson();
-        GLFWwindow* window = initGLFW(json);
+        applyCommandLine(json, argc, argv);
+
+        // Zones stay compiled in, off they cost one relaxed load. F12 dumps what the rings hold at any point
+        const nlohmann::json& profilerSettings = json.at("profiler");
+        const std::string profilerOutput = profilerSettings.at("output").get<std::string>();
+        Graphics::Profiler::setEnabled(profilerSettings.at("enabled").get<bool>());
+        PROFILE_THREAD("main");
+
+        // 0 worker threads means one per hardware thread besides the main one
+        const uint32_t configuredWorkers = json.at("jobs").at("workerThreads").get<uint32_t>();
+        const uint32_t jobWorkers = configuredWorkers ? configuredWorkers : Graphics::JobSystem::defaultWorkerCount();
+
+        // Measures the job system on its own, no window or Vulkan device is created
+        if (json.at("benchmark").value("jobBenchmark", false)) {
+            const std::string output = json.at("benchmark").at("output").get<std::string>();
+            std::ofstream file(output);
+            if (!file.is_open()) throw std::runtime_error("failed to open benchmark report: " + output);
+            file << Graphics::benchmarkJobSystem(jobWorkers).dump(4) << "\n";
+            return 0;
+        }
+
+        // "windowed" presents to a GLFW window, "headless" renders into offscreen images and
+        // "headless-surface" drives a real swapchain on VK_EXT_headless_surface, both without a display
+        const std::string mode = json.value("mode", "windowed");
+        const bool headless = mode != "windowed";
+        if (headless && mode != "headless" && mode != "headless-surface") throw std::runtime_error("unknown mode: " + mode);
+
+        startupTrace.record("settings", phaseStart);
 
-        if (!window)
-            throw std::runtime_error("Failed to create GLFW window");
+        GLFWwindow* window = nullptr;
+        bool framebufferResized = false;
+        if (!headless) {
+            phaseStart = std::chrono::steady_clock::now();
+            window = initGLFW(json);
+
+            if (!window)
+                throw std::runtime_error("Failed to create GLFW window");
+
+            // Some platforms never report VK_ERROR_OUT_OF_DATE_KHR on resize, so the callback flags it as well
+            glfwSetWindowUserPointer(window, &framebufferResized);
+            glfwSetFramebufferSizeCallback(window, [](GLFWwindow* resizedWindow, int, int) {
+                *static_cast<bool*>(glfwGetWindowUserPointer(resizedWindow)) = true;
+            });
+            startupTrace.record("window", phaseStart);
+        }
 
         {
-            Graphics::Instance instance;
-            instance.createSurface(window);
-            Graphics::Device device(instance.getInstance(), instance.getSurface(), instance.getEnableValidationLayers(), instance.getValidationLayers());
-            device.createCommandPool(instance.getSurface());
-            device.createSwapChain(window, instance.getSurface());
-            device.createImageViews();
-            Graphics::Renderer renderer(device.getLogicalDevice(), device.getSwapChainExtent(), device.getSwapChainImageFormat(), device.getSwapChainImageViews(), device.getCommandPool());
-
-            while (!glfwWindowShouldClose(window)) {
-                glfwPollEvents();
-                renderer.drawFrame(device.getSwapChain(), device.getSwapChainExtent(), device.getGraphicsQueue(), device.getPresentQueue());
+            const VkExtent2D targetExtent = {json.at("window").at("width").get<uint32_t>(), json.at("window").at("height").get<uint32_t>()};
+            const uint32_t framesInFlight = std::clamp(json.at("renderer").at("framesInFlight").get<uint32_t>(), Graphics::Renderer::MIN_FRAMES_IN_FLIGHT, Graphics::Renderer::MAX_FRAMES_IN_FLIGHT);
+
+            const bool timelineSemaphore = json.at("renderer").at("timelineSemaphore").get<bool>();
+            const bool updateAfterBind = json.at("renderer").at("updateAfterBind").get<bool>();
+            phaseStart = std::chrono::steady_clock::now();
+            Graphics::Instance instance(headless, timelineSemaphore || updateAfterBind);
+            startupTrace.record("instance", phaseStart);
+            phaseStart = std::chrono::steady_clock::now();
+            if (mode == "windowed") instance.createSurface(window);
+            else if (mode == "headless-surface") instance.createHeadlessSurface();
+            startupTrace.record("surface", phaseStart);
+
+            phaseStart = std::chrono::steady_clock::now();
+            Graphics::Device device(instance.getInstance(), instance.getSurface(), instance.getEnableValidationLayers(), instance.getValidationLayers(), instance.getApiVersion(),
+                                    json.at("startup").at("deviceCache").get<std::string>(), instance.getFeatures2Supported());
+            startupTrace.record("device", phaseStart);
+            startupTrace.record("selectDevice", device.getSelection().span);
+
+            phaseStart = std::chrono::steady_clock::now();
+            const bool offscreen = instance.getSurface() == VK_NULL_HANDLE;
+            if (offscreen) {
+                device.createOffscreenTargets(targetExtent, VK_FORMAT_R8G8B8A8_UNORM, framesInFlight);
+            } else {
+                device.setPresentProfile(Graphics::parsePresentProfile(json.at("renderer").at("presentProfile").get<std::string>()));
+                device.createSwapChain(window, instance.getSurface(), targetExtent);
+                device.createImageViews();
+            }
+            startupTrace.record(offscreen ? "offscreenTargets" : "swapChain", phaseStart);
+
+            phaseStart = std::chrono::steady_clock::now();
+            Graphics::PipelineCache pipelineCache(device.getLogicalDevice(), device.getPhysicalDeviceProperties(), json.at("renderer").at("pipelineCache").get<std::string>());
+            startupTrace.record("pipelineCache", phaseStart);
+            phaseStart = std::chrono::steady_clock::now();
+            Graphics::JobSystem jobSystem(jobWorkers);
+            Graphics::Uploader uploader(device.getLogicalDevice(), device.getAllocator(), device.getTransferQueue(), device.getTransferQueueFamily(), device.getGraphicsQueueFamily());
+            // Outlives the renderer, whose frames write its queries
+            std::optional<Graphics::GpuProfiler> gpuProfiler;
+            if (Graphics::Profiler::isEnabled()) {
+                if (device.getTimestampsSupported()) gpuProfiler.emplace(device, framesInFlight);
+                else std::cout << "GPU timestamps are not supported, the profiler only records CPU zones\n";
+            }
+            if (updateAfterBind && !device.getUpdateAfterBindSupported()) std::cout << "Update-after-bind descriptors need Vulkan 1.2, the bindless table is only changed while the device is idle\n";
+            // Returns with the graphics pipeline still building on the job system, the scene and assets below overlap it
+            Graphics::Renderer renderer(device.getLogicalDevice(), device.getSwapChainExtent(), device.getSwapChainImageFormat(), device.getSwapChainImageViews(), device.getGraphicsQueueFamily(), pipelineCache, device.getAllocator(), uploader, jobSystem, framesInFlight,
+                                        device.getPhysicalDeviceProperties().limits, offscreen, updateAfterBind && device.getUpdateAfterBindSupported());
+            if (gpuProfiler) renderer.setGpuProfiler(&*gpuProfiler);
+            startupTrace.record("renderer", phaseStart);
+
+            const uint32_t recordThreads = json.at("renderer").at("recordThreads").get<uint32_t>();
+            const uint32_t drawCount = json.at("renderer").at("drawCount").get<uint32_t>();
+            const bool gpuCulling = json.at("renderer").at("gpuCulling").get<bool>();
+            if (timelineSemaphore) {
+                if (device.getTimelineSemaphoresSupported()) renderer.enableTimelineSemaphore();
+                else std::cout << "Timeline semaphores need Vulkan 1.2, frames stay synchronized with fences\n";
+            }
+            if (json.at("renderer").at("asyncCompute").get<bool>() && !renderer.enableAsyncCompute(device.getComputeQueue(), device.getComputeQueueFamily(), device.getGraphicsQueueFamily()))
+                std::cout << "No dedicated compute queue family, compute work stays on the graphics queue\n";
+            phaseStart = std::chrono::steady_clock::now();
+            renderer.buildScene(json.at("renderer").at("instanceCount").get<uint32_t>(), drawCount, gpuCulling);
+            const uint32_t instanceCount = renderer.getInstanceCount();
+            if (recordThreads) renderer.setRecordThreads(device.getGraphicsQueueFamily(), recordThreads);
+            startupTrace.record("scene", phaseStart);
+
+            // Textures of the pack are loaded before the first frame, so the bindless table can take them without
+            // update-after-bind. Every other blob streams in while frames render, nothing waits for it to become resident
+            std::optional<Graphics::AssetPack> assetPack;
+            std::optional<Graphics::AssetStreamer> assetStreamer;
+            Graphics::TextureLoader textureLoader(device.getPhysicalDevice(), device.getLogicalDevice(), device.getAllocator(), uploader, jobSystem, device.getTextureCompressionBCSupported());
+            const std::string assetPackPath = json.at("assets").at("pack").get<std::string>();
+            if (!assetPackPath.empty()) {
+                phaseStart = std::chrono::steady_clock::now();
+                assetPack.emplace(assetPackPath);
+                assetStreamer.emplace(*assetPack, device.getAllocator(), uploader, jobSystem);
+                for (const auto& entry : assetPack->getEntries()) {
+                    if (entry.type == Graphics::AssetType::Texture) renderer.registerTexture(textureLoader.getTexture(textureLoader.load(assetPack->getData(entry))).view);
+                    else if (entry.size) assetStreamer->request(assetPack->getName(entry), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT);
+                }
+                uploader.submit();
+                startupTrace.record("assets", phaseStart);
+            }
+
+            if (json.at("renderer").at("hotReload").get<bool>()) {
+#if defined(URAN_GLSLC_EXECUTABLE) && defined(URAN_SHADER_SOURCE_DIR)
+                renderer.enableShaderHotReload(URAN_GLSLC_EXECUTABLE, URAN_SHADER_SOURCE_DIR);
+#else
+                std::cerr << "Shader hot-reload needs a build with glslc available, ignoring renderer.hotReload\n";
+#endif
+            }
+
+            std::optional<Graphics::Benchmark> benchmark;
+            const nlohmann::json& benchmarkSettings = json.at("benchmark");
+            const bool recordSweep = benchmarkSettings.value("recordThreadSweep", false);
+            if (benchmarkSettings.value("enabled", false)) {
+                benchmark.emplace(benchmarkSettings.at("warmupFrames").get<uint32_t>(), benchmarkSettings.at("measuredFrames").get<uint32_t>());
+                if (device.getTimestampsSupported()) renderer.enableGpuTimestamps(device.getTimestampPeriod());
+                else std::cerr << "GPU timestamps are not supported, benchmark will only report CPU timings\n";
+            }
+
+            // A zoomed-in camera orbiting the scene keeps part of it outside the frustum, giving the culling pass work to do
+            const nlohmann::json& cameraSettings = json.at("renderer").at("camera");
+            const float cameraZoom = cameraSettings.at("zoom").get<float>();
+            const float cameraOrbitSpeed = cameraSettings.at("orbitSpeed").get<float>();
+            uint64_t framesRendered = 0;
+
+            // Only presented frames have a display time to measure, offscreen frames never reach one
+            std::optional<Graphics::FramePacer> framePacer;
+            if (!offscreen) {
+                const nlohmann::json& pacingSettings = json.at("pacing");
+                Graphics::FramePacingSettings pacing;
+                pacing.enabled = pacingSettings.at("enabled").get<bool>();
+                pacing.maxQueuedFrames = std::clamp(pacingSettings.at("maxQueuedFrames").get<uint32_t>(), 1u, framesInFlight);
+                pacing.marginMs = pacingSettings.at("marginMs").get<double>();
+                pacing.refreshRate = displayRefreshRate(window);
+
+                if (device.getPresentWaitSupported()) renderer.enablePresentId();
+                else std::cout << "VK_KHR_present_wait is not available, display times are estimated from GPU completion\n";
+                framePacer.emplace(device, renderer, pacing);
+            }
+
+            auto recreateSwapChain = [&]() {
+                // A minimized window has a zero-sized framebuffer and no valid swapchain, sleep until it comes back
+                if (window) {
+                    int width = 0, height = 0;
+                    glfwGetFramebufferSize(window, &width, &height);
+                    while ((width == 0 || height == 0) && !glfwWindowShouldClose(window)) {
+                        glfwWaitEvents();
+                        glfwGetFramebufferSize(window, &width, &height);
+                    }
+                }
+
+                Graphics::RetiredSwapChain retired = device.recreateSwapChain(window, instance.getSurface(), targetExtent);
+                renderer.recreateSwapChainResources(device.getSwapChainExtent(), device.getSwapChainImageViews(), retired.swapChain, std::move(retired.imageViews));
+                if (framePacer) framePacer->swapChainRecreated();
+            };
+
+            // The trace ends with the first frame handed to the display, by then the graphics pipeline job is done too
+            const std::string startupTracePath = json.at("startup").at("trace").get<std::string>();
+            auto finishStartupTrace = [&](std::chrono::steady_clock::time_point firstFrameStart) {
+                startupTrace.record("firstFrame", firstFrameStart);
+                startupTrace.record("graphicsPipeline", renderer.getPipelineBuildSpan(), true);
+                if (startupTracePath.empty()) return;
+
+                nlohmann::json context;
+                context["mode"] = mode;
+                context["device"] = device.getDeviceName();
+                context["jobWorkers"] = jobSystem.getWorkerCount();
+                context["deviceSelection"] = deviceSelectionReport(device.getSelection());
+                startupTrace.writeReport(startupTracePath, context);
+            };
+
+            bool traceKeyHeld = false;
+            // Set by the first frame attempt, cleared once a frame has actually reached the display
+            std::optional<std::chrono::steady_clock::time_point> firstFrameStart;
+            bool startupTraceFinished = false;
+            auto renderFrame = [&]() {
+                PROFILE_ZONE("frame");
+                const auto frameStart = std::chrono::steady_clock::now();
+                if (!startupTraceFinished && !firstFrameStart) firstFrameStart = frameStart;
+
+                // Input is sampled after the pacer's wait and sleep, so it is as fresh as the next refresh allows
+                if (framePacer) framePacer->beginFrame();
+                if (window) glfwPollEvents();
+
+                if (window && Graphics::Profiler::isEnabled()) {
+                    const bool traceKey = glfwGetKey(window, GLFW_KEY_F12) == GLFW_PRESS;
+                    if (traceKey && !traceKeyHeld) Graphics::Profiler::writeChromeTrace(profilerOutput);
+                    traceKeyHeld = traceKey;
+                }
+
+                Graphics::Camera2D camera;
+                camera.zoom = cameraZoom;
+                const float orbitRadius = cameraOrbitSpeed != 0.0f ? 0.5f : 0.0f;
+                camera.position[0] = orbitRadius * std::cos(cameraOrbitSpeed * static_cast<float>(framesRendered));
+                camera.position[1] = orbitRadius * std::sin(cameraOrbitSpeed * static_cast<float>(framesRendered));
+                renderer.setCamera(camera);
+                framesRendered++;
+
+                if (assetStreamer) assetStreamer->update();
+
+                if (offscreen) renderer.drawOffscreenFrame(device.getGraphicsQueue());
+                else {
+                    // The pacer has to see the frame before a recreation, its present id belongs to the old swapchain
+                    const bool outOfDate = renderer.drawFrame(device.getSwapChain(), device.getGraphicsQueue(), device.getPresentQueue());
+                    framePacer->frameFinished();
+                    if (outOfDate || framebufferResized) {
+                        framebufferResized = false;
+                        recreateSwapChain();
+                    }
+                }
+
+                if (benchmark) benchmark->frameFinished(renderer.getLastFrameTimings());
+                // An out-of-date swapchain may swallow the first attempts, the phase runs until one is presented
+                if (!startupTraceFinished && renderer.getPresentedFrames()) {
+                    startupTraceFinished = true;
+                    finishStartupTrace(*firstFrameStart);
+                }
+            };
+
+            // Everything a benchmark report says about the run itself, shared by the single and the record sweep report
+            auto buildReportContext = [&]() {
+                nlohmann::json context;
+                context["mode"] = mode;
+                context["device"] = device.getDeviceName();
+                context["framesInFlight"] = framesInFlight;
+                context["jobWorkers"] = jobSystem.getWorkerCount();
+                context["drawCount"] = drawCount;
+                context["instanceCount"] = instanceCount;
+                context["gpuCulling"] = gpuCulling;
+                context["asyncCompute"] = renderer.getAsyncCompute();
+                context["frameSync"] = renderer.getTimelineSemaphore() ? "timeline" : "fences";
+                context["renderGraph"] = renderGraphReport(renderer.getRenderGraphStats());
+                context["bindless"] = bindlessReport(renderer.getBindlessStats());
+                if (assetStreamer) context["assetStream"] = assetStreamReport(assetStreamer->getStats());
+                context["textures"] = textureReport(textureLoader.getStats());
+                context["startup"] = startupTrace.buildReport();
+                context["startup"]["deviceSelection"] = deviceSelectionReport(device.getSelection());
+                if (framePacer) context["latency"] = framePacer->buildReport();
+                if (!offscreen) {
+                    context["presentProfile"] = Graphics::presentProfileName(device.getPresentProfile());
+                    context["presentMode"] = Graphics::presentModeName(device.getPresentMode());
+                    context["swapChainImages"] = device.getSwapChainImageCount();
+                }
+                context["extent"] = {device.getSwapChainExtent().width, device.getSwapChainExtent().height};
+                return context;
+            };
+
+            if (benchmark && recordSweep) {
+                // Same scene once per thread count, the record phase speed-up is relative to a single worker
+                nlohmann::json passes = nlohmann::json::array();
+                for (uint32_t threads : recordSweepThreadCounts(recordThreads)) {
+                    renderer.setRecordThreads(device.getGraphicsQueueFamily(), threads);
+                    benchmark.emplace(benchmarkSettings.at("warmupFrames").get<uint32_t>(), benchmarkSettings.at("measuredFrames").get<uint32_t>());
+
+                    while (!benchmark->isFinished() && !(window && glfwWindowShouldClose(window))) renderFrame();
+                    vkDeviceWaitIdle(device.getLogicalDevice());
+
+                    passes.push_back(benchmark->buildReport({{"recordThreads", threads}, {"instanceCount", instanceCount}}));
+                    std::cout << "Record sweep: " << threads << " threads, record p50 " << passes.back()["cpuMs"]["record"].value("p50", 0.0) << " ms\n";
+                }
+
+                const double baselineRecordMs = passes.front()["cpuMs"]["record"].value("p50", 0.0);
+                for (auto& pass : passes) {
+                    const double recordMs = pass["cpuMs"]["record"].value("p50", 0.0);
+                    pass["recordSpeedup"] = recordMs > 0.0 ? baselineRecordMs / recordMs : 0.0;
+                }
+
+                nlohmann::json report = buildReportContext();
+                report["passes"] = passes;
+
+                const std::string output = benchmarkSettings.at("output").get<std::string>();
+                std::ofstream file(output);
+                if (!file.is_open()) throw std::runtime_error("failed to open benchmark report: " + output);
+                file << report.dump(4) << "\n";
+                benchmark.reset();
+            } else if (headless) {
+                const uint32_t frameCount = benchmark ? benchmark->getTotalFrames() : json.at("headless").at("frames").get<uint32_t>();
+                const auto start = std::chrono::steady_clock::now();
+
+                for (uint32_t frame = 0; frame < frameCount; frame++) renderFrame();
+                vkDeviceWaitIdle(device.getLogicalDevice());
+
+                const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+                std::cout << "Rendered " << frameCount << " " << mode << " frames in " << seconds << " s (" << frameCount / seconds << " fps, "
+                          << instanceCount * (frameCount / seconds) << " instances/s)\n";
+            } else {
+                while (!glfwWindowShouldClose(window) && !(benchmark && benchmark->isFinished())) renderFrame();
             }
 
             vkDeviceWaitIdle(device.getLogicalDevice());
+
+            if (gpuProfiler) {
+                // The device is idle, the frames still sitting in their slots can be read back as well
+                for (uint32_t slot = 0; slot < framesInFlight; slot++) gpuProfiler->collect(slot);
+            }
+            if (Graphics::Profiler::isEnabled() && profilerSettings.at("writeOnExit").get<bool>()) Graphics::Profiler::writeChromeTrace(profilerOutput);
+
+            if (framePacer) {
+                const nlohmann::json latency = framePacer->buildReport();
+                const nlohmann::json& displayMs = latency["inputToDisplayMs"];
+                if (displayMs.value("samples", 0) > 0) {
+                    std::cout << "Input-to-display latency (" << latency["method"].get<std::string>() << "): p50 " << displayMs["p50"].get<double>() << " ms, p99 "
+                              << displayMs["p99"].get<double>() << " ms, " << latency["missedFrames"].get<uint64_t>() << " missed refreshes\n";
+                }
+            }
+
+            if (benchmark) {
+                nlohmann::json context = buildReportContext();
+                context["recordThreads"] = recordThreads;
+                benchmark->writeReport(benchmarkSettings.at("output").get<std::string>(), context);
+            }
         }
 
-        glfwDestroyWindow(window);
-        glfwTerminate();
+        if (window) {
+            glfwDestroyWindow(window);
+            glfwTerminate();
+        }
 
     } catch (const std::exception& e) {
         std::cerr << e.what() << "\n";
@@ -75,4 +538,4 @@ int main() {
     }
 
     return 0;
-}
\ No newline at end of file
+}
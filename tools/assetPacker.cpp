@@ -0,0 +1,65 @@
+#include <algorithm>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "../src/graphics/assetPack.hpp"
+
+// Offline packer: AssetPacker <output.pak> <input>...
+// An input is a file or a directory, directories add every regular file below them. Entries are named by their path
+// relative to the directory they came from (the file name for plain files), "name=path" picks the name explicitly
+
+//------------------------------ASSET TYPE------------------------------
+Graphics::AssetType assetTypeFor(const std::filesystem::path& path) {
+    const std::string extension = path.extension().string();
+    if (extension == ".ktx2" || extension == ".dds") return Graphics::AssetType::Texture;
+    if (extension == ".mesh") return Graphics::AssetType::Mesh;
+    return Graphics::AssetType::Raw;
+}
+
+//------------------------------COLLECT SOURCES------------------------------
+void addSources(const std::string& arg, std::vector<Graphics::AssetPackSource>& sources) {
+    const size_t separator = arg.find('=');
+    if (separator != std::string::npos) {
+        const std::filesystem::path path = arg.substr(separator + 1);
+        sources.push_back({arg.substr(0, separator), assetTypeFor(path), path});
+        return;
+    }
+
+    const std::filesystem::path path = arg;
+    if (!std::filesystem::is_directory(path)) {
+        sources.push_back({path.filename().generic_string(), assetTypeFor(path), path});
+        return;
+    }
+
+    // Directory order is unspecified, sorting keeps packs reproducible
+    std::vector<std::filesystem::path> files;
+    for (const auto& entry : std::filesystem::recursive_directory_iterator(path)) {
+        if (entry.is_regular_file()) files.push_back(entry.path());
+    }
+    std::sort(files.begin(), files.end());
+    for (const auto& file : files) sources.push_back({std::filesystem::relative(file, path).generic_string(), assetTypeFor(file), file});
+}
+
+int main(int argc, char** argv) {
+    if (argc < 3) {
+        std::cerr << "usage: " << argv[0] << " <output.pak> <input | name=input>...\n";
+        return -1;
+    }
+
+    try {
+        std::vector<Graphics::AssetPackSource> sources;
+        for (int i = 2; i < argc; i++) addSources(argv[i], sources);
+
+        Graphics::writeAssetPack(argv[1], sources);
+
+        uint64_t bytes = 0;
+        for (const auto& source : sources) bytes += std::filesystem::file_size(source.path);
+        std::cout << "Packed " << sources.size() << " assets (" << bytes << " bytes) into " << argv[1] << "\n";
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << "\n";
+        return -1;
+    }
+
+    return 0;
+}
\ No newline at end of file